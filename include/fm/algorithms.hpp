@@ -0,0 +1,207 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+namespace toybasic {
+
+namespace Algorithms {
+    constexpr int OPERATORS = 6;
+    constexpr int COUNT = 32;
+}
+
+/**
+ * @brief Operator routing of one FM algorithm
+ *
+ * Operators are indexed 0-5 (operators 1-6 in the UI and docs). inputs[op]
+ * lists the operators whose outputs are summed, left to right, to modulate
+ * op; carriers lists the operators summed, left to right, into the voice
+ * output. Both lists end at the first NONE. The feedback operator is the
+ * one that may be fed its own previous output.
+ */
+struct AlgorithmTopology {
+    static constexpr int8_t NONE = -1;
+
+    std::array<std::array<int8_t, Algorithms::OPERATORS>, Algorithms::OPERATORS> inputs;
+    std::array<int8_t, Algorithms::OPERATORS> carriers;
+    int8_t feedback;
+
+    constexpr bool operator==(const AlgorithmTopology&) const = default;
+
+    constexpr bool isCarrier(int op) const {
+        for (int8_t carrier : carriers) {
+            if (carrier == op) return true;
+        }
+        return false;
+    }
+
+    constexpr bool modulates(int from, int to) const {
+        for (int8_t input : inputs[to]) {
+            if (input == from) return true;
+        }
+        return false;
+    }
+
+    constexpr bool isModulator(int op) const {
+        for (int to = 0; to < Algorithms::OPERATORS; to++) {
+            if (modulates(op, to)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Operators that contribute to the output, sources before targets
+     *
+     * Operators that no carrier depends on are left out, since their output
+     * would be discarded. Unused slots are NONE.
+     */
+    constexpr std::array<int8_t, Algorithms::OPERATORS> evaluationOrder() const {
+        std::array<bool, Algorithms::OPERATORS> used{};
+        std::array<int8_t, Algorithms::OPERATORS> pending{};
+        int pendingCount = 0;
+        for (int8_t carrier : carriers) {
+            if (carrier != NONE) pending[pendingCount++] = carrier;
+        }
+        while (pendingCount > 0) {
+            int op = pending[--pendingCount];
+            if (used[op]) continue;
+            used[op] = true;
+            for (int8_t input : inputs[op]) {
+                if (input != NONE) pending[pendingCount++] = input;
+            }
+        }
+
+        std::array<int8_t, Algorithms::OPERATORS> order{};
+        order.fill(NONE);
+        std::array<bool, Algorithms::OPERATORS> done{};
+        int count = 0;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (int op = Algorithms::OPERATORS - 1; op >= 0; op--) {
+                if (!used[op] || done[op]) continue;
+                bool ready = true;
+                for (int8_t input : inputs[op]) {
+                    if (input != NONE && !done[input]) ready = false;
+                }
+                if (ready) {
+                    order[count++] = static_cast<int8_t>(op);
+                    done[op] = true;
+                    progress = true;
+                }
+            }
+        }
+        return order;
+    }
+};
+
+/**
+ * @brief One modulation edge, using 1-based operator numbers as in the docs
+ */
+struct AlgorithmEdge {
+    int from;
+    int to;
+};
+
+/**
+ * @brief Build a topology from 1-based edges and carriers
+ *
+ * Edges into the same operator are summed in the order they are listed.
+ */
+constexpr AlgorithmTopology makeTopology(std::initializer_list<AlgorithmEdge> edges,
+                                         std::initializer_list<int> carriers, int feedback) {
+    AlgorithmTopology topology{};
+    for (auto& inputs : topology.inputs) {
+        inputs.fill(AlgorithmTopology::NONE);
+    }
+    topology.carriers.fill(AlgorithmTopology::NONE);
+
+    std::array<int, Algorithms::OPERATORS> inputCount{};
+    for (const AlgorithmEdge& edge : edges) {
+        topology.inputs[edge.to - 1][inputCount[edge.to - 1]++] = static_cast<int8_t>(edge.from - 1);
+    }
+    int carrierCount = 0;
+    for (int carrier : carriers) {
+        topology.carriers[carrierCount++] = static_cast<int8_t>(carrier - 1);
+    }
+    topology.feedback = static_cast<int8_t>(feedback - 1);
+    return topology;
+}
+
+/**
+ * @brief Routing of all 32 algorithms
+ *
+ * The single source of truth for the render kernels and for the operator
+ * graph widget. Algorithms 8 and 17-20 keep operators that reach no carrier
+ * (operator 3 in algorithm 8, operator 1 in 17-20); they are drawn but never
+ * evaluated.
+ */
+constexpr std::array<AlgorithmTopology, Algorithms::COUNT> ALGORITHMS = {{
+    makeTopology({{2, 1}, {3, 2}, {4, 3}, {5, 4}, {6, 5}}, {1}, 6),
+    makeTopology({{2, 1}, {3, 2}, {4, 3}, {5, 4}, {6, 4}}, {1}, 6),
+    makeTopology({{6, 1}, {3, 2}, {4, 3}, {5, 4}, {6, 5}}, {2, 1}, 6),
+    makeTopology({{2, 1}, {6, 2}, {4, 3}, {5, 4}, {6, 5}}, {3, 1}, 6),
+    makeTopology({{2, 1}, {3, 2}, {6, 3}, {5, 4}, {6, 5}}, {4, 1}, 6),
+    makeTopology({{2, 1}, {3, 2}, {4, 3}, {6, 4}, {6, 5}}, {5, 1}, 6),
+    makeTopology({{2, 1}, {6, 2}, {6, 3}, {5, 4}, {6, 5}}, {4, 3, 1}, 6),
+    makeTopology({{2, 1}, {6, 2}, {6, 3}, {6, 4}, {6, 5}}, {5, 4, 3, 1}, 6),
+    makeTopology({{4, 1}, {2, 1}, {5, 3}, {6, 5}}, {1}, 6),
+    makeTopology({{4, 1}, {3, 1}, {5, 4}, {6, 4}}, {1}, 6),
+    makeTopology({{3, 1}, {2, 1}, {4, 3}, {5, 3}, {6, 3}}, {1}, 6),
+    makeTopology({{3, 1}, {2, 1}, {4, 3}, {5, 3}, {6, 3}}, {1}, 6),
+    makeTopology({{2, 1}, {4, 1}, {3, 1}, {5, 2}, {6, 2}}, {1}, 6),
+    makeTopology({{2, 1}, {4, 1}, {3, 1}, {5, 2}, {6, 2}}, {1}, 6),
+    makeTopology({{3, 1}, {2, 1}, {5, 1}, {4, 3}, {6, 3}}, {1}, 6),
+    makeTopology({{3, 1}, {2, 1}, {5, 1}, {4, 3}, {6, 3}}, {1}, 6),
+    makeTopology({{4, 1}, {3, 1}, {2, 1}, {5, 4}, {6, 4}}, {1}, 6),
+    makeTopology({{2, 4}, {6, 4}, {4, 5}}, {5}, 6),
+    makeTopology({{3, 2}, {5, 2}, {6, 2}, {2, 4}}, {4}, 6),
+    makeTopology({{3, 2}, {6, 2}, {2, 4}, {5, 4}}, {4}, 6),
+    makeTopology({{2, 3}, {6, 3}, {3, 4}, {5, 4}}, {4}, 6),
+    makeTopology({{2, 3}, {6, 3}, {3, 4}, {5, 4}}, {4}, 6),
+    makeTopology({{1, 6}, {2, 6}, {3, 6}, {4, 6}, {5, 6}}, {6}, 6),
+    makeTopology({{1, 6}, {2, 6}, {3, 6}, {4, 6}, {5, 6}}, {6}, 6),
+    makeTopology({{1, 2}, {3, 4}, {5, 4}, {6, 4}}, {2, 4}, 6),
+    makeTopology({{1, 2}, {3, 4}, {5, 4}, {6, 4}}, {2, 4}, 6),
+    makeTopology({{1, 2}, {3, 2}, {6, 2}}, {2, 4, 5}, 6),
+    makeTopology({{1, 4}, {2, 4}, {3, 4}, {5, 4}}, {4, 6}, 6),
+    makeTopology({{1, 4}, {2, 4}, {3, 4}, {6, 4}}, {4, 5}, 6),
+    makeTopology({{1, 6}, {2, 6}, {3, 6}, {4, 6}, {5, 6}}, {6}, 6),
+    makeTopology({{1, 6}, {2, 6}, {3, 6}, {4, 6}, {5, 6}}, {6}, 6),
+    makeTopology({}, {1, 2, 3, 4, 5, 6}, 6),
+}};
+
+/**
+ * @brief Index of the first algorithm with the same routing
+ *
+ * Duplicate algorithms share one render kernel.
+ */
+constexpr int canonicalAlgorithm(int algorithm) {
+    for (int other = 0; other < algorithm; other++) {
+        if (ALGORITHMS[other] == ALGORITHMS[algorithm]) {
+            return other;
+        }
+    }
+    return algorithm;
+}
+
+}
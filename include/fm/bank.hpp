@@ -0,0 +1,104 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace toybasic {
+
+struct FMPresetConfig;
+
+/**
+ * @brief Read-only preset bank mapped straight from disk
+ *
+ * A bank file is a 64-byte Header followed by an array of FMPresetConfig
+ * records, exactly as they sit in memory, and a hashed name index. Opening
+ * a bank is a single mmap plus a validation pass; presets are then used in
+ * place with no per-preset allocation. Records are native-endian, and a
+ * bank written on a machine with a different byte order or record layout
+ * is rejected rather than byte-swapped.
+ *
+ * The name index is an open-addressed table of indexSlots entries, a power
+ * of two larger than the record count. Each entry is a record index plus
+ * one, with zero marking an empty slot; collisions probe linearly from
+ * hashName(name).
+ */
+class PresetBank {
+public:
+    static constexpr uint32_t MAGIC = 0x4B4E4253; /* "SBNK" */
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ENDIAN_TAG = 0x01020304;
+    
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t recordSize;
+        uint64_t recordCount;
+        uint64_t indexSlots;
+        uint64_t recordsOffset;
+        uint64_t indexOffset;
+        uint8_t reserved[16];
+    };
+    static_assert(sizeof(Header) == 64, "bank header is 64 bytes");
+    
+    PresetBank() = default;
+    explicit PresetBank(const std::string& path);
+    ~PresetBank();
+    
+    PresetBank(PresetBank&& other) noexcept;
+    PresetBank& operator=(PresetBank&& other) noexcept;
+    PresetBank(const PresetBank&) = delete;
+    PresetBank& operator=(const PresetBank&) = delete;
+    
+    bool isOpen() const { return mapping_ != nullptr; }
+    const FMPresetConfig* getRecords() const { return records_; }
+    size_t getRecordCount() const { return recordCount_; }
+    const uint32_t* getIndex() const { return index_; }
+    size_t getIndexSlots() const { return indexSlots_; }
+    
+    void close();
+    
+    static void write(const std::string& path, const FMPresetConfig* presets, size_t count);
+    
+    static uint32_t hashName(std::string_view name);
+    static std::vector<uint32_t> buildIndex(const FMPresetConfig* presets, size_t count);
+    static int findName(const FMPresetConfig* presets, const uint32_t* index, size_t indexSlots,
+                        std::string_view name);
+
+private:
+    void validate(const std::string& path) const;
+    
+    void* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+#if defined(_WIN32)
+    void* mappingHandle_ = nullptr;
+#endif
+    
+    const FMPresetConfig* records_ = nullptr;
+    size_t recordCount_ = 0;
+    const uint32_t* index_ = nullptr;
+    size_t indexSlots_ = 0;
+};
+
+}
@@ -0,0 +1,117 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace toybasic {
+
+/**
+ * @brief Maps steady-clock time onto frames of rendered audio
+ *
+ * The render thread stamps the start of every block with the block's first
+ * frame; input threads read the latest stamp to place an event on the audio
+ * timeline. The stamp is published under a sequence counter, so readers on
+ * any thread see a consistent frame, time, rate and period without ever
+ * making the render thread wait.
+ */
+class AudioClock {
+public:
+    /**
+     * @brief Record where the block about to be rendered starts (render thread only)
+     */
+    void stamp(uint64_t frame, uint64_t nanoseconds, int sampleRate, uint64_t period) {
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        frame_.store(frame, std::memory_order_relaxed);
+        nanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+        sampleRate_.store(sampleRate, std::memory_order_relaxed);
+        period_.store(period, std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Stop the clock at a frame while rendering is suspended (render thread only)
+     *
+     * Until the next stamp(), every time maps to that frame, so an event
+     * arriving while the renderer sleeps is placed one period after it
+     * resumes rather than as far ahead as the renderer has slept.
+     */
+    void pause(uint64_t frame, uint64_t nanoseconds) {
+        stamp(frame, nanoseconds, 0, period_.load(std::memory_order_relaxed));
+    }
+    
+    /**
+     * @brief The audio frame that corresponds to a steady-clock time (any thread)
+     *
+     * @param nanoseconds Time on the RenderTelemetry::now() clock
+     */
+    uint64_t frameAt(uint64_t nanoseconds) const {
+        return project(nanoseconds, false);
+    }
+    
+    /**
+     * @brief The frame an event arriving at a steady-clock time should play at (any thread)
+     *
+     * frameAt() of a live event usually falls inside the block that is
+     * already being played, so the event is placed one render period later.
+     * Every event is then delayed by the same period instead of being
+     * rounded up to the next block boundary, and the spacing between events
+     * is kept to the frame.
+     *
+     * @param nanoseconds Time on the RenderTelemetry::now() clock
+     */
+    uint64_t scheduleFrame(uint64_t nanoseconds) const {
+        return project(nanoseconds, true);
+    }
+
+private:
+    uint64_t project(uint64_t nanoseconds, bool delayed) const {
+        uint32_t before;
+        uint32_t after;
+        uint64_t frame;
+        uint64_t stamped;
+        int sampleRate;
+        uint64_t period;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            frame = frame_.load(std::memory_order_relaxed);
+            stamped = nanoseconds_.load(std::memory_order_relaxed);
+            sampleRate = sampleRate_.load(std::memory_order_relaxed);
+            period = period_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        
+        const double elapsed = (static_cast<double>(nanoseconds) - static_cast<double>(stamped)) * 1e-9;
+        const double position = static_cast<double>(frame) + elapsed * sampleRate;
+        const uint64_t result = position > 0.0 ? static_cast<uint64_t>(position) : 0;
+        return delayed ? result + period : result;
+    }
+    
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<uint64_t> frame_{0};
+    std::atomic<uint64_t> nanoseconds_{0};
+    std::atomic<int> sampleRate_{0};
+    std::atomic<uint64_t> period_{0};
+};
+
+}
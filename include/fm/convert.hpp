@@ -0,0 +1,80 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace toybasic {
+
+/* interleaved stereo sample formats an output device can be fed */
+enum class SampleFormat {
+    INT16 = 0,
+    INT32 = 1,
+    FLOAT32 = 2
+};
+
+const char* sampleFormatName(SampleFormat format);
+
+/**
+ * @brief Turns the engine's float output into a device sample format
+ *
+ * One block at a time, both channels are scaled, optionally passed through
+ * the emulated 14-bit DAC, dithered, rounded, clamped and interleaved in
+ * vector registers, so the device gets samples it can play as they are.
+ * Float32 and Int32 are written without dither since their resolution is
+ * far below the noise floor of the engine; Int16 gets TPDF dither when it
+ * is enabled. The DAC stage quantizes to the 14-bit range of the original
+ * hardware before the conversion, which then needs no dither because the
+ * 14-bit steps land exactly on the output grid.
+ *
+ * The format is fixed at construction. The stage switches may be flipped
+ * from any thread while convert() runs on the render thread.
+ */
+class SampleConverter {
+public:
+    explicit SampleConverter(SampleFormat format = SampleFormat::INT16);
+    
+    SampleFormat getFormat() const { return format_; }
+    size_t getBytesPerFrame() const { return 2 * bytesPerSample(format_); }
+    static size_t bytesPerSample(SampleFormat format);
+    
+    void setDither(bool enabled) { dither_.store(enabled, std::memory_order_relaxed); }
+    bool getDither() const { return dither_.load(std::memory_order_relaxed); }
+    void setDacEmulation(bool enabled) { dacEmulation_.store(enabled, std::memory_order_relaxed); }
+    bool getDacEmulation() const { return dacEmulation_.load(std::memory_order_relaxed); }
+    
+    void convert(const float* left, const float* right, size_t frames, void* interleaved);
+
+private:
+    template <typename Sample>
+    void convertFrames(const float* left, const float* right, size_t frames, Sample* interleaved,
+                       double scale, double minValue, double maxValue, bool dac, bool dither);
+    
+    uint32_t nextRandom();
+    
+    SampleFormat format_;
+    std::atomic<bool> dither_;
+    std::atomic<bool> dacEmulation_;
+    /* xorshift state for the dither; only touched by convert() */
+    uint32_t random_;
+};
+
+}
@@ -0,0 +1,67 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QIODevice>
+#include <array>
+
+#include "fm.hpp"
+#include "convert.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief Pull-mode audio device that renders on demand
+ *
+ * Handed to QAudioSink::start(QIODevice*). Whenever the sink needs more
+ * audio it calls readData(), which renders exactly the requested number of
+ * stereo frames from the render source in float and converts them to the
+ * sample format the sink was opened with. There is no intermediate queue
+ * and no polling thread, so latency is set entirely by the sink's buffer
+ * size. The only audio held back is a block prerolled before the sink
+ * resumes from suspension.
+ */
+class FMAudioDevice : public QIODevice {
+public:
+    FMAudioDevice(AudioRenderSource& source, SampleFormat format, QObject* parent = nullptr);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+    SampleConverter& getConverter() { return converter_; }
+    
+    void preroll();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    AudioRenderSource& source_;
+    SampleConverter converter_;
+    alignas(CACHE_LINE_SIZE) std::array<float, Constants::MAX_BLOCK_SIZE> left_;
+    alignas(CACHE_LINE_SIZE) std::array<float, Constants::MAX_BLOCK_SIZE> right_;
+    /* for sink buffers not aligned to the sample size */
+    alignas(CACHE_LINE_SIZE) std::array<int32_t, Constants::MAX_BLOCK_SIZE * 2> scratch_;
+    /* rendered by preroll(), handed out ahead of everything else */
+    alignas(CACHE_LINE_SIZE) std::array<int32_t, Constants::MAX_BLOCK_SIZE * 2> prerolled_;
+    size_t prerollOffset_ = 0;
+    size_t prerollBytes_ = 0;
+};
+}
@@ -0,0 +1,150 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "realtime.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief Stereo chorus on a mono send: one modulated fractional delay line
+ *
+ * The left and right outputs read the same line through taps swept a
+ * quarter of an LFO cycle apart, which widens the image as well as
+ * thickening it. The LFO is a rotating phasor, so the per-sample cost is a
+ * few multiplies and two interpolated reads.
+ */
+class StereoChorus {
+public:
+    static constexpr double RATE = 0.5;          /* LFO frequency in Hz */
+    static constexpr double DELAY = 0.020;       /* centre delay in seconds */
+    static constexpr double SWEEP = 0.0025;      /* swing either side of DELAY */
+    
+    StereoChorus();
+    
+    void setSampleRate(int sampleRate);
+    void reset();
+    void process(const double* input, double* left, double* right, size_t frames);
+    
+    size_t getTailFrames() const { return mask_ + 1; }
+    void lockBuffers(RealtimeStatus& status) const;
+
+private:
+    static size_t lineSize(int sampleRate);
+    
+    /* sized for the highest rate; the rate in use takes the first mask_ + 1 samples */
+    std::vector<double> line_;
+    size_t mask_ = 0;
+    size_t writePos_ = 0;
+    double delay_ = 0.0;
+    double sweep_ = 0.0;
+    /* LFO phasor and its per-sample rotation */
+    double lfoSin_ = 0.0;
+    double lfoCos_ = 1.0;
+    double rotateSin_ = 0.0;
+    double rotateCos_ = 1.0;
+};
+
+/**
+ * @brief Feedback delay network reverb on a mono send
+ *
+ * Eight delay lines of mutually prime lengths are mixed through a
+ * normalized Hadamard matrix; each line's loop gain gives every line the
+ * same decay time, and a one-pole lowpass in the loop makes the highs die
+ * first. Even lines feed the left output and odd lines the right.
+ */
+class FeedbackDelayReverb {
+public:
+    static constexpr int LINES = 8;
+    static constexpr double DECAY_TIME = 2.2;    /* seconds to fall 60 dB */
+    static constexpr double DAMPING = 0.35;      /* loop lowpass, 0 is none */
+    static constexpr double RETURN_GAIN = 0.5;
+    
+    FeedbackDelayReverb();
+    
+    void setSampleRate(int sampleRate);
+    void reset();
+    void process(const double* input, double* left, double* right, size_t frames);
+    
+    size_t getTailFrames() const { return tailFrames_; }
+    void lockBuffers(RealtimeStatus& status) const;
+
+private:
+    /* line lengths in seconds, before they are nudged to be mutually prime */
+    static constexpr std::array<double, LINES> LENGTHS = {
+        0.0297, 0.0331, 0.0379, 0.0413, 0.0457, 0.0499, 0.0539, 0.0593
+    };
+    static constexpr size_t NUDGE_MARGIN = 64;
+    
+    /* sized for the highest rate; the rate in use takes the first lengths_ samples */
+    std::array<std::vector<double>, LINES> lines_;
+    std::array<size_t, LINES> lengths_{};
+    std::array<size_t, LINES> positions_{};
+    std::array<double, LINES> feedback_{};
+    std::array<double, LINES> lowpass_{};
+    size_t tailFrames_ = 0;
+};
+
+/**
+ * @brief Send/return chorus and reverb for one stereo bus
+ *
+ * Sources add into the mono sends at their own send levels while the bus is
+ * mixed, then process() adds both returns to the bus once for the block,
+ * so the effects cost the same however many voices feed them. An effect
+ * with nothing sent keeps running only until its tail has died away and is
+ * skipped entirely after that. Every buffer is allocated by the constructor,
+ * long enough for the highest sample rate, so nothing else allocates and
+ * locked buffers stay locked across rate changes.
+ */
+class BusEffects {
+public:
+    static constexpr size_t MAX_FRAMES = 512;
+    
+    explicit BusEffects(int sampleRate);
+    
+    void setSampleRate(int sampleRate);
+    
+    void beginBlock();
+    void addSend(const double* left, const double* right, size_t frames,
+                 double leftGain, double rightGain, double chorus, double reverb, size_t offset = 0);
+    void process(double* left, double* right, size_t frames);
+    void lockBuffers(RealtimeStatus& status) const;
+
+private:
+    /* where an effect is in its life: sent to this block, ringing out, or off */
+    struct SendState {
+        bool sending = false;
+        size_t tailRemaining = 0;
+    };
+    
+    static bool shouldRun(SendState& state, size_t tailFrames, size_t frames);
+    
+    StereoChorus chorus_;
+    FeedbackDelayReverb reverb_;
+    SendState chorusState_;
+    SendState reverbState_;
+    std::array<double, MAX_FRAMES> chorusSend_{};
+    std::array<double, MAX_FRAMES> reverbSend_{};
+};
+
+}
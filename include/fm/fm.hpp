@@ -28,12 +28,22 @@
 #include <condition_variable>
 #include <mutex>
 #include <iostream>
-#include <queue>
-#include <QIODevice>
-#include <QAudioSink>
-#include <QAudioFormat>
-#include <QAudioDevice>
-#include <QMediaDevices>
+#include <utility>
+#include <limits>
+
+#include "ring.hpp"
+#include "clock.hpp"
+#include "simd.hpp"
+#include "algorithms.hpp"
+#include "pool.hpp"
+#include "effects.hpp"
+#include "telemetry.hpp"
+#include "scope.hpp"
+#include "idle.hpp"
+#include "realtime.hpp"
+#include "voices.hpp"
+#include "oversampling.hpp"
+#include "wavetable.hpp"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -57,6 +67,18 @@ public:
     virtual size_t availableSamples() const = 0;
 };
 
+/* anything an audio output can pull stereo blocks from: float at full
+   scale +-1.0 for devices, or 16-bit through the emulated DAC; a source
+   that goes idle when silent tells the output through its idle signal */
+class AudioRenderSource {
+public:
+    virtual ~AudioRenderSource() = default;
+    
+    virtual void renderBlock(float* left, float* right, size_t frames) = 0;
+    virtual void renderBlock(int16_t* interleaved, size_t frames) = 0;
+    virtual IdleSignal* getIdleSignal() { return nullptr; }
+};
+
 namespace Constants {
     constexpr double PI = M_PI;
     constexpr double TWO_PI = 2.0 * M_PI;
@@ -66,10 +88,23 @@ namespace Constants {
     constexpr int MAX_SAMPLE_RATE = 192000;
     constexpr int MIN_SAMPLE_RATE = 8000;
     
+    constexpr int SAMPLE_STREAM_CAPACITY = 16384;
+    constexpr int DEFAULT_BLOCK_SIZE = 256;
+    constexpr int MAX_BLOCK_SIZE = 512;
+    constexpr int MIN_BUFFER_FRAMES = 32;
+    constexpr int DEFAULT_BUFFER_FRAMES = 256;
+    constexpr int MAX_BUFFER_FRAMES = 4096;
+    constexpr int EVENT_QUEUE_CAPACITY = 1024;
+    
     constexpr int FREQ_PRECISION_BITS = 22;
     constexpr double FREQ_PRECISION_SCALE = 4194304.0;
     constexpr double FREQ_PRECISION_INV = 1.0 / FREQ_PRECISION_SCALE;
     
+    constexpr int SINE_TABLE_BITS = 10;
+    constexpr int SINE_TABLE_SIZE = 1 << SINE_TABLE_BITS;
+    constexpr int PHASE_FRACTION_BITS = 32 - SINE_TABLE_BITS;
+    constexpr double PHASE_UNITS_PER_RADIAN = 4294967296.0 / TWO_PI;
+    
     constexpr int AUDIO_BITS = 14;
     constexpr int AUDIO_MAX_VALUE = 8191;
     constexpr int AUDIO_MIN_VALUE = -8192;
@@ -78,8 +113,12 @@ namespace Constants {
     constexpr int MIDI_A4_NOTE = 69;
     constexpr double MIDI_A4_FREQUENCY = 440.0;
     constexpr int MIDI_NOTES_PER_OCTAVE = 12;
+    constexpr int MIDI_NOTE_COUNT = 128;
     
-    constexpr int MAX_VOICES = 16;
+    /* voice storage is sized for MAX_VOICES; setMaxVoices() picks how many play */
+    constexpr int MIN_VOICES = 1;
+    constexpr int DEFAULT_VOICES = 16;
+    constexpr int MAX_VOICES = 128;
     constexpr int MAX_OPERATORS = 6;
     constexpr int MAX_CHANNELS = 8;
     constexpr int MAX_ALGORITHMS = 32;
@@ -87,6 +126,12 @@ namespace Constants {
     
     constexpr double MIN_ENVELOPE_TIME = 0.001;
     constexpr double MAX_ENVELOPE_TIME = 10.0;
+    /* how long a stolen voice takes to fade out before its new note starts */
+    constexpr double VOICE_STEAL_FADE_TIME = 0.003;
+    /* a channel's pitch bend moves toward a new value with this time constant,
+       one step every MODULATION_STEP_FRAMES frames */
+    constexpr double PITCH_BEND_SMOOTHING_TIME = 0.01;
+    constexpr int MODULATION_STEP_FRAMES = 32;
     
     constexpr double MIN_VOLUME = 0.0;
     constexpr double MAX_VOLUME = 1.0;
@@ -99,11 +144,14 @@ namespace Constants {
     constexpr double CHORUS_FREQUENCY = 0.5;
     constexpr double CHORUS_DEPTH = 0.1;
     constexpr double REVERB_GAIN = 0.3;
+    constexpr double MAX_FEEDBACK_DEPTH = PI;
     
     constexpr double PAN_LEFT = -0.5;
     constexpr double PAN_CENTER = 0.0;
     constexpr double PAN_RIGHT = 0.5;
     constexpr double PAN_SCALE = 0.5;
+    constexpr double MIN_MIXER_PAN = -1.0;
+    constexpr double MAX_MIXER_PAN = 1.0;
 }
 
 enum class EnvelopeState : int {
@@ -204,71 +252,108 @@ enum class WaveformType {
     TRIANGLE = 3
 };
 
+enum class OscillatorMode {
+    FLOATING_POINT = 0,
+    FIXED_POINT = 1
+};
+
+/**
+ * @brief One control change queued from the control thread to the renderer
+ *
+ * Plain data so it can travel through an SPSCRingBuffer. target is the
+ * channel or voice the event applies to, index the note, operator or
+ * algorithm, and values hold whatever numbers the event carries.
+ */
+struct SynthEvent {
+    enum class Type : uint8_t {
+        NOTE_ON,
+        NOTE_OFF,
+        ALL_NOTES_OFF,
+        CHANNEL_ACTIVE,
+        ALGORITHM,
+        FEEDBACK,
+        PITCH_BEND,
+        MODULATION_WHEEL,
+        MASTER_VOLUME,
+        REVERB,
+        CHORUS,
+        DISTORTION,
+        OPERATOR_FREQUENCY,
+        OPERATOR_AMPLITUDE,
+        OPERATOR_MODULATION_INDEX,
+        OPERATOR_WAVEFORM,
+        ENVELOPE,
+        PRESET,
+        VOICE_LIMIT,
+        SAMPLE_RATE
+    };
+    
+    Type type;
+    int32_t target;
+    int32_t index;
+    std::array<double, 4> values;
+    /* audio clock frame the event is due at; 0 plays it at the next block */
+    uint64_t frame = 0;
+};
+
 
 class FMSampleStream : public AudioSampleStream {
 public:
-    FMSampleStream() = default;
+    explicit FMSampleStream(size_t capacity = Constants::SAMPLE_STREAM_CAPACITY)
+        : samples_(capacity), waitMode_(false) {}
+    
+    void setWaitMode(bool wait) { waitMode_.store(wait, std::memory_order_relaxed); }
+    bool getWaitMode() const { return waitMode_.load(std::memory_order_relaxed); }
     
     bool readSample(int16_t& sample) override {
-        std::unique_lock<std::mutex> lock(mutex_);
-        while (samples_.empty()) {
-            condition_.wait(lock);
+        while (!samples_.pop(sample)) {
+            if (!getWaitMode()) {
+                return false;
+            }
+            samples_.waitForData();
         }
-        sample = samples_.front();
-        samples_.pop();
         return true;
     }
     
     size_t readSamples(int16_t* buffer, size_t count) override {
-        std::unique_lock<std::mutex> lock(mutex_);
-        size_t samplesRead = 0;
-        while (samplesRead < count && !samples_.empty()) {
-            buffer[samplesRead] = samples_.front();
-            samples_.pop();
-            samplesRead++;
-        }
-        return samplesRead;
+        return samples_.read(buffer, count);
     }
     
     bool writeSample(int16_t sample) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        samples_.push(sample);
-        condition_.notify_all();
-        return true;
+        return samples_.push(sample);
     }
     
     size_t writeSamples(const int16_t* buffer, size_t count) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (size_t i = 0; i < count; i++) {
-            samples_.push(buffer[i]);
-        }
-        condition_.notify_all();
-        return count;
+        return samples_.write(buffer, count);
     }
     
     bool hasData() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         return !samples_.empty();
     }
     
     size_t availableSamples() const override {
-        std::lock_guard<std::mutex> lock(mutex_);
         return samples_.size();
     }
     
+    size_t capacity() const { return samples_.capacity(); }
+    void lockBuffers(RealtimeStatus& status) const {
+        lockMemory(status, samples_.storage(), samples_.capacity() * sizeof(int16_t));
+    }
+    
 private:
-    std::queue<int16_t> samples_;
-    mutable std::mutex mutex_;
-    std::condition_variable condition_;
+    SPSCRingBuffer<int16_t> samples_;
+    std::atomic<bool> waitMode_;
 };
 
-class FMSynthesizer {
+class FMSynthesizer : public AudioRenderSource {
+    friend class FMSynthesizerManager;
+    
 public:
     FMSynthesizer(int sampleRate = 44100);
     
     ~FMSynthesizer();
     
-    void noteOn(int note, double velocity = 1.0); // XXX steals voice 0 if no voices are free?
+    void noteOn(int note, double velocity = 1.0);
     void noteOff(int note);
     void allNotesOff();
     
@@ -281,6 +366,8 @@ public:
     void setOperatorWaveform(int voice, int opIndex, WaveformType waveform);
     
     void setAlgorithm(int channel, int algorithm);
+    void setFeedback(int channel, double amount);
+    double getFeedback(int channel) const;
     
     void setEnvelope(int voice, int opIndex, double attack, double decay, 
                     double sustain, double release);
@@ -292,10 +379,21 @@ public:
     void stopAudioThread();
     void setSampleStream(AudioSampleStream* stream);
     bool isAudioThreadRunning() const;
+    void setRealtimeMode(const RealtimeConfig& config);
+    const RealtimeStatus& getRealtimeStatus() const { return realtimeStatus_; }
+    
+    int getSampleRate() const { return controlSampleRate_; }
     
     void generateSamples(AudioSampleStream& stream);
     
-    std::array<double, 6> getOperatorOutputs() const;
+    void renderBlock(float* left, float* right, size_t frames) override;
+    void renderBlock(int16_t* interleaved, size_t frames) override;
+    
+    RenderTelemetry& getTelemetry() { return telemetry_; }
+    const AudioClock& getClock() const { return clock_; }
+    IdleSignal* getIdleSignal() override { return &idle_; }
+    
+    bool postInputEvent(const SynthEvent& event);
     
     
     void setPitchBend(int channel, double bend);
@@ -319,6 +417,15 @@ public:
     
     double calculatePhaseIncrement22Bit(double frequency);
     
+    void setOscillatorMode(OscillatorMode mode);
+    OscillatorMode getOscillatorMode() const;
+    
+    void setOversampling(int factor);
+    int getOversampling() const;
+    
+    void setVoiceStealPolicy(VoiceStealPolicy policy);
+    VoiceStealPolicy getVoiceStealPolicy() const;
+    
     int getFreqPrecisionBits() const { return freqPrecisionBits_; }
     void setFreqPrecisionBits(int bits);
     double getFreqPrecisionScale() const { return freqPrecisionScale_; }
@@ -383,10 +490,19 @@ public:
     void setPanScale(double scale);
 
 private:
+    static constexpr int LANE_GROUPS = Constants::MAX_VOICES / static_cast<int>(simd::LANES);
+    static_assert(Constants::MAX_VOICES % simd::LANES == 0, "voices must fill whole lane groups");
+    
+    /* voices rendered by one pool task; a multiple of the voices per cache
+       line in every lane array, so concurrent tasks never share a line */
+    static constexpr int VOICES_PER_SLICE = static_cast<int>(CACHE_LINE_SIZE / sizeof(int32_t));
+    static constexpr int VOICE_SLICES = Constants::MAX_VOICES / VOICES_PER_SLICE;
+    static constexpr int GROUPS_PER_SLICE = VOICES_PER_SLICE / static_cast<int>(simd::LANES);
+    static_assert(Constants::MAX_VOICES % VOICES_PER_SLICE == 0, "voices must fill whole render slices");
+    
+    /* per-voice operator configuration; read at note on and by the envelope */
     struct Operator {
         double frequency = 440.0;
-        double amplitude = 0.5;
-        double modulationIndex = 1.0;
         WaveformType waveform = WaveformType::SINE;
         
         double attack = 0.01;
@@ -394,20 +510,51 @@ private:
         double sustain = 0.7;
         double release = 0.3;
         
-        int envelopeState = static_cast<int>(EnvelopeState::OFF);
-        
-        double envelopeLevel = 0.0;
-        double envelopeTime = 0.0;
-        
-        double phaseAccumulator = 0.0;
-        double phaseIncrement = 0.0;
+        /* per-sample envelope steps, refreshed whenever the times above change */
+        double attackRate = 0.0;
+        double decayRate = 0.0;
+        int releaseSamples = 1;
+    };
+    
+    /*
+     * Render-time state of one operator slot for every voice. Voice v lives
+     * at index v of each array, so operator N of a lane group of voices is a
+     * single aligned vector load.
+     */
+    struct OperatorLanes {
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> phaseAccumulator;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> phaseIncrement;
+        /* phaseIncrement times the channel's pitch bend, refreshed by updatePhaseStep() */
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> bentIncrement;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> amplitude;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> modulationIndex;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> envelopeLevel;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> envelopeRate;
+        std::array<int, Constants::MAX_VOICES> envelopeRemaining;
+        std::array<int, Constants::MAX_VOICES> envelopeState;
         
-        static constexpr double FREQ_PRECISION_SCALE = 4194304.0;
-        static constexpr double FREQ_PRECISION_INV = 1.0 / FREQ_PRECISION_SCALE;
+        /* fixed-point oscillator: one full cycle is 2^32, so wrapping is free */
+        alignas(CACHE_LINE_SIZE) std::array<uint32_t, Constants::MAX_VOICES> phase;
+        alignas(CACHE_LINE_SIZE) std::array<uint32_t, Constants::MAX_VOICES> phaseStep;
         
-        double pitchBend = 1.0;
-        double modulationWheel = 0.0;
-        double velocity = 1.0;
+        /* band-limited table level for the current frequency */
+        alignas(CACHE_LINE_SIZE) std::array<int, Constants::MAX_VOICES> wavetableLevel;
+    };
+    
+    /* previous outputs of each voice's feedback operator */
+    struct FeedbackLanes {
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> level;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> previous;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_VOICES> previous2;
+    };
+    
+    /* per-block view of one lane group handed to the algorithm kernels */
+    struct LaneGroup {
+        int firstVoice;
+        unsigned kernelLanes;
+        unsigned silentOperators;
+        bool fixedPoint;
+        std::array<std::array<unsigned, 4>, Constants::MAX_OPERATORS> waveformLanes;
     };
     
     struct Voice {
@@ -416,21 +563,42 @@ private:
         int note = -1;
         double velocity = 1.0;
         int channel = 0;
+        /* the channel's algorithm when the note started */
+        int algorithm = 0;
+        /* note to start once the voice has faded out after being stolen */
+        int pendingNote = -1;
+        double pendingVelocity = 0.0;
     };
     
     struct Channel {
         bool active = false;
         int algorithm = 0;
         double masterVolume = 1.0;
+        /* bend ratio last asked for */
         double pitchBend = 1.0;
+        /* bend ratio the voices play at, moved toward pitchBend by advancePitchBends() */
+        double appliedPitchBend = 1.0;
         double modulationWheel = 0.0;
+        double feedback = 0.0;
     };
     
-    std::array<Voice, Constants::MAX_VOICES> voices_;
+    alignas(CACHE_LINE_SIZE) std::array<Voice, Constants::MAX_VOICES> voices_;
+    std::array<OperatorLanes, Constants::MAX_OPERATORS> lanes_;
+    FeedbackLanes feedback_;
+    VoiceDecimator<Constants::MAX_VOICES> decimator_;
+    /* fetched at construction so the tables are never built on the audio thread */
+    const BandLimitedWavetables& wavetables_ = BandLimitedWavetables::get();
     std::array<Channel, Constants::MAX_CHANNELS> channels_;
+    /* bit c is set while channel c's applied pitch bend is still moving */
+    unsigned rampingChannels_ = 0;
+    /* fraction of the remaining bend covered by each modulation step */
+    double pitchBendSmoothing_;
+    /* relative distance at which a ramping bend snaps to its target */
+    static constexpr double PITCH_BEND_SETTLED = 1e-6;
     int sampleRate_;
     double masterVolume_;
-    double timeStep_;
+    /* the rate last passed to setSampleRate(); control thread only */
+    int controlSampleRate_;
     
     int freqPrecisionBits_;
     double freqPrecisionScale_;
@@ -464,25 +632,71 @@ private:
     double panRight_;
     double panScale_;
     
-    struct PresetConfig {
-        std::array<double, Constants::MAX_OPERATORS> frequencies;
+    /*
+     * A preset compiled for the current sample rate. playNote() copies the
+     * operators as one block and only scales their frequency by the note;
+     * every envelope step is already worked out. Immutable once published.
+     */
+    struct alignas(CACHE_LINE_SIZE) VoiceTemplate {
+        /* frequency holds the ratio to the note frequency */
+        std::array<Operator, Constants::MAX_OPERATORS> operators;
         std::array<double, Constants::MAX_OPERATORS> amplitudes;
         std::array<double, Constants::MAX_OPERATORS> modulationIndices;
-        std::array<WaveformType, Constants::MAX_OPERATORS> waveforms;
-        std::array<double, Constants::MAX_OPERATORS> attacks;
-        std::array<double, Constants::MAX_OPERATORS> decays;
-        std::array<double, Constants::MAX_OPERATORS> sustains;
-        std::array<double, Constants::MAX_OPERATORS> releases;
+        /* length of the attack segment from silence */
+        std::array<int, Constants::MAX_OPERATORS> attackSamples;
+        /* the rate the steps were worked out for */
+        int sampleRate;
     };
-    PresetConfig currentPreset_;
+    
+    /* at most one template is in flight per control-thread call, so a few slots suffice */
+    static constexpr size_t RETIRED_PRESET_CAPACITY = 4;
+    
+    /* the template new notes are built from; owned by the render thread */
+    VoiceTemplate* preset_;
+    /* published by setPresetConfig(), taken by the renderer at its PRESET event */
+    std::atomic<VoiceTemplate*> pendingPreset_;
+    /* templates the renderer swapped out, freed by the control thread */
+    SPSCRingBuffer<VoiceTemplate*> retiredPresets_;
+    
+    /* noteToFrequency22Bit() of every MIDI note */
+    std::array<double, Constants::MIDI_NOTE_COUNT> noteFrequencies_;
+    
+    SPSCRingBuffer<SynthEvent> events_;
+    /* events from one real-time input thread (MIDI), independent of the control thread */
+    SPSCRingBuffer<SynthEvent> inputEvents_;
+    /* the first input event that is not due yet, taken off the queue early */
+    SynthEvent heldEvent_{};
+    bool hasHeldEvent_ = false;
+    /* parks this synthesizer's renderer when it plays on its own */
+    IdleSignal idle_;
+    /* notified after every queued event: idle_, or the manager's while registered */
+    std::atomic<IdleSignal*> wakeSignal_;
+    
+    AudioClock clock_;
+    /* frames rendered so far, the audio clock's position; render thread only */
+    uint64_t renderedFrames_ = 0;
     
     double reverbAmount_;
     double chorusAmount_;
     double distortionAmount_;
     
+    /* requested by setOscillatorMode(), picked up by the renderer each block */
+    std::atomic<OscillatorMode> oscillatorMode_;
+    OscillatorMode renderOscillatorMode_;
+    /* requested by setOversampling(), picked up by the renderer each block */
+    std::atomic<int> oversampling_{1};
+    int renderOversampling_ = 1;
+    
+    std::atomic<VoiceStealPolicy> stealPolicy_;
+    VoiceAllocator<Constants::MAX_VOICES, Constants::MAX_CHANNELS> allocator_;
+    
     std::thread audioThread_;
     std::atomic<bool> audioThreadRunning_;
     std::atomic<bool> shouldStop_;
+    /* applied by the audio thread to itself as it starts */
+    RealtimeConfig realtimeConfig_;
+    RealtimeStatus realtimeStatus_;
+    std::atomic<bool> audioThreadReady_{false};
     
     std::vector<int16_t> sampleBuffer_;
     std::mutex bufferMutex_;
@@ -490,52 +704,116 @@ private:
     std::atomic<size_t> bufferReadPos_;
     static constexpr size_t BUFFER_SIZE = 4096;
     
-    void updateOperatorPhase(Operator& op);
-    void updateEnvelope(Operator& op);
-    double generateOperatorOutput(Operator& op, double modulation = 0.0);
-    double applyEffects(double sample, int channel);
-    
-    double processAlgorithm0(Voice& voice);
-    double processAlgorithm1(Voice& voice);
-    double processAlgorithm2(Voice& voice);
-    double processAlgorithm3(Voice& voice);
-    double processAlgorithm4(Voice& voice);
-    double processAlgorithm5(Voice& voice);
-    double processAlgorithm6(Voice& voice);
-    double processAlgorithm7(Voice& voice);
-    double processAlgorithm8(Voice& voice);
-    double processAlgorithm9(Voice& voice);
-    double processAlgorithm10(Voice& voice);
-    double processAlgorithm11(Voice& voice);
-    double processAlgorithm12(Voice& voice);
-    double processAlgorithm13(Voice& voice);
-    double processAlgorithm14(Voice& voice);
-    double processAlgorithm15(Voice& voice);
-    double processAlgorithm16(Voice& voice);
-    double processAlgorithm17(Voice& voice);
-    double processAlgorithm18(Voice& voice);
-    double processAlgorithm19(Voice& voice);
-    double processAlgorithm20(Voice& voice);
-    double processAlgorithm21(Voice& voice);
-    double processAlgorithm22(Voice& voice);
-    double processAlgorithm23(Voice& voice);
-    double processAlgorithm24(Voice& voice);
-    double processAlgorithm25(Voice& voice);
-    double processAlgorithm26(Voice& voice);
-    double processAlgorithm27(Voice& voice);
-    double processAlgorithm28(Voice& voice);
-    double processAlgorithm29(Voice& voice);
-    double processAlgorithm30(Voice& voice);
-    double processAlgorithm31(Voice& voice);
+    /* distortion is an insert on every voice; chorus and reverb are send
+       levels into the bus effects */
+    struct BlockEffects {
+        bool distortion;
+        double distortionDrive;
+        double chorusSend;
+        double reverbSend;
+    };
+    
+    static_assert(Algorithms::OPERATORS == Constants::MAX_OPERATORS, "algorithm tables must cover every operator");
+    static_assert(Algorithms::COUNT == Constants::MAX_ALGORITHMS, "algorithm tables must cover every algorithm");
+    
+    using AlgorithmFunction = simd::Vec (FMSynthesizer::*)(const LaneGroup&);
+    using AlgorithmTable = std::array<std::array<AlgorithmFunction, 2>, Constants::MAX_ALGORITHMS>;
+    static const AlgorithmTable ALGORITHM_TABLE;
+    
+    template <int Algorithm, bool Feedback>
+    simd::Vec processAlgorithm(const LaneGroup& group);
+    
+    template <size_t... Algorithm>
+    static constexpr AlgorithmTable makeAlgorithmTable(std::index_sequence<Algorithm...>);
+    
+    BlockEffects blockEffects_;
+    /* lane groups with a voice playing this block in ascending order; the
+       groups of slice s are activeGroups_[sliceGroups_[s]] up to sliceGroups_[s + 1] */
+    std::array<int16_t, LANE_GROUPS> activeGroups_;
+    std::array<int16_t, VOICE_SLICES + 1> sliceGroups_;
+    std::array<double, Constants::MAX_BLOCK_SIZE> mixLeft_;
+    std::array<double, Constants::MAX_BLOCK_SIZE> mixRight_;
+    std::array<int16_t, Constants::MAX_BLOCK_SIZE * 2> blockSamples_;
+    /* used when this synthesizer renders on its own; a manager mixes the
+       sends into its own bus effects instead */
+    BusEffects busEffects_;
+    static_assert(Constants::MAX_BLOCK_SIZE <= BusEffects::MAX_FRAMES, "bus effects must hold a whole block");
+    
+    void updateOperatorPhases(const LaneGroup& group, unsigned activeLanes);
+    void updatePhaseStep(int opIndex, int voice);
+    void convertOscillatorPhases(OscillatorMode mode);
+    void applyOversampling(int factor);
+    simd::Vec renderCoreSample(LaneGroup& group, const AlgorithmFunction* algorithms,
+                               const unsigned* algorithmLanes, size_t algorithmCount, unsigned activeLanes);
+    /* samples left in a segment that never ends on its own (sustain, off) */
+    static constexpr int ENVELOPE_HOLD = std::numeric_limits<int>::max();
+    
+    void updateEnvelopeRates(int voice, int opIndex);
+    static void computeEnvelopeRates(Operator& op, int sampleRate);
+    static void compileVoiceTemplate(VoiceTemplate& preset, int sampleRate);
+    void enterEnvelopeSegment(int voice, int opIndex, EnvelopeState state);
+    void advanceEnvelopeLevels(const LaneGroup& group, unsigned activeLanes);
+    unsigned finishEnvelopeSegments(int firstVoice, unsigned activeLanes, int elapsed);
+    int nextEnvelopeEvent(int firstVoice, unsigned activeLanes) const;
+    unsigned findSilentOperators(int firstVoice, unsigned activeLanes) const;
+    simd::Vec generateOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec modulation);
+    simd::Vec generateOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec modulation, simd::Vec phaseOffset);
+    simd::Vec generateOperatorOutputAtPhase(const LaneGroup& group, int opIndex, simd::Vec phase);
+    simd::Vec generateFixedOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec phaseOffset);
+    static double generateFixedWaveform(WaveformType waveform, uint32_t phase);
+    
+    using SineTable = std::array<int32_t, Constants::SINE_TABLE_SIZE + 1>;
+    static const SineTable SINE_TABLE;
+    simd::Vec feedbackPhase(const LaneGroup& group) const;
+    void updateFeedback(const LaneGroup& group, simd::Vec output);
+    static double feedbackLevel(double amount);
+    simd::Vec generateWaveform(WaveformType waveform, const OperatorLanes& lanes, int voice, simd::Vec phase) const;
+    BlockEffects prepareEffects() const;
+    simd::Vec applyEffects(simd::Vec sample, const BlockEffects& effects) const;
+    
+    void mixBlock(size_t frames);
+    void stampClock(size_t frames);
+    size_t beginBlock(size_t frames);
+    size_t framesUntilHandover(size_t frames) const;
+    size_t framesUntilModulationStep(size_t frames) const;
+    void advancePitchBends();
+    static double pitchBendSmoothing(int sampleRate);
+    void endBlock(size_t frames);
+    void measureOperatorLevels(std::array<float, Constants::MAX_OPERATORS>& levels) const;
+    
+    void postEvent(SynthEvent::Type type, int target = 0, int index = 0,
+                   std::array<double, 4> values = {});
+    bool hasPendingWork() const;
+    void pauseClock();
+    void processEvents();
+    void applyEvent(const SynthEvent& event);
+    void startNote(int channel, int note, double velocity);
+    void releaseNote(int channel, int note);
+    void releaseAllNotes();
+    void applyPitchBend(int channel, double bend);
+    void applyFeedback(int channel, double amount);
+    void swapPreset();
+    void freeRetiredPresets();
+    void applySampleRate(int sampleRate);
+    
+    void collectActiveGroups();
+    bool isVoiceSliceActive(int slice) const;
+    void renderVoiceSlice(int slice, size_t frames, double* left, double* right);
+    void renderLaneGroup(int group, size_t frames, double* left, double* right);
+    
     
     void initializePresets();
     
-    int findFreeVoice();
+    void playNote(int voice, int note, double velocity);
     void releaseVoice(int voice);
-    
-    void updateOperatorPhase22Bit(Operator& op);
+    void fadeOutVoice(int voice);
+    void reclaimVoices();
+    void applyVoiceLimit(int voices);
+    int chooseVoiceToSteal(VoiceStealPolicy policy) const;
+    double voiceLevel(int voice) const;
     
     void audioThreadFunction();
+    void lockBuffers(RealtimeStatus& status) const;
     
     void generateSample(int16_t& left, int16_t& right);
     
@@ -543,20 +821,40 @@ private:
     
     AudioSampleStream* externalStream_ = nullptr;
     
-    QIODevice* audioIODevice_;
-    QAudioSink* audioSink_;
-    
-    void setupAudio();
+    RenderTelemetry telemetry_;
+    /* voices playing in the current block, counted by beginBlock() */
+    int activeVoiceCount_ = 0;
+    /* the previous block was written to the stream, so an empty stream is an underrun */
+    bool streaming_ = false;
 };
 
-class FMSynthesizerManager {
+class FMSynthesizerManager : public AudioRenderSource {
 public:
-    FMSynthesizerManager(int sampleRate = 44100);
+    FMSynthesizerManager(int sampleRate = 44100, int workerThreads = -1);
     ~FMSynthesizerManager();
     
     void addSynthesizer(std::shared_ptr<FMSynthesizer> synth);
     void removeSynthesizer(std::shared_ptr<FMSynthesizer> synth);
     
+    size_t getSynthesizerCount() const { return synthesizers_.size(); }
+    
+    void renderBlock(float* left, float* right, size_t frames) override;
+    void renderBlock(int16_t* interleaved, size_t frames) override;
+    size_t getWorkerCount() const { return pool_.getWorkerCount(); }
+    IdleSignal* getIdleSignal() override { return &idle_; }
+    
+    RealtimeStatus setRealtimeMode(const RealtimeConfig& config);
+    RealtimeStatus getRealtimeStatus() const;
+    
+    RenderTelemetry& getTelemetry() { return telemetry_; }
+    ScopeTap& getScopeTap() { return scope_; }
+    RenderStatistics collectStatistics();
+    
+    void setSynthesizerGain(size_t index, double gain);
+    double getSynthesizerGain(size_t index) const;
+    void setSynthesizerPan(size_t index, double pan);
+    double getSynthesizerPan(size_t index) const;
+    
     
     void setMasterVolume(double volume);
     void setSampleRate(int sampleRate);
@@ -570,9 +868,36 @@ public:
     void setGlobalDistortion(double amount);
 
 private:
+    /*
+     * Gain and pan of one synthesizer on the shared bus, pan from -1 (left)
+     * to 1 (right). Set from the control thread and read once per span by
+     * the render thread; copied only by addSynthesizer() and
+     * removeSynthesizer(), which must not run while rendering anyway.
+     */
+    struct MixerStrip {
+        std::atomic<double> gain;
+        std::atomic<double> pan;
+        
+        MixerStrip(double gain, double pan) : gain(gain), pan(pan) {}
+        MixerStrip(const MixerStrip& other)
+            : gain(other.gain.load(std::memory_order_relaxed)), pan(other.pan.load(std::memory_order_relaxed)) {}
+        MixerStrip& operator=(const MixerStrip& other) {
+            gain.store(other.gain.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            pan.store(other.pan.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+    
     std::vector<std::shared_ptr<FMSynthesizer>> synthesizers_;
+    std::vector<MixerStrip> strips_;
     int sampleRate_;
-    double masterVolume_;
+    std::atomic<double> masterVolume_;
+    /* masterVolume_ as latched by mixBlock() for the block (render thread only) */
+    double blockVolume_;
+    /* the rate last passed to setSampleRate(); control thread only */
+    int controlSampleRate_;
+    /* set by setSampleRate(), taken by the next renderBlock(); 0 if none */
+    std::atomic<int> pendingSampleRate_{0};
     
     double globalReverb_;
     double globalChorus_;
@@ -581,6 +906,52 @@ private:
     std::array<double, Constants::MAX_MIDI_CHANNELS> channelVolumes_;
     std::array<double, Constants::MAX_MIDI_CHANNELS> channelPitchBends_;
     std::array<double, Constants::MAX_MIDI_CHANNELS> channelModulations_;
+    
+    /* one voice slice of one synthesizer, rendered into its own scratch bus */
+    struct RenderTask {
+        FMSynthesizer* synth;
+        int slice;
+        double leftGain;
+        double rightGain;
+        double chorusSend;
+        double reverbSend;
+    };
+    
+    struct ScratchBus {
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_BLOCK_SIZE> left;
+        alignas(CACHE_LINE_SIZE) std::array<double, Constants::MAX_BLOCK_SIZE> right;
+    };
+    
+    static void renderTask(void* context, size_t task);
+    void stampClocks(size_t frames);
+    void promoteRenderThread();
+    void applySampleRate();
+    void mixBlock(size_t frames);
+    size_t mixSpan(size_t offset, size_t frames);
+    void reserveRenderTasks();
+    bool hasPendingWork() const;
+    
+    RenderWorkerPool pool_;
+    std::vector<RenderTask> tasks_;
+    std::vector<ScratchBus> scratch_;
+    size_t taskCount_;
+    size_t blockFrames_;
+    std::array<double, Constants::MAX_BLOCK_SIZE> mixLeft_;
+    std::array<double, Constants::MAX_BLOCK_SIZE> mixRight_;
+    BusEffects effects_;
+    IdleSignal idle_;
+    /* what setRealtimeMode() got for the workers and the locked memory */
+    RealtimeStatus realtimeStatus_;
+    /* applied by the next renderBlock() to the thread calling it */
+    RealtimeConfig realtimeConfig_;
+    std::atomic<bool> promoteRenderThread_{false};
+    /* written by that renderBlock() before renderThreadPromoted_ is set */
+    RealtimeStatus renderThreadStatus_;
+    std::atomic<bool> renderThreadPromoted_{false};
+    
+    RenderTelemetry telemetry_;
+    /* post-mix output for monitoring, fed at the end of every block */
+    ScopeTap scope_;
 };
 
 }
\ No newline at end of file
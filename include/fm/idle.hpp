@@ -0,0 +1,137 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace toybasic {
+
+/**
+ * @brief Lets a renderer sleep through silence until the next event arrives
+ *
+ * The render thread feeds every block through trackSilence(). Once nothing
+ * is playing or queued and the output has stayed below SILENCE_THRESHOLD
+ * for TAIL_TIME, long enough for every effect delay line to have been read
+ * out, the renderer parks. A thread of its own then blocks in wait(); a
+ * renderer driven by an audio device instead tells the device through the
+ * state function, which may suspend the stream. Every thread that queues
+ * an event calls notify() afterwards, which un-parks the renderer. While
+ * the renderer is awake, notify() costs a fence and a relaxed load.
+ */
+class IdleSignal {
+public:
+    /* called with true on the render thread when it parks, and with false
+       on the thread whose event woke it */
+    using StateFunction = void (*)(void* context, bool parked);
+    
+    static constexpr double SILENCE_THRESHOLD = 1.0e-5;  /* -100 dB of full scale */
+    static constexpr double TAIL_TIME = 0.1;             /* seconds of silence before parking */
+    
+    explicit IdleSignal(int sampleRate);
+    
+    IdleSignal(const IdleSignal&) = delete;
+    IdleSignal& operator=(const IdleSignal&) = delete;
+    
+    void setSampleRate(int sampleRate);
+    void setStateFunction(StateFunction function, void* context);
+    
+    bool isParked() const { return parked_.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Account for one rendered block (render thread only)
+     *
+     * @param left Left channel of the block
+     * @param right Right channel of the block
+     * @param frames Number of frames
+     * @param gain Gain the block is played at
+     * @param busy Returns whether any voice plays or any event is queued;
+     *             checked again after parking, so an event queued just
+     *             before is not slept through
+     * @return true if the renderer parked with this block
+     */
+    template <typename Busy>
+    bool trackSilence(const double* left, const double* right, size_t frames, double gain, Busy busy) {
+        if (silentFrames_ >= tailFrames_) {
+            if (!busy()) {
+                return false;
+            }
+            silentFrames_ = 0;
+        }
+        double peak = 0.0;
+        for (size_t frame = 0; frame < frames; frame++) {
+            peak = std::max({peak, std::abs(left[frame]), std::abs(right[frame])});
+        }
+        if (peak * std::abs(gain) >= SILENCE_THRESHOLD) {
+            silentFrames_ = 0;
+            return false;
+        }
+        if (busy()) {
+            silentFrames_ = 0;
+            return false;
+        }
+        silentFrames_ += frames;
+        if (silentFrames_ < tailFrames_) {
+            return false;
+        }
+        parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (busy()) {
+            unpark();
+            return false;
+        }
+        if (stateFunction_) {
+            stateFunction_(stateContext_, true);
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Block while parked, until notified or ready() holds (render thread only)
+     */
+    template <typename Ready>
+    void wait(Ready ready) {
+        for (;;) {
+            uint32_t signal = signal_.load(std::memory_order_acquire);
+            if (!isParked() || ready()) {
+                break;
+            }
+            signal_.wait(signal, std::memory_order_acquire);
+        }
+        unpark();
+    }
+    
+    void notify();
+    void wake();
+
+private:
+    void unpark();
+    
+    std::atomic<bool> parked_{false};
+    std::atomic<uint32_t> signal_{0};
+    StateFunction stateFunction_ = nullptr;
+    void* stateContext_ = nullptr;
+    /* render thread only */
+    size_t tailFrames_ = 0;
+    size_t silentFrames_ = 0;
+};
+
+}
@@ -0,0 +1,96 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "fm.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief Native MIDI input that plays a synthesizer from its own thread
+ *
+ * Messages are decoded on the operating system's MIDI thread (a dedicated
+ * thread polling the ALSA sequencer on Linux, the CoreMIDI read thread on
+ * macOS, the WinMM callback thread on Windows), scheduled on the audio
+ * clock one render period after they arrived and pushed straight into the
+ * synthesizer's input event queue, so note timing never depends on the GUI
+ * thread or on where the block boundaries fall.
+ *
+ * Input is omni: notes, pitch bend, modulation wheel and all notes off on
+ * every MIDI channel play the synthesizer channel given to the constructor,
+ * and volume (CC 7) sets the synthesizer's master volume. At most one port
+ * is open at a time. The notes held on the port are kept for display and
+ * can be read from any thread with getHeldNotes().
+ */
+class MidiInput {
+public:
+    explicit MidiInput(FMSynthesizer& synth, int channel = 0);
+    ~MidiInput();
+    
+    MidiInput(const MidiInput&) = delete;
+    MidiInput& operator=(const MidiInput&) = delete;
+    
+    static std::vector<std::string> listPorts();
+    
+    void open(int port);
+    void close();
+    bool isOpen() const { return backend_ != nullptr; }
+    const std::string& getPortName() const { return portName_; }
+    
+    uint64_t getEventCount() const { return eventCount_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return droppedCount_.load(std::memory_order_relaxed); }
+    std::bitset<Constants::MIDI_NOTE_COUNT> getHeldNotes() const;
+    
+    void handleBytes(const uint8_t* bytes, size_t length, uint64_t nanoseconds);
+
+private:
+    struct Backend;
+    
+    void handleMessage(uint8_t status, uint8_t data1, uint8_t data2, uint64_t nanoseconds);
+    void post(SynthEvent::Type type, int index, double value, uint64_t nanoseconds);
+    void setHeld(int note, bool held);
+    void clearHeld();
+    
+    FMSynthesizer& synth_;
+    int channel_;
+    std::string portName_;
+    std::unique_ptr<Backend> backend_;
+    
+    /* byte stream parser state, touched only by the input thread */
+    uint8_t runningStatus_ = 0;
+    uint8_t pending_[2] = {};
+    size_t pendingCount_ = 0;
+    bool inSysEx_ = false;
+    
+    std::atomic<uint64_t> eventCount_{0};
+    std::atomic<uint64_t> droppedCount_{0};
+    
+    /* notes held on the port, one bit per MIDI note, written by the input thread */
+    static constexpr int HELD_WORD_BITS = 64;
+    std::atomic<uint64_t> heldNotes_[Constants::MIDI_NOTE_COUNT / HELD_WORD_BITS] = {};
+};
+
+}
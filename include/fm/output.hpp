@@ -0,0 +1,109 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QAudioSink>
+#include <QAudioFormat>
+#include <QAudioDevice>
+#include <QMediaDevices>
+
+#include "fm.hpp"
+#include "convert.hpp"
+#include "device.hpp"
+#include "telemetry.hpp"
+
+#include <atomic>
+
+namespace toybasic {
+
+/**
+ * @brief The application's single audio output stream
+ *
+ * Owns one QAudioSink on the default output device and the FMAudioDevice
+ * that feeds it, pulling every block from one render source. The stream
+ * is opened in the best sample format the device takes natively, so the
+ * system has no conversion left to do. Synthesizers
+ * never open a device themselves; to play several at once, register them
+ * with an FMSynthesizerManager and hand the manager to the output.
+ * Underruns the sink reports are counted into the optional telemetry.
+ * While a source with an idle signal is parked the stream is suspended.
+ *
+ * The sink and the device live on a thread of the output's own with its
+ * own event loop, so the device's reads, and with them every render, run
+ * there rather than on the GUI thread. The member functions are called
+ * from the thread that created the output and are carried out on the
+ * audio thread, waiting for it.
+ */
+class QtAudioOutput {
+public:
+    explicit QtAudioOutput(AudioRenderSource& source, int sampleRate = Constants::DEFAULT_SAMPLE_RATE,
+                           RenderTelemetry* telemetry = nullptr);
+    ~QtAudioOutput();
+
+    QtAudioOutput(const QtAudioOutput&) = delete;
+    QtAudioOutput& operator=(const QtAudioOutput&) = delete;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_; }
+    bool isSuspended() const { return suspended_.load(std::memory_order_relaxed); }
+
+    void setBufferFrames(int frames);
+    int getBufferFrames() const { return bufferFrames_; }
+    int getSampleRate() const { return sampleRate_; }
+    double getOutputLatencyMs() const;
+    SampleFormat getSampleFormat() const { return format_; }
+
+    void setDither(bool enabled);
+    bool getDither() const { return dither_; }
+    void setDacEmulation(bool enabled);
+    bool getDacEmulation() const { return dacEmulation_; }
+
+private:
+    template <typename Function>
+    void runOnAudioThread(Function function);
+    void open();
+    void close();
+    bool startStream();
+    void stopStream();
+    static void idleStateChanged(void* context, bool parked);
+    void followIdleState();
+
+    AudioRenderSource& source_;
+    RenderTelemetry* telemetry_;
+    int sampleRate_;
+    int bufferFrames_;
+    bool running_;
+    std::atomic<bool> suspended_;
+    SampleFormat format_;
+    bool dither_;
+    bool dacEmulation_;
+
+    FMAudioDevice* device_;
+    QAudioSink* sink_;
+    IdleSignal* idle_;
+    /* runs the sink's event loop; the device's reads happen here */
+    QThread thread_;
+    /* lives on thread_; work for the audio thread, idle changes included, is queued to it */
+    QObject* receiver_;
+};
+
+}
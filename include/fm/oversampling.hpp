@@ -0,0 +1,184 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "simd.hpp"
+
+namespace toybasic {
+
+/*
+ * One-sided coefficients of the two half-band low-pass filters, nearest the
+ * centre tap first. Every other tap of a half-band filter is zero and the
+ * centre tap is 0.5, so only these are stored. Both are Kaiser-windowed
+ * sincs scaled for unity gain at DC.
+ */
+namespace HalfBand {
+    /* 63 taps (beta 8.8): flat to 0.204 of the input rate, which is 18 kHz
+       when 44.1 kHz is oversampled 2x, and 88 dB down from 0.296 */
+    inline constexpr std::array<double, 16> SHARP = {
+        0.31693935015269609,
+        -0.10205725344205668,
+        0.057120903354156448,
+        -0.036720702980991365,
+        0.024767091232737161,
+        -0.016899192143123777,
+        0.011437774661997408,
+        -0.0075777973450930824,
+        0.0048609731944845866,
+        -0.0029865927575492618,
+        0.0017354966931641296,
+        -0.00093788649629782768,
+        0.00045942861283681516,
+        -0.00019492191416608181,
+        6.4665069199434884e-05,
+        -1.1335891994068461e-05,
+    };
+    
+    /* 27 taps (beta 9.2): flat to 0.108 of the input rate and 91 dB down
+       from 0.363, enough for the first of two 2x stages, since whatever it
+       lets through lands above the second stage's passband */
+    inline constexpr std::array<double, 7> WIDE = {
+        0.31023124022946991,
+        -0.083950139579183916,
+        0.032695257067399605,
+        -0.011681850365356133,
+        0.0032343558539519048,
+        -0.00054740386843828766,
+        1.8540662156913968e-05,
+    };
+}
+
+/**
+ * @brief Decimates the oversampled operator output of every voice back to the output rate
+ *
+ * 2x runs one sharp half-band stage; 4x runs a wide stage down to 2x first.
+ * Each stage is in polyphase form: of every pair of input samples, the
+ * later one goes through the stage's nonzero taps and the earlier one only
+ * through the centre tap, which is a plain delay, so one output costs one
+ * multiply-add per coefficient pair. Voices are filtered a lane group at a
+ * time, one vector operation per tap, with the history laid out per group
+ * so that different groups may be filtered concurrently. Nothing allocates.
+ *
+ * @tparam Voices Number of voices the history is sized for
+ */
+template <size_t Voices>
+class VoiceDecimator {
+public:
+    static constexpr int MAX_FACTOR = 4;
+    
+    VoiceDecimator() { reset(); }
+    
+    /* clear every voice's history, e.g. when the factor changes */
+    void reset() {
+        sharp_.reset();
+        wide_.reset();
+    }
+    
+    /* clear one voice's history before it starts a note */
+    void resetVoice(int voice) {
+        sharp_.resetVoice(voice);
+        wide_.resetVoice(voice);
+    }
+    
+    /**
+     * @brief Turn factor consecutive oversampled outputs of a lane group into one
+     *
+     * @param group Index of the lane group
+     * @param samples The group's outputs, oldest first
+     * @param factor 2 or 4
+     */
+    simd::Vec decimate(int group, const simd::Vec* samples, int factor) {
+        if (factor == 4) {
+            const simd::Vec first = wide_.process(group, samples[0], samples[1]);
+            const simd::Vec second = wide_.process(group, samples[2], samples[3]);
+            return sharp_.process(group, first, second);
+        }
+        return sharp_.process(group, samples[0], samples[1]);
+    }
+    
+private:
+    template <const auto& Coefficients>
+    class Stage {
+    public:
+        void reset() {
+            for (History& history : histories_) {
+                history.later.fill(0.0);
+                history.earlier.fill(0.0);
+                history.laterPosition = 0;
+                history.earlierPosition = 0;
+            }
+        }
+        
+        void resetVoice(int voice) {
+            History& history = histories_[voice / simd::LANES];
+            const size_t lane = voice % simd::LANES;
+            for (size_t slot = 0; slot < 2 * DELAY; slot++) {
+                history.later[slot * simd::LANES + lane] = 0.0;
+            }
+            for (size_t slot = 0; slot < PAIRS; slot++) {
+                history.earlier[slot * simd::LANES + lane] = 0.0;
+            }
+        }
+        
+        simd::Vec process(int group, simd::Vec earlier, simd::Vec later) {
+            History& history = histories_[group];
+            
+            /* the later samples of the last DELAY pairs, stored twice so
+               they can be read newest first without wrapping */
+            history.laterPosition = history.laterPosition == 0 ? DELAY - 1 : history.laterPosition - 1;
+            double* newest = &history.later[history.laterPosition * simd::LANES];
+            later.store(newest);
+            later.store(newest + DELAY * simd::LANES);
+            
+            /* the centre tap lies PAIRS - 1 pairs back, on an earlier sample */
+            earlier.store(&history.earlier[history.earlierPosition * simd::LANES]);
+            history.earlierPosition = history.earlierPosition + 1 == PAIRS ? 0 : history.earlierPosition + 1;
+            simd::Vec output = simd::Vec::load(&history.earlier[history.earlierPosition * simd::LANES])
+                             * simd::Vec::broadcast(0.5);
+            
+            for (size_t m = 0; m < PAIRS; m++) {
+                const simd::Vec nearer = simd::Vec::load(newest + (PAIRS - 1 - m) * simd::LANES);
+                const simd::Vec farther = simd::Vec::load(newest + (PAIRS + m) * simd::LANES);
+                output = output + (nearer + farther) * simd::Vec::broadcast(Coefficients[m]);
+            }
+            return output;
+        }
+        
+    private:
+        static constexpr size_t PAIRS = Coefficients.size();
+        static constexpr size_t DELAY = 2 * PAIRS;
+        
+        struct History {
+            alignas(simd::ALIGNMENT) std::array<double, 2 * DELAY * simd::LANES> later;
+            alignas(simd::ALIGNMENT) std::array<double, PAIRS * simd::LANES> earlier;
+            size_t laterPosition;
+            size_t earlierPosition;
+        };
+        
+        std::array<History, Voices / simd::LANES> histories_;
+    };
+    
+    Stage<HalfBand::SHARP> sharp_;
+    Stage<HalfBand::WIDE> wide_;
+};
+
+}
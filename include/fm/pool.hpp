@@ -0,0 +1,95 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ring.hpp"
+#include "realtime.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief Fixed set of pre-spawned threads that run batches of render tasks
+ *
+ * run() wakes only as many workers as the batch has tasks beyond the one it
+ * starts on itself, and joins in. Tasks are claimed one at a time from a
+ * shared atomic counter, so a worker that finishes early keeps taking work
+ * from the rest of the batch, and run() waits for the tasks to finish, never
+ * for a worker that found nothing left to claim. Dispatching a batch
+ * allocates nothing and takes no locks; idle workers sleep on an atomic
+ * wait of their own. Only one thread may call run() at a time.
+ */
+class RenderWorkerPool {
+public:
+    using TaskFunction = void (*)(void* context, size_t task);
+
+    explicit RenderWorkerPool(size_t workerCount);
+    ~RenderWorkerPool();
+
+    RenderWorkerPool(const RenderWorkerPool&) = delete;
+    RenderWorkerPool& operator=(const RenderWorkerPool&) = delete;
+
+    void run(TaskFunction function, void* context, size_t taskCount);
+    RealtimeStatus promoteWorkers(const RealtimeConfig& config, uint64_t periodNanoseconds);
+
+    size_t getWorkerCount() const { return workers_.size(); }
+
+    static size_t defaultWorkerCount();
+    /* the claim counter packs the task index and count into 16 bits each */
+    static constexpr size_t MAX_TASKS = 0xFFFF;
+
+private:
+    /* one per worker, on a cache line of its own */
+    struct alignas(CACHE_LINE_SIZE) WorkerSlot {
+        /* bumped to wake just this worker */
+        std::atomic<uint32_t> wake{0};
+        /* set by promoteWorkers(), taken by the worker once */
+        std::atomic<bool> promote{false};
+    };
+
+    void workerLoop(size_t index);
+    void wakeWorker(size_t index);
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<WorkerSlot[]> slots_;
+
+    /* only read for a task claimed from the running batch */
+    TaskFunction function_ = nullptr;
+    void* context_ = nullptr;
+    /* batch number, set by run() alone */
+    uint32_t batchNumber_ = 0;
+    const RealtimeConfig* promotion_ = nullptr;
+    uint64_t promotionPeriod_ = 0;
+    std::vector<RealtimeStatus> workerStatus_;
+
+    /* batch number in the top 32 bits, task count in the next 16, next task in the low 16 */
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> batch_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> pendingTasks_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> pendingPromotions_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+}
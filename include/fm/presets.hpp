@@ -18,9 +18,15 @@
 
 #pragma once
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 #include "fm.hpp"
+#include "bank.hpp"
 
 namespace toybasic {
 namespace PresetConstants {
@@ -82,9 +88,35 @@ namespace PresetConstants {
     constexpr double EFFECT_MAX = 0.8;
 }
 
+enum class PresetCategory {
+    PERCUSSION,
+    BASS,
+    BRASS,
+    WOODWIND,
+    STRINGS,
+    KEYBOARD,
+    SYNTH,
+    EFFECTS,
+    EXPERIMENTAL
+};
+
+constexpr uint32_t presetCategoryBit(PresetCategory category) {
+    return 1u << static_cast<int>(category);
+}
+
+/**
+ * @brief One patch, laid out exactly as a preset bank record on disk
+ *
+ * Plain fixed-size data with no owning members, so a memory-mapped bank
+ * can be used in place. The name is NUL-terminated; categories is a set of
+ * presetCategoryBit() tags.
+ */
 struct FMPresetConfig {
-    std::string name;
-    int algorithm;
+    static constexpr size_t NAME_SIZE = 32;
+    
+    std::array<char, NAME_SIZE> name;
+    int32_t algorithm;
+    uint32_t categories;
     
     struct OperatorConfig {
         double frequency;
@@ -104,8 +136,18 @@ struct FMPresetConfig {
     double reverb;
     double chorus;
     double distortion;
+    double feedback;
+    
+    std::string_view getName() const {
+        return {name.data(), static_cast<size_t>(std::find(name.begin(), name.end(), '\0') - name.begin())};
+    }
+    void setName(std::string_view text);
+    bool hasCategory(PresetCategory category) const { return categories & presetCategoryBit(category); }
 };
 
+static_assert(std::is_trivially_copyable_v<FMPresetConfig>, "bank records are used in place");
+static_assert(sizeof(FMPresetConfig) == 464, "bank record layout must not change without a bank version bump");
+
 class PresetManager {
 public:
     PresetManager();
@@ -114,17 +156,36 @@ public:
     
     const FMPresetConfig& getPreset(const std::string& name) const;
     
+    int findPreset(std::string_view name) const;
+    
     int getPresetCount() const;
     
     std::vector<std::string> getPresetNames() const;
     
+    std::vector<int> getPresetsByCategory(PresetCategory category) const;
+    
+    void loadBank(const std::string& path);
+    void saveBank(const std::string& path) const;
+    int importSysEx(const std::string& path);
+    
     void applyPreset(FMSynthesizer& synth, int channel, int presetIndex) const;
     void applyPreset(FMSynthesizer& synth, int channel, const std::string& presetName) const;
     void applyPreset(FMSynthesizer& synth, int channel, const FMPresetConfig& preset) const;
 
 private:
+    /* presets built in code or imported; unused while a bank is mapped */
     std::vector<FMPresetConfig> presets_;
+    std::vector<uint32_t> nameIndex_;
+    PresetBank bank_;
+    
+    /* whichever of the two is in use */
+    const FMPresetConfig* records_;
+    size_t recordCount_;
+    const uint32_t* nameSlots_;
+    size_t nameSlotCount_;
+    
     void initializePresets();
+    void useOwnedPresets();
     
     FMPresetConfig::OperatorConfig createOperator(double freq, double amp, double mod, 
                                           WaveformType wave, double att, double dec, 
@@ -140,18 +201,4 @@ private:
     FMPresetConfig createSineFlute();
 };
 
-enum class PresetCategory {
-    PERCUSSION,
-    BASS,
-    BRASS,
-    WOODWIND,
-    STRINGS,
-    KEYBOARD,
-    SYNTH,
-    EFFECTS,
-    EXPERIMENTAL
-};
-
-std::vector<int> getPresetsByCategory(PresetCategory category);
-
 }
@@ -0,0 +1,65 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace toybasic {
+
+/**
+ * @brief What a render thread asks the OS for in real-time mode
+ */
+struct RealtimeConfig {
+    static constexpr int DEFAULT_PRIORITY = 70;
+    
+    bool enabled = false;
+    /* SCHED_FIFO priority (1-99) on Linux; macOS and Windows use their own audio classes */
+    int priority = DEFAULT_PRIORITY;
+    /* render threads take these cores in turn; empty leaves them to the scheduler */
+    std::vector<int> cores;
+    bool lockMemory = true;
+};
+
+/**
+ * @brief What the OS refused, for one thread or summed over several
+ */
+struct RealtimeStatus {
+    bool requested = false;
+    /* render threads that have asked so far; none means nothing was promoted yet */
+    size_t threads = 0;
+    /* one line per request that was denied, and why */
+    std::vector<std::string> denials;
+    
+    bool isGranted() const { return requested && threads > 0 && denials.empty(); }
+    void deny(const std::string& reason);
+    void merge(const RealtimeStatus& other);
+    std::string describe() const;
+};
+
+RealtimeStatus promoteCurrentThread(const RealtimeConfig& config, size_t thread, uint64_t periodNanoseconds);
+void lockMemory(RealtimeStatus& status, const void* data, size_t bytes);
+
+template <typename Container>
+void lockMemory(RealtimeStatus& status, const Container& container) {
+    lockMemory(status, container.data(), container.size() * sizeof(*container.data()));
+}
+
+}
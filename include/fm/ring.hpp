@@ -0,0 +1,179 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+namespace toybasic {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Fixed-capacity single-producer/single-consumer ring buffer
+ *
+ * One thread may write and one other thread may read concurrently without
+ * locks or allocation. The capacity is rounded up to a power of two, and the
+ * producer and consumer indices live on separate cache lines so the two
+ * threads never false-share. Bulk transfers copy at most two contiguous spans.
+ */
+template <typename T>
+class SPSCRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SPSCRingBuffer requires a trivially copyable type");
+
+public:
+    explicit SPSCRingBuffer(size_t capacity)
+        : capacity_(roundUpToPowerOfTwo(capacity)), mask_(capacity_ - 1),
+          buffer_(std::make_unique<T[]>(capacity_)) {}
+
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    /**
+     * @brief Write up to count elements (producer only)
+     * @return The number of elements actually written
+     */
+    size_t write(const T* data, size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t space = capacity_ - (head - tailCache_);
+        if (space < count) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            space = capacity_ - (head - tailCache_);
+        }
+        count = std::min(count, space);
+        if (count == 0) return 0;
+
+        size_t start = head & mask_;
+        size_t first = std::min(count, capacity_ - start);
+        std::copy_n(data, first, buffer_.get() + start);
+        std::copy_n(data + first, count - first, buffer_.get());
+
+        head_.store(head + count, std::memory_order_release);
+        signalConsumer();
+        return count;
+    }
+
+    /**
+     * @brief Read up to count elements (consumer only)
+     * @return The number of elements actually read
+     */
+    size_t read(T* data, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t available = headCache_ - tail;
+        if (available < count) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            available = headCache_ - tail;
+        }
+        count = std::min(count, available);
+        if (count == 0) return 0;
+
+        size_t start = tail & mask_;
+        size_t first = std::min(count, capacity_ - start);
+        std::copy_n(buffer_.get() + start, first, data);
+        std::copy_n(buffer_.get(), count - first, data + first);
+
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool push(const T& value) { return write(&value, 1) == 1; }
+    bool pop(T& value) { return read(&value, 1) == 1; }
+
+    /**
+     * @brief Block the consumer until the producer has written something
+     *
+     * Only the consumer may call this. The producer never blocks; it bumps a
+     * signal word and notifies only while a consumer is actually parked.
+     */
+    void waitForData() {
+        while (empty()) {
+            uint32_t signal = dataSignal_.load(std::memory_order_acquire);
+            consumerWaiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!empty()) {
+                break;
+            }
+            dataSignal_.wait(signal, std::memory_order_acquire);
+        }
+        consumerWaiting_.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Wake a consumer parked in waitForData() without writing data
+     */
+    void wakeConsumer() {
+        dataSignal_.fetch_add(1, std::memory_order_release);
+        dataSignal_.notify_all();
+    }
+
+    /**
+     * @brief Number of elements written and not yet read (any thread)
+     *
+     * The producer and the consumer may call it; the other side can move on
+     * as soon as it returns. Any other thread gets a snapshot: tail_ is
+     * loaded before head_, so the difference cannot wrap, and it is clamped
+     * to the capacity in case the consumer read and the producer refilled in
+     * between the two loads.
+     */
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return std::min(head - tail, capacity_);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return capacity_; }
+    const T* storage() const { return buffer_.get(); }
+
+private:
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void signalConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumerWaiting_.load(std::memory_order_relaxed)) {
+            wakeConsumer();
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+    size_t tailCache_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+    size_t headCache_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> dataSignal_{0};
+    std::atomic<bool> consumerWaiting_{false};
+};
+
+}
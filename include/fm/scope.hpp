@@ -0,0 +1,97 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ring.hpp"
+#include "algorithms.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief One published view of the output, for monitoring
+ */
+struct ScopeSnapshot {
+    static constexpr size_t FRAMES = 2048;
+    
+    /* number of snapshots published up to and including this one; 0 if none yet */
+    uint64_t sequence = 0;
+    int sampleRate = 0;
+    /* the last FRAMES frames of the post-mix output, oldest first */
+    std::array<float, FRAMES> left{};
+    std::array<float, FRAMES> right{};
+    /* each operator slot's peak envelope level times amplitude over the playing voices */
+    std::array<float, Algorithms::OPERATORS> operatorLevels{};
+};
+
+/**
+ * @brief Wait-free tap that hands the rendered output to one monitoring thread
+ *
+ * The render thread keeps the most recent ScopeSnapshot::FRAMES frames in a
+ * history of its own and, every PUBLISH_FRAMES frames, copies them into the
+ * back buffer of a triple buffer and swaps it with the middle one. The
+ * reader swaps the middle buffer with its front one whenever a newer
+ * snapshot is waiting. Each side only ever does one atomic exchange, so
+ * neither can make the other wait, and a reader that stalls simply misses
+ * snapshots. Nothing is recorded while the tap is disabled.
+ */
+class ScopeTap {
+public:
+    static constexpr size_t PUBLISH_FRAMES = 512;
+    
+    ScopeTap() = default;
+    
+    ScopeTap(const ScopeTap&) = delete;
+    ScopeTap& operator=(const ScopeTap&) = delete;
+    
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    
+    bool write(const double* left, const double* right, size_t frames, double gain);
+    void publish(const std::array<float, Algorithms::OPERATORS>& operatorLevels, int sampleRate);
+    
+    const ScopeSnapshot* acquire();
+
+private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    /* set in middle_ while it holds a snapshot the reader has not taken */
+    static constexpr uint32_t FRESH = 4;
+    
+    std::array<ScopeSnapshot, 3> slots_;
+    
+    /* render thread only */
+    uint32_t back_ = 0;
+    std::array<float, ScopeSnapshot::FRAMES> historyLeft_{};
+    std::array<float, ScopeSnapshot::FRAMES> historyRight_{};
+    size_t historyPosition_ = 0;
+    size_t pendingFrames_ = 0;
+    uint64_t published_ = 0;
+    
+    /* reader only */
+    uint32_t front_ = 1;
+    
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> middle_{2};
+    std::atomic<bool> enabled_{false};
+};
+
+}
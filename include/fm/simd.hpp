@@ -0,0 +1,349 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#if defined(TOYBASIC_SIMD_FORCE_SCALAR)
+#define TOYBASIC_SIMD_SCALAR 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define TOYBASIC_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TOYBASIC_SIMD_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TOYBASIC_SIMD_NEON 1
+#else
+#define TOYBASIC_SIMD_SCALAR 1
+#endif
+
+namespace toybasic {
+namespace simd {
+
+/**
+ * @brief Number of voices processed together by one kernel invocation
+ *
+ * The lane width is fixed at four doubles on every backend so the voice
+ * layout and the mix order do not depend on the instruction set: AVX2 uses a
+ * single 256-bit register, SSE2 and NEON use pairs of 128-bit registers and
+ * the scalar fallback uses plain arrays.
+ */
+constexpr size_t LANES = 4;
+constexpr size_t ALIGNMENT = 32;
+
+#if defined(TOYBASIC_SIMD_AVX2)
+
+constexpr const char* BACKEND = "AVX2";
+
+struct Mask {
+    __m256d m;
+};
+
+struct Vec {
+    __m256d v;
+
+    static Vec zero() { return {_mm256_setzero_pd()}; }
+    static Vec broadcast(double x) { return {_mm256_set1_pd(x)}; }
+    static Vec load(const double* p) { return {_mm256_load_pd(p)}; }
+    void store(double* p) const { _mm256_store_pd(p, v); }
+};
+
+inline Vec operator+(Vec a, Vec b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm256_div_pd(a.v, b.v)}; }
+
+inline Mask operator<(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask operator>=(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)}; }
+inline Mask operator>(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+inline Mask operator==(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+inline Mask operator!=(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ)}; }
+inline Mask operator&(Mask a, Mask b) { return {_mm256_and_pd(a.m, b.m)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm256_or_pd(a.m, b.m)}; }
+
+inline Vec select(Mask mask, Vec a, Vec b) { return {_mm256_blendv_pd(b.v, a.v, mask.m)}; }
+
+inline Mask maskFromBits(unsigned bits) {
+    const __m256i bit = _mm256_set_epi64x(8, 4, 2, 1);
+    const __m256i set = _mm256_and_si256(_mm256_set1_epi64x(bits), bit);
+    return {_mm256_castsi256_pd(_mm256_cmpeq_epi64(set, bit))};
+}
+
+inline unsigned bitsFromMask(Mask mask) { return static_cast<unsigned>(_mm256_movemask_pd(mask.m)); }
+
+#elif defined(TOYBASIC_SIMD_SSE2)
+
+constexpr const char* BACKEND = "SSE2";
+
+struct Mask {
+    __m128d lo, hi;
+};
+
+struct Vec {
+    __m128d lo, hi;
+
+    static Vec zero() { return {_mm_setzero_pd(), _mm_setzero_pd()}; }
+    static Vec broadcast(double x) { return {_mm_set1_pd(x), _mm_set1_pd(x)}; }
+    static Vec load(const double* p) { return {_mm_load_pd(p), _mm_load_pd(p + 2)}; }
+    void store(double* p) const { _mm_store_pd(p, lo); _mm_store_pd(p + 2, hi); }
+};
+
+inline Vec operator+(Vec a, Vec b) { return {_mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm_div_pd(a.lo, b.lo), _mm_div_pd(a.hi, b.hi)}; }
+
+inline Mask operator<(Vec a, Vec b) { return {_mm_cmplt_pd(a.lo, b.lo), _mm_cmplt_pd(a.hi, b.hi)}; }
+inline Mask operator>=(Vec a, Vec b) { return {_mm_cmpge_pd(a.lo, b.lo), _mm_cmpge_pd(a.hi, b.hi)}; }
+inline Mask operator>(Vec a, Vec b) { return {_mm_cmpgt_pd(a.lo, b.lo), _mm_cmpgt_pd(a.hi, b.hi)}; }
+inline Mask operator==(Vec a, Vec b) { return {_mm_cmpeq_pd(a.lo, b.lo), _mm_cmpeq_pd(a.hi, b.hi)}; }
+inline Mask operator!=(Vec a, Vec b) { return {_mm_cmpneq_pd(a.lo, b.lo), _mm_cmpneq_pd(a.hi, b.hi)}; }
+inline Mask operator&(Mask a, Mask b) { return {_mm_and_pd(a.lo, b.lo), _mm_and_pd(a.hi, b.hi)}; }
+inline Mask operator|(Mask a, Mask b) { return {_mm_or_pd(a.lo, b.lo), _mm_or_pd(a.hi, b.hi)}; }
+
+inline __m128d blend(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+inline Vec select(Mask mask, Vec a, Vec b) {
+    return {blend(mask.lo, a.lo, b.lo), blend(mask.hi, a.hi, b.hi)};
+}
+
+inline Mask maskFromBits(unsigned bits) {
+    auto lane = [bits](unsigned bit) { return (bits & bit) ? -1LL : 0LL; };
+    return {_mm_castsi128_pd(_mm_set_epi64x(lane(2), lane(1))),
+            _mm_castsi128_pd(_mm_set_epi64x(lane(8), lane(4)))};
+}
+
+inline unsigned bitsFromMask(Mask mask) {
+    return static_cast<unsigned>(_mm_movemask_pd(mask.lo) | (_mm_movemask_pd(mask.hi) << 2));
+}
+
+#elif defined(TOYBASIC_SIMD_NEON)
+
+constexpr const char* BACKEND = "NEON";
+
+struct Mask {
+    uint64x2_t lo, hi;
+};
+
+struct Vec {
+    float64x2_t lo, hi;
+
+    static Vec zero() { return {vdupq_n_f64(0.0), vdupq_n_f64(0.0)}; }
+    static Vec broadcast(double x) { return {vdupq_n_f64(x), vdupq_n_f64(x)}; }
+    static Vec load(const double* p) { return {vld1q_f64(p), vld1q_f64(p + 2)}; }
+    void store(double* p) const { vst1q_f64(p, lo); vst1q_f64(p + 2, hi); }
+};
+
+inline Vec operator+(Vec a, Vec b) { return {vaddq_f64(a.lo, b.lo), vaddq_f64(a.hi, b.hi)}; }
+inline Vec operator-(Vec a, Vec b) { return {vsubq_f64(a.lo, b.lo), vsubq_f64(a.hi, b.hi)}; }
+inline Vec operator*(Vec a, Vec b) { return {vmulq_f64(a.lo, b.lo), vmulq_f64(a.hi, b.hi)}; }
+inline Vec operator/(Vec a, Vec b) { return {vdivq_f64(a.lo, b.lo), vdivq_f64(a.hi, b.hi)}; }
+
+inline Mask operator<(Vec a, Vec b) { return {vcltq_f64(a.lo, b.lo), vcltq_f64(a.hi, b.hi)}; }
+inline Mask operator>=(Vec a, Vec b) { return {vcgeq_f64(a.lo, b.lo), vcgeq_f64(a.hi, b.hi)}; }
+inline Mask operator>(Vec a, Vec b) { return {vcgtq_f64(a.lo, b.lo), vcgtq_f64(a.hi, b.hi)}; }
+inline Mask operator==(Vec a, Vec b) { return {vceqq_f64(a.lo, b.lo), vceqq_f64(a.hi, b.hi)}; }
+inline Mask operator!=(Vec a, Vec b) {
+    return {veorq_u64(vceqq_f64(a.lo, b.lo), vdupq_n_u64(~0ULL)),
+            veorq_u64(vceqq_f64(a.hi, b.hi), vdupq_n_u64(~0ULL))};
+}
+inline Mask operator&(Mask a, Mask b) { return {vandq_u64(a.lo, b.lo), vandq_u64(a.hi, b.hi)}; }
+inline Mask operator|(Mask a, Mask b) { return {vorrq_u64(a.lo, b.lo), vorrq_u64(a.hi, b.hi)}; }
+
+inline Vec select(Mask mask, Vec a, Vec b) {
+    return {vbslq_f64(mask.lo, a.lo, b.lo), vbslq_f64(mask.hi, a.hi, b.hi)};
+}
+
+inline Mask maskFromBits(unsigned bits) {
+    auto lane = [bits](unsigned bit) { return (bits & bit) ? ~0ULL : 0ULL; };
+    const uint64_t lo[2] = {lane(1), lane(2)};
+    const uint64_t hi[2] = {lane(4), lane(8)};
+    return {vld1q_u64(lo), vld1q_u64(hi)};
+}
+
+inline unsigned bitsFromMask(Mask mask) {
+    return static_cast<unsigned>((vgetq_lane_u64(mask.lo, 0) & 1) | ((vgetq_lane_u64(mask.lo, 1) & 1) << 1) |
+                                 ((vgetq_lane_u64(mask.hi, 0) & 1) << 2) | ((vgetq_lane_u64(mask.hi, 1) & 1) << 3));
+}
+
+#else
+
+constexpr const char* BACKEND = "scalar";
+
+struct Mask {
+    bool m[LANES];
+};
+
+struct Vec {
+    double v[LANES];
+
+    static Vec zero() { return broadcast(0.0); }
+    static Vec broadcast(double x) { return {{x, x, x, x}}; }
+    static Vec load(const double* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    void store(double* p) const { for (size_t i = 0; i < LANES; i++) p[i] = v[i]; }
+};
+
+template <typename F>
+inline Vec lanewise(Vec a, Vec b, F f) {
+    Vec r;
+    for (size_t i = 0; i < LANES; i++) r.v[i] = f(a.v[i], b.v[i]);
+    return r;
+}
+
+template <typename F>
+inline Mask compare(Vec a, Vec b, F f) {
+    Mask r;
+    for (size_t i = 0; i < LANES; i++) r.m[i] = f(a.v[i], b.v[i]);
+    return r;
+}
+
+inline Vec operator+(Vec a, Vec b) { return lanewise(a, b, [](double x, double y) { return x + y; }); }
+inline Vec operator-(Vec a, Vec b) { return lanewise(a, b, [](double x, double y) { return x - y; }); }
+inline Vec operator*(Vec a, Vec b) { return lanewise(a, b, [](double x, double y) { return x * y; }); }
+inline Vec operator/(Vec a, Vec b) { return lanewise(a, b, [](double x, double y) { return x / y; }); }
+
+inline Mask operator<(Vec a, Vec b) { return compare(a, b, [](double x, double y) { return x < y; }); }
+inline Mask operator>=(Vec a, Vec b) { return compare(a, b, [](double x, double y) { return x >= y; }); }
+inline Mask operator>(Vec a, Vec b) { return compare(a, b, [](double x, double y) { return x > y; }); }
+inline Mask operator==(Vec a, Vec b) { return compare(a, b, [](double x, double y) { return x == y; }); }
+inline Mask operator!=(Vec a, Vec b) { return compare(a, b, [](double x, double y) { return x != y; }); }
+
+inline Mask operator&(Mask a, Mask b) {
+    Mask r;
+    for (size_t i = 0; i < LANES; i++) r.m[i] = a.m[i] && b.m[i];
+    return r;
+}
+
+inline Mask operator|(Mask a, Mask b) {
+    Mask r;
+    for (size_t i = 0; i < LANES; i++) r.m[i] = a.m[i] || b.m[i];
+    return r;
+}
+
+inline Vec select(Mask mask, Vec a, Vec b) {
+    Vec r;
+    for (size_t i = 0; i < LANES; i++) r.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+    return r;
+}
+
+inline Mask maskFromBits(unsigned bits) {
+    Mask r;
+    for (size_t i = 0; i < LANES; i++) r.m[i] = (bits >> i) & 1;
+    return r;
+}
+
+inline unsigned bitsFromMask(Mask mask) {
+    unsigned bits = 0;
+    for (size_t i = 0; i < LANES; i++) bits |= static_cast<unsigned>(mask.m[i]) << i;
+    return bits;
+}
+
+#endif
+
+constexpr unsigned ALL_LANES = (1u << LANES) - 1;
+
+#if defined(TOYBASIC_SIMD_SCALAR)
+
+/* without vector registers the per-lane libm calls are the fastest option */
+inline Vec round(Vec x) {
+    Vec r;
+    for (size_t i = 0; i < LANES; i++) r.v[i] = std::round(x.v[i]);
+    return r;
+}
+
+inline Vec sin(Vec x) {
+    Vec r;
+    for (size_t i = 0; i < LANES; i++) r.v[i] = std::sin(x.v[i]);
+    return r;
+}
+
+#else
+
+/**
+ * @brief Round to the nearest integer, ties to even
+ *
+ * Uses the 1.5 * 2^52 bias trick, valid for |x| < 2^51, so every backend
+ * rounds identically without needing SSE4.1 or NEON rounding instructions.
+ */
+inline Vec roundEven(Vec x) {
+    const Vec bias = Vec::broadcast(6755399441055744.0);
+    return (x + bias) - bias;
+}
+
+/**
+ * @brief Round to the nearest integer, ties away from zero (std::round)
+ */
+inline Vec round(Vec x) {
+    const Vec zero = Vec::zero();
+    const Vec half = Vec::broadcast(0.5);
+    const Vec one = Vec::broadcast(1.0);
+
+    Vec r = roundEven(x);
+    Vec d = x - r;
+    r = select((d == half) & (x > zero), r + one, r);
+    r = select((d == zero - half) & (x < zero), r - one, r);
+    return r;
+}
+
+/**
+ * @brief Vectorized sine
+ *
+ * Reduces the argument by multiples of pi with a three-part Cody-Waite
+ * split and evaluates the Taylor series through x^23 on [-pi/2, pi/2],
+ * which keeps the result within a few ulp of std::sin for the phase ranges
+ * the operators produce.
+ */
+inline Vec sin(Vec x) {
+    const Vec invPi = Vec::broadcast(0.318309886183790671538);
+    const Vec pi1 = Vec::broadcast(3.14159265346825122833);
+    const Vec pi2 = Vec::broadcast(1.21542010126079319532e-10);
+    const Vec pi3 = Vec::broadcast(4.04453249759190126308e-21);
+
+    Vec k = roundEven(x * invPi);
+    Vec r = ((x - k * pi1) - k * pi2) - k * pi3;
+    Vec r2 = r * r;
+
+    Vec p = Vec::broadcast(-3.868170170630684e-23);
+    p = p * r2 + Vec::broadcast(1.9572941063391263e-20);
+    p = p * r2 + Vec::broadcast(-8.220635246624329e-18);
+    p = p * r2 + Vec::broadcast(2.8114572543455206e-15);
+    p = p * r2 + Vec::broadcast(-7.647163731819816e-13);
+    p = p * r2 + Vec::broadcast(1.6059043836821613e-10);
+    p = p * r2 + Vec::broadcast(-2.505210838544172e-08);
+    p = p * r2 + Vec::broadcast(2.7557319223985893e-06);
+    p = p * r2 + Vec::broadcast(-1.984126984126984e-04);
+    p = p * r2 + Vec::broadcast(8.333333333333333e-03);
+    p = p * r2 + Vec::broadcast(-1.6666666666666666e-01);
+    Vec s = r + r * r2 * p;
+
+    Vec halfK = k * Vec::broadcast(0.5);
+    Mask odd = halfK != roundEven(halfK);
+    return select(odd, Vec::zero() - s, s);
+}
+
+#endif
+
+}
+}
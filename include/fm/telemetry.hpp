@@ -0,0 +1,106 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace toybasic {
+
+/**
+ * @brief Render statistics over one polling window
+ */
+struct RenderStatistics {
+    uint64_t blocks = 0;
+    double minBlockMicroseconds = 0.0;
+    double averageBlockMicroseconds = 0.0;
+    double p99BlockMicroseconds = 0.0;
+    double maxBlockMicroseconds = 0.0;
+    /* render time as a share of the time the rendered audio lasts */
+    double dspLoadPercent = 0.0;
+    double peakDspLoadPercent = 0.0;
+    
+    /* totals since the telemetry was created */
+    uint64_t underruns = 0;
+    uint64_t overruns = 0;
+    uint64_t voiceSteals = 0;
+    int activeVoices = 0;
+};
+
+/**
+ * @brief Lock-free engine instrumentation
+ *
+ * The render thread records every block with a handful of relaxed atomic
+ * operations and never waits. Block times go into a log-linear histogram
+ * (16 steps per octave, about 6% resolution) so percentiles can be read
+ * without storing samples. Counters only ever grow; collect(), called from
+ * one polling thread, reports the difference since its previous call, so
+ * each poll describes the last window rather than the whole session.
+ */
+class RenderTelemetry {
+public:
+    RenderTelemetry();
+    
+    RenderTelemetry(const RenderTelemetry&) = delete;
+    RenderTelemetry& operator=(const RenderTelemetry&) = delete;
+    
+    void recordBlock(uint64_t renderNanoseconds, uint64_t deadlineNanoseconds);
+    void recordUnderrun() { underruns_.fetch_add(1, std::memory_order_relaxed); }
+    void recordOverrun() { overruns_.fetch_add(1, std::memory_order_relaxed); }
+    void recordVoiceSteal() { voiceSteals_.fetch_add(1, std::memory_order_relaxed); }
+    void setActiveVoices(int voices) { activeVoices_.store(voices, std::memory_order_relaxed); }
+    
+    RenderStatistics collect();
+    
+    static uint64_t now();
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    /* 2^36 ns is over a minute; slower blocks share the last bucket */
+    static constexpr int MAX_EXPONENT = 36;
+    static constexpr int BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    
+    static int bucketIndex(uint64_t nanoseconds);
+    static double bucketValue(int index);
+    
+    std::atomic<uint64_t> blocks_;
+    std::atomic<uint64_t> renderNanoseconds_;
+    std::atomic<uint64_t> deadlineNanoseconds_;
+    /* reset by collect(), so these cover one window */
+    std::atomic<uint64_t> minNanoseconds_;
+    std::atomic<uint64_t> maxNanoseconds_;
+    std::atomic<uint32_t> peakLoadPermille_;
+    std::array<std::atomic<uint32_t>, BUCKETS> histogram_;
+    
+    std::atomic<uint64_t> underruns_;
+    std::atomic<uint64_t> overruns_;
+    std::atomic<uint64_t> voiceSteals_;
+    std::atomic<int> activeVoices_;
+    
+    /* polling-thread copies of the counters at the previous collect() */
+    uint64_t lastBlocks_;
+    uint64_t lastRenderNanoseconds_;
+    uint64_t lastDeadlineNanoseconds_;
+    std::array<uint32_t, BUCKETS> lastHistogram_;
+};
+
+}
@@ -0,0 +1,229 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace toybasic {
+
+/**
+ * @brief Which sounding voice a note takes when every voice is busy
+ */
+enum class VoiceStealPolicy {
+    OLDEST = 0,         /* the note started longest ago */
+    QUIETEST = 1,       /* the lowest current carrier envelope level */
+    RELEASED_FIRST = 2  /* the quietest released note, else the oldest held one */
+};
+
+/**
+ * @brief Bookkeeping of which voice plays which note
+ *
+ * Busy and released voices are kept as bitmasks, so allocating takes the
+ * lowest free voice in a few word operations and walking the busy voices
+ * costs one step per busy voice rather than one per voice. Only voices
+ * below the limit are handed out; Voices is the capacity the storage is
+ * sized for. Each channel
+ * maps every note to the voice holding it and keeps a mask of its voices,
+ * so note-offs and channel-wide changes never scan the whole voice array.
+ * Nothing allocates after construction. Not thread-safe: everything is
+ * called from the render thread.
+ *
+ * @tparam Voices Number of voices
+ * @tparam Channels Number of channels
+ */
+template <size_t Voices, size_t Channels>
+class VoiceAllocator {
+public:
+    static constexpr int NONE = -1;
+    static constexpr int NOTES = 128;
+    
+    explicit VoiceAllocator(size_t limit = Voices) : limit_(limit) { reset(); }
+    
+    /**
+     * @brief Mark every voice free and forget every note
+     */
+    void reset() {
+        busy_.fill(0);
+        released_.fill(0);
+        for (auto& mask : channelVoices_) {
+            mask.fill(0);
+        }
+        for (auto& notes : noteVoices_) {
+            notes.fill(NONE);
+        }
+        slots_.fill(Slot{});
+        allocated_ = 0;
+        nextOrder_ = 0;
+    }
+    
+    /**
+     * @brief Take the lowest free voice for a note
+     * 
+     * @return The voice, or NONE if every voice is busy
+     */
+    int allocate(int channel, int note) {
+        for (size_t word = 0; word < WORDS; word++) {
+            const Word free = ~busy_[word] & limitBits(word);
+            if (free) {
+                const int voice = static_cast<int>(word * WORD_BITS) + std::countr_zero(free);
+                busy_[word] |= bit(voice);
+                allocated_++;
+                assign(voice, channel, note);
+                return voice;
+            }
+        }
+        return NONE;
+    }
+    
+    /**
+     * @brief Hand a busy voice over to another note
+     */
+    void reassign(int voice, int channel, int note) {
+        unmap(voice);
+        assign(voice, channel, note);
+    }
+    
+    /**
+     * @brief The key of a voice was released; the voice keeps sounding
+     */
+    void release(int voice) {
+        const int channel = slots_[voice].channel;
+        const int note = slots_[voice].note;
+        if (note != NONE && noteVoices_[channel][note] == voice) {
+            noteVoices_[channel][note] = NONE;
+        }
+        released_[voice / WORD_BITS] |= bit(voice);
+    }
+    
+    /**
+     * @brief A voice has gone silent and may be allocated again
+     */
+    void free(int voice) {
+        unmap(voice);
+        busy_[voice / WORD_BITS] &= ~bit(voice);
+        allocated_--;
+    }
+    
+    /**
+     * @brief Hand out only voices below limit from now on
+     * 
+     * Busy voices at or above the new limit stay busy until they are freed.
+     */
+    void setLimit(size_t limit) { limit_ = limit < Voices ? limit : Voices; }
+    size_t getLimit() const { return limit_; }
+    
+    /**
+     * @brief The voice holding a note, or NONE once the key is released
+     */
+    int find(int channel, int note) const {
+        return noteVoices_[channel][note];
+    }
+    
+    bool isReleased(int voice) const { return released_[voice / WORD_BITS] & bit(voice); }
+    int getChannel(int voice) const { return slots_[voice].channel; }
+    int getNote(int voice) const { return slots_[voice].note; }
+    /* increases with every note assigned, so smaller means older */
+    uint64_t getStartOrder(int voice) const { return slots_[voice].order; }
+    size_t getAllocatedCount() const { return allocated_; }
+    
+    /**
+     * @brief Call function(voice) for every busy voice, lowest index first
+     * 
+     * The voices are read up front, so function may free or reassign them.
+     */
+    template <typename Function>
+    void forEachAllocated(Function&& function) const {
+        for (size_t word = 0; word < WORDS; word++) {
+            forEachBit(word, busy_[word], function);
+        }
+    }
+    
+    /**
+     * @brief Call function(voice) for every busy voice of one channel
+     */
+    template <typename Function>
+    void forEachOnChannel(int channel, Function&& function) const {
+        for (size_t word = 0; word < WORDS; word++) {
+            forEachBit(word, channelVoices_[channel][word], function);
+        }
+    }
+
+private:
+    using Word = uint64_t;
+    static constexpr size_t WORD_BITS = 64;
+    static constexpr size_t WORDS = (Voices + WORD_BITS - 1) / WORD_BITS;
+    
+    struct Slot {
+        int channel = 0;
+        int note = NONE;
+        uint64_t order = 0;
+    };
+    
+    static Word bit(int voice) { return Word{1} << (voice % WORD_BITS); }
+    
+    Word limitBits(size_t word) const {
+        if (limit_ <= word * WORD_BITS) {
+            return 0;
+        }
+        const size_t bits = limit_ - word * WORD_BITS;
+        return bits >= WORD_BITS ? ~Word{0} : (Word{1} << bits) - 1;
+    }
+    
+    template <typename Function>
+    static void forEachBit(size_t word, Word bits, Function& function) {
+        while (bits) {
+            const int voice = static_cast<int>(word * WORD_BITS) + std::countr_zero(bits);
+            bits &= bits - 1;
+            function(voice);
+        }
+    }
+    
+    void assign(int voice, int channel, int note) {
+        Slot& slot = slots_[voice];
+        slot.channel = channel;
+        slot.note = note;
+        slot.order = nextOrder_++;
+        noteVoices_[channel][note] = static_cast<int16_t>(voice);
+        channelVoices_[channel][voice / WORD_BITS] |= bit(voice);
+        released_[voice / WORD_BITS] &= ~bit(voice);
+    }
+    
+    void unmap(int voice) {
+        const Slot& slot = slots_[voice];
+        if (slot.note != NONE && noteVoices_[slot.channel][slot.note] == voice) {
+            noteVoices_[slot.channel][slot.note] = NONE;
+        }
+        channelVoices_[slot.channel][voice / WORD_BITS] &= ~bit(voice);
+        released_[voice / WORD_BITS] &= ~bit(voice);
+    }
+    
+    size_t limit_;
+    std::array<Word, WORDS> busy_;
+    std::array<Word, WORDS> released_;
+    std::array<std::array<Word, WORDS>, Channels> channelVoices_;
+    std::array<std::array<int16_t, NOTES>, Channels> noteVoices_;
+    std::array<Slot, Voices> slots_;
+    size_t allocated_;
+    uint64_t nextOrder_;
+};
+
+}
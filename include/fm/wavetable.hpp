@@ -0,0 +1,83 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace toybasic {
+
+enum class WaveformType;
+
+/**
+ * @brief Band-limited single-cycle tables for the non-sine waveforms
+ *
+ * Each of sawtooth, square and triangle is stored as a mip chain: level k
+ * holds the waveform's Fourier series cut off after 2^k harmonics. An
+ * oscillator reads the richest level whose top harmonic still sits below
+ * Nyquist at its frequency, so high notes stop folding harmonics back into
+ * the audible band. The tables are built once per process and shared by
+ * every synthesizer instance; they are read-only afterwards.
+ */
+class BandLimitedWavetables {
+public:
+    static constexpr int SIZE = 2048;
+    static constexpr int LEVELS = 10;
+
+    static const BandLimitedWavetables& get();
+
+    static int levelForIncrement(double cyclesPerSample);
+
+    /**
+     * @brief Read one table with linear interpolation
+     *
+     * @param waveform SAWTOOTH, SQUARE or TRIANGLE
+     * @param level Mip level from levelForIncrement()
+     * @param position Phase in table samples; any value, wrapped to one cycle
+     */
+    float lookup(WaveformType waveform, int level, double position) const {
+        const float* samples = table(waveform, level);
+        double whole = std::floor(position);
+        size_t index = static_cast<size_t>(static_cast<int64_t>(whole)) & (SIZE - 1);
+        float fraction = static_cast<float>(position - whole);
+        return samples[index] + fraction * (samples[index + 1] - samples[index]);
+    }
+
+    BandLimitedWavetables(const BandLimitedWavetables&) = delete;
+    BandLimitedWavetables& operator=(const BandLimitedWavetables&) = delete;
+
+private:
+    static constexpr int SHAPES = 3;
+    /* one cycle plus a guard sample so interpolation never wraps */
+    static constexpr size_t STRIDE = SIZE + 1;
+
+    BandLimitedWavetables();
+
+    const float* table(WaveformType waveform, int level) const {
+        /* sine is computed directly, the tables start at sawtooth */
+        size_t shape = static_cast<size_t>(static_cast<int>(waveform) - 1);
+        return &tables_[(shape * LEVELS + static_cast<size_t>(level)) * STRIDE];
+    }
+
+    std::vector<float> tables_;
+};
+
+}
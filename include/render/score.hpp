@@ -0,0 +1,68 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace toybasic {
+
+/**
+ * @brief One timed performance event of an offline render
+ */
+struct ScoreEvent {
+    enum class Type {
+        NOTE_ON,
+        NOTE_OFF,
+        PITCH_BEND,
+        MODULATION_WHEEL,
+        ALL_NOTES_OFF
+    };
+    
+    double time;
+    Type type;
+    int channel;
+    int note;
+    double value;
+};
+
+/**
+ * @brief Time-ordered list of events to render
+ *
+ * Loaded from a Standard MIDI File or from a plain-text note list; see
+ * loadMidiFile() and loadTextScore() for the formats understood.
+ */
+class Score {
+public:
+    void add(const ScoreEvent& event);
+    void sort();
+    
+    const std::vector<ScoreEvent>& getEvents() const { return events_; }
+    double getEndTime() const;
+    
+    static Score load(const std::string& path);
+    static Score loadMidiFile(const std::string& path);
+    static Score loadTextScore(const std::string& path);
+
+private:
+    std::vector<ScoreEvent> events_;
+};
+
+}
@@ -0,0 +1,61 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace toybasic {
+
+/**
+ * @brief Streams interleaved 16-bit PCM to a RIFF/WAVE file
+ *
+ * The header is written with placeholder sizes on open and patched by
+ * close(), so the length does not need to be known up front.
+ */
+class WavWriter {
+public:
+    WavWriter(const std::string& path, int sampleRate, int channels);
+    ~WavWriter();
+    
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+    
+    void write(const int16_t* interleaved, size_t frames);
+    void close();
+    
+    size_t getFramesWritten() const { return framesWritten_; }
+
+private:
+    void writeHeader();
+    void writeWord(uint32_t value, int bytes);
+    
+    std::ofstream file_;
+    std::string path_;
+    int sampleRate_;
+    int channels_;
+    size_t framesWritten_;
+    /* little-endian staging buffer, reused across writes */
+    std::vector<char> bytes_;
+};
+
+}
@@ -3,6 +3,8 @@
 #include <QWidget>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QPixmap>
+#include <QFont>
 #include <QTimer>
 #include <set>
 #include <map>
@@ -29,6 +31,7 @@ signals:
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
@@ -42,14 +45,20 @@ private:
         QRect rect;
         bool isBlack;
         bool isActive;
+        QString label; // Octave label drawn on C keys, empty otherwise
     };
     
     void setupKeys();
     void updateActiveStates();
     KeyInfo* getKeyAt(const QPoint& pos);
-    void drawKey(QPainter& painter, const KeyInfo& key);
+    void drawKey(QPainter& painter, const KeyInfo& key, bool active);
+    void drawLabel(QPainter& painter, const KeyInfo& key);
+    void renderKeyboardCache();
     
     std::vector<KeyInfo> keys_;
+    QPixmap keyboardCache_; // Every key released, with labels; rebuilt when cacheValid_ is false
+    bool cacheValid_;
+    QFont labelFont_;
     std::set<int> activeNotes_;
     std::set<int> pressedNotes_; // Track notes that are currently pressed via mouse
     std::map<Qt::Key, int> keyToNoteMap_;
@@ -25,6 +25,7 @@
 #include <QColor>
 #include <QFont>
 #include <QFontMetrics>
+#include <QPixmap>
 #include <QSize>
 #include <QPoint>
 #include <QVector>
@@ -40,7 +41,7 @@
  * 
  * Displays the 32 different FM synthesis algorithms as visual graphs
  * showing operator connections, modulation paths, and feedback loops.
- * Each algorithm is rendered exactly as shown in the reference image.
+ * Layouts are derived from the same routing table the render kernels use.
  */
 class OperatorGraphWidget : public QWidget
 {
@@ -65,6 +66,7 @@ public:
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 private:
     /**
@@ -106,6 +108,14 @@ private:
         QSize gridSize;       // Size of the operator grid
     };
 
+    /**
+     * @brief Rendered diagram of one algorithm at the current widget size
+     */
+    struct Diagram {
+        QPixmap pixmap;       // Covers only the area the diagram draws on
+        QPoint origin;        // Widget position of the pixmap's top left corner
+    };
+
     /**
      * @brief Initialize all 32 algorithm layouts
      */
@@ -124,6 +134,25 @@ private:
      */
     void calculatePositions(AlgorithmLayout& layout);
 
+    /**
+     * @brief Draw the whole diagram of an algorithm, without the background
+     * @param painter QPainter object
+     * @param algorithm Algorithm number (0-31)
+     */
+    void drawAlgorithm(QPainter& painter, int algorithm);
+
+    /**
+     * @brief Render an algorithm's diagram for the current size and theme
+     * @param algorithm Algorithm number (0-31)
+     * @return Diagram covering the area the algorithm draws on
+     */
+    Diagram renderDiagram(int algorithm);
+
+    /**
+     * @brief Drop every cached diagram, so each is rendered again on next use
+     */
+    void invalidateDiagrams();
+
     /**
      * @brief Draw an operator at the specified position
      * @param painter QPainter object
@@ -164,6 +193,9 @@ private:
 
     int currentAlgorithm_;
     std::array<AlgorithmLayout, 32> algorithms_;
+    std::array<Diagram, 32> diagrams_;
+    QSize diagramSize_;       // Widget size the cached diagrams were rendered at
+    qreal diagramRatio_;      // Device pixel ratio they were rendered at
     QSize operatorSize_;
     QSize gridSpacing_;
     QPen connectionPen_;
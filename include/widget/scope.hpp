@@ -0,0 +1,102 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QWidget>
+#include <QTimer>
+#include <QColor>
+#include <array>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+#include "../fm/scope.hpp"
+#include "../theme/theme.hpp"
+
+/**
+ * @brief Oscilloscope, spectrum and operator level display of the engine output
+ * 
+ * Polls a ScopeTap at display rate from the GUI thread, so the audio thread
+ * never waits on the display. The FFT and the reduction of the waveform and
+ * spectrum to one value per pixel column are done here, when a new snapshot
+ * arrives; paintEvent() only draws the reduced columns. The tap is enabled
+ * only while the widget is shown.
+ */
+class ScopeWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ScopeWidget(toybasic::ScopeTap& tap, QWidget *parent = nullptr);
+    ~ScopeWidget();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    /**
+     * @brief Take the newest snapshot from the tap and reduce it if it is new
+     */
+    void pollTap();
+
+    /**
+     * @brief Compute the magnitude spectrum of a snapshot in dB
+     */
+    void computeSpectrum(const toybasic::ScopeSnapshot& snapshot);
+
+    /**
+     * @brief Reduce the current waveform and spectrum to the widget's pixel columns
+     */
+    void decimate();
+
+    QRect waveformRect() const;
+    QRect spectrumRect() const;
+    QRect levelsRect() const;
+
+    toybasic::ScopeTap& tap_;
+    QTimer *refreshTimer_;
+    uint64_t lastSequence_;
+    int sampleRate_;
+
+    std::vector<float> waveform_;                // Triggered, mono, SCOPE_FRAMES frames
+    std::vector<float> spectrum_;                // dB per FFT bin, with peak decay
+    std::array<float, toybasic::Algorithms::OPERATORS> operatorLevels_;
+
+    std::vector<float> fftWindow_;               // Hann window
+    std::vector<std::complex<float>> twiddles_;
+    std::vector<std::complex<float>> fftBuffer_;
+
+    std::vector<std::pair<float, float>> waveformColumns_;  // Min and max per pixel column
+    std::vector<float> spectrumColumns_;                    // Peak dB per pixel column
+
+    ThemeManager& themeManager_;
+
+    static constexpr int REFRESH_INTERVAL_MS = 33;
+    static constexpr size_t FFT_SIZE = toybasic::ScopeSnapshot::FRAMES;
+    static constexpr size_t SCOPE_FRAMES = toybasic::ScopeSnapshot::FRAMES / 2;
+    static constexpr float MIN_DB = -96.0f;
+    static constexpr float MAX_DB = 0.0f;
+    static constexpr float PEAK_DECAY_DB = 3.0f;  // Per refresh
+    static constexpr float MIN_FREQUENCY = 20.0f;
+    static constexpr int LEVELS_WIDTH = 72;
+    static constexpr int SPACING = 6;
+};
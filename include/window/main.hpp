@@ -32,6 +32,7 @@
 #include <QTabWidget>
 #include <QSpinBox>
 #include <QDoubleSpinBox>
+#include <bitset>
 #include <memory>
 #include <map>
 #include <set>
@@ -40,7 +41,10 @@
 #include "../fm/presets.hpp"
 #include "../widget/keyboard.hpp"
 #include "../widget/operator.hpp"
+#include "../widget/scope.hpp"
 #include "../fm/fm.hpp"
+#include "../fm/midiinput.hpp"
+#include "../fm/output.hpp"
 
 class MainWindow : public QMainWindow
 {
@@ -49,6 +53,8 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    
+    void enableRealtimeMode(const toybasic::RealtimeConfig &config);
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -68,6 +74,8 @@ private slots:
     void onModWheelChanged(int value);
     void onOperatorParameterChanged();
     void refreshInternalsTab();
+    void updateTelemetry();
+    void updateMidiNotes();
     void onOctaveChanged(int octave);
     void onKeyboardKeyPressed(int note);
     void onKeyboardKeyReleased(int note);
@@ -82,6 +90,7 @@ private:
     void noteOn(int note);
     void noteOff(int note);
     void allNotesOff();
+    void showActiveNotes();
     toybasic::FMSynthesizer* getCurrentSynthesizer();
 
     QWidget *centralWidget_;
@@ -89,13 +98,19 @@ private:
     QHBoxLayout *controlsLayout_;
     
     
-    std::vector<std::unique_ptr<toybasic::FMSynthesizer>> synthesizers_;
+    std::vector<std::shared_ptr<toybasic::FMSynthesizer>> synthesizers_;
     int currentSynthesizerIndex_;
     
+    std::unique_ptr<toybasic::FMSynthesizerManager> synthManager_;
+    std::unique_ptr<toybasic::QtAudioOutput> audioOutput_;
+    /* plays the current synthesizer, so it is destroyed before the synthesizers */
+    std::unique_ptr<toybasic::MidiInput> midiInput_;
+    
     std::unique_ptr<toybasic::PresetManager> presetManager_;
     
     KeyboardWidget *keyboardWidget_;
     OperatorGraphWidget *operatorGraphWidget_;
+    ScopeWidget *scopeWidget_;
     
     QGroupBox *octaveGroup_;
     QSpinBox *octaveSpinBox_;
@@ -123,13 +138,21 @@ private:
     QSpinBox *audioMaxSpinBox_;
     QSpinBox *audioMinSpinBox_;
     QDoubleSpinBox *audioScaleSpinBox_;
+    QComboBox *bufferSizeCombo_;
+    QLabel *outputFormatLabel_;
+    QComboBox *ditherCombo_;
+    QComboBox *dacStageCombo_;
+    QComboBox *oscillatorModeCombo_;
+    QComboBox *oversamplingCombo_;
     QSpinBox *midiA4NoteSpinBox_;
     QDoubleSpinBox *midiA4FreqSpinBox_;
     QSpinBox *midiNotesSpinBox_;
+    QComboBox *midiInputCombo_;
     QSpinBox *maxVoicesSpinBox_;
     QSpinBox *maxOpsSpinBox_;
     QSpinBox *maxChannelsSpinBox_;
     QSpinBox *maxAlgsSpinBox_;
+    QComboBox *stealPolicyCombo_;
     QDoubleSpinBox *minEnvTimeSpinBox_;
     QDoubleSpinBox *maxEnvTimeSpinBox_;
     QDoubleSpinBox *minVolumeSpinBox_;
@@ -147,10 +170,24 @@ private:
     
     QTimer *pitchBendReturnTimer_;
     
+    QLabel *blockTimeLabel_;
+    QLabel *dspLoadLabel_;
+    QLabel *underrunsLabel_;
+    QLabel *overrunsLabel_;
+    QLabel *activeVoicesLabel_;
+    QLabel *voiceStealsLabel_;
+    QLabel *realtimeLabel_;
+    QTimer *telemetryTimer_;
+    QTimer *midiNotesTimer_;
+    
     std::map<Qt::Key, int> keyToNoteMap_;
     std::set<int> activeNotes_;
+    /* notes held on the MIDI port when the keyboard was last drawn */
+    std::bitset<toybasic::Constants::MIDI_NOTE_COUNT> midiNotes_;
     int currentChannel_;
     
     static constexpr int OCTAVE_START = 60;
     static constexpr int NOTES_PER_OCTAVE = 12;
+    static constexpr int TELEMETRY_INTERVAL_MS = 250;
+    static constexpr int MIDI_NOTES_INTERVAL_MS = 30;
 };
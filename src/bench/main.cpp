@@ -0,0 +1,368 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fm/fm.hpp"
+#include "fm/presets.hpp"
+
+namespace {
+
+constexpr int DEFAULT_VOICES = 8;
+constexpr int SYNTHETIC_PATCH = -1;
+constexpr std::array<int, 7> VOICE_COUNTS = {1, 4, 8, 16, 32, 64, 128};
+constexpr std::array<toybasic::WaveformType, 4> WAVEFORMS = {
+    toybasic::WaveformType::SINE, toybasic::WaveformType::SAWTOOTH,
+    toybasic::WaveformType::SQUARE, toybasic::WaveformType::TRIANGLE
+};
+constexpr double EFFECT_AMOUNT = 0.3;
+
+struct BenchOptions {
+    std::string format = "json";
+    std::vector<std::string> suites = {"algorithm", "waveform", "voices", "effects", "preset"};
+    int sampleRate = toybasic::Constants::DEFAULT_SAMPLE_RATE;
+    int blockSize = toybasic::Constants::DEFAULT_BLOCK_SIZE;
+    double duration = 1.0;
+    int repeat = 3;
+    toybasic::OscillatorMode oscillatorMode = toybasic::OscillatorMode::FLOATING_POINT;
+    int oversampling = 1;
+};
+
+/* one point of the benchmark matrix; preset SYNTHETIC_PATCH uses the fixed test patch */
+struct BenchCase {
+    std::string suite;
+    int algorithm;
+    toybasic::WaveformType waveform;
+    int voices;
+    bool effects;
+    int preset;
+};
+
+struct BenchResult {
+    BenchCase benchCase;
+    std::string presetName;
+    double nsPerSample;
+    double realtimeFactor;
+    double voicesPerCore;
+};
+
+const char* waveformName(toybasic::WaveformType waveform) {
+    switch (waveform) {
+        case toybasic::WaveformType::SINE: return "sine";
+        case toybasic::WaveformType::SAWTOOTH: return "sawtooth";
+        case toybasic::WaveformType::SQUARE: return "square";
+        case toybasic::WaveformType::TRIANGLE: return "triangle";
+    }
+    return "unknown";
+}
+
+/* presets choose a waveform per operator, so their rows have none of their own */
+const char* waveformName(const BenchCase& benchCase) {
+    if (benchCase.preset != SYNTHETIC_PATCH) {
+        return "preset";
+    }
+    return waveformName(benchCase.waveform);
+}
+
+/**
+ * @brief Apply the fixed test patch used by every suite except "preset"
+ * 
+ * Every operator sustains at full level, so no operator is ever skipped as
+ * silent and each case measures the full cost of its algorithm.
+ */
+void applySyntheticPatch(toybasic::FMSynthesizer& synth, const BenchCase& benchCase) {
+    const std::array<double, 6> frequencies = {1.0, 1.0, 2.0, 2.0, 3.0, 0.5};
+    std::array<double, 6> amplitudes;
+    std::array<double, 6> modulationIndices;
+    std::array<toybasic::WaveformType, 6> waveforms;
+    std::array<double, 6> attacks;
+    std::array<double, 6> decays;
+    std::array<double, 6> sustains;
+    std::array<double, 6> releases;
+    amplitudes.fill(0.5);
+    modulationIndices.fill(1.0);
+    waveforms.fill(benchCase.waveform);
+    attacks.fill(toybasic::Constants::MIN_ENVELOPE_TIME);
+    decays.fill(0.1);
+    sustains.fill(toybasic::Constants::MAX_VOLUME);
+    releases.fill(0.3);
+    
+    synth.setAlgorithm(0, benchCase.algorithm);
+    synth.setPresetConfig(frequencies, amplitudes, modulationIndices, waveforms,
+                          attacks, decays, sustains, releases);
+    const double effect = benchCase.effects ? EFFECT_AMOUNT : toybasic::Constants::MIN_EFFECT_AMOUNT;
+    synth.setReverb(effect);
+    synth.setChorus(effect);
+    synth.setDistortion(effect);
+}
+
+/**
+ * @brief Time one case
+ * 
+ * The voices are started and rendered past their attack before timing
+ * starts. The best of several runs is reported, as it is the least
+ * disturbed by the rest of the system.
+ */
+BenchResult runCase(const BenchCase& benchCase, const BenchOptions& options, const toybasic::PresetManager& presets) {
+    toybasic::FMSynthesizer synth(options.sampleRate);
+    BenchResult result{benchCase, "", 0.0, 0.0, 0.0};
+    if (benchCase.preset == SYNTHETIC_PATCH) {
+        applySyntheticPatch(synth, benchCase);
+    } else {
+        presets.applyPreset(synth, 0, benchCase.preset);
+        result.presetName = std::string(presets.getPreset(benchCase.preset).getName());
+    }
+    synth.setOscillatorMode(options.oscillatorMode);
+    synth.setOversampling(options.oversampling);
+    synth.setMaxVoices(benchCase.voices);
+    /* a step of 3 is coprime to 128, so every voice gets its own note */
+    for (int voice = 0; voice < benchCase.voices; voice++) {
+        synth.noteOn((48 + voice * 3) % toybasic::Constants::MIDI_NOTE_COUNT, 0.8);
+    }
+    
+    const size_t block = static_cast<size_t>(options.blockSize);
+    std::vector<float> left(block);
+    std::vector<float> right(block);
+    for (size_t frame = 0; frame < static_cast<size_t>(options.sampleRate / 10); frame += block) {
+        synth.renderBlock(left.data(), right.data(), block);
+    }
+    
+    const size_t frames = std::max(block, static_cast<size_t>(options.duration * options.sampleRate) / block * block);
+    double best = std::numeric_limits<double>::infinity();
+    volatile float sink = 0.0f;
+    for (int run = 0; run < options.repeat; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < frames; frame += block) {
+            synth.renderBlock(left.data(), right.data(), block);
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        sink = sink + left[0] + right[block - 1];
+    }
+    
+    result.nsPerSample = best * 1e9 / frames;
+    result.realtimeFactor = (static_cast<double>(frames) / options.sampleRate) / best;
+    result.voicesPerCore = benchCase.voices * result.realtimeFactor;
+    return result;
+}
+
+std::vector<BenchCase> buildCases(const std::string& suite, const toybasic::PresetManager& presets) {
+    using toybasic::WaveformType;
+    std::vector<BenchCase> cases;
+    if (suite == "algorithm") {
+        for (int algorithm = 0; algorithm < toybasic::Constants::MAX_ALGORITHMS; algorithm++) {
+            cases.push_back({suite, algorithm, WaveformType::SINE, DEFAULT_VOICES, false, SYNTHETIC_PATCH});
+        }
+    } else if (suite == "waveform") {
+        for (WaveformType waveform : WAVEFORMS) {
+            cases.push_back({suite, 0, waveform, DEFAULT_VOICES, false, SYNTHETIC_PATCH});
+        }
+    } else if (suite == "voices") {
+        for (int voices : VOICE_COUNTS) {
+            cases.push_back({suite, 0, WaveformType::SINE, voices, false, SYNTHETIC_PATCH});
+        }
+    } else if (suite == "effects") {
+        for (bool effects : {false, true}) {
+            cases.push_back({suite, 0, WaveformType::SINE, DEFAULT_VOICES, effects, SYNTHETIC_PATCH});
+        }
+    } else if (suite == "preset") {
+        for (int preset = 0; preset < presets.getPresetCount(); preset++) {
+            cases.push_back({suite, presets.getPreset(preset).algorithm, WaveformType::SINE, DEFAULT_VOICES, false, preset});
+        }
+    } else {
+        throw std::invalid_argument("Unknown suite: " + suite);
+    }
+    return cases;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void writeJson(const std::vector<BenchResult>& results, const BenchOptions& options) {
+    std::printf("{\n");
+    std::printf("  \"backend\": \"%s\",\n", toybasic::simd::BACKEND);
+    std::printf("  \"oscillator\": \"%s\",\n",
+                options.oscillatorMode == toybasic::OscillatorMode::FIXED_POINT ? "fixed" : "float");
+    std::printf("  \"oversampling\": %d,\n", options.oversampling);
+    std::printf("  \"sample_rate\": %d,\n", options.sampleRate);
+    std::printf("  \"block_size\": %d,\n", options.blockSize);
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        const BenchCase& benchCase = result.benchCase;
+        std::printf("    {\"suite\": \"%s\", \"algorithm\": %d, \"waveform\": \"%s\", \"voices\": %d, "
+                    "\"effects\": %s, \"preset\": %s, \"ns_per_sample\": %.2f, "
+                    "\"realtime_factor\": %.2f, \"voices_per_core\": %.1f}%s\n",
+                    benchCase.suite.c_str(), benchCase.algorithm + 1, waveformName(benchCase),
+                    benchCase.voices, benchCase.effects ? "true" : "false",
+                    result.presetName.empty() ? "null" : jsonString(result.presetName).c_str(),
+                    result.nsPerSample, result.realtimeFactor, result.voicesPerCore,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+void writeCsv(const std::vector<BenchResult>& results, const BenchOptions& options) {
+    const char* oscillator = options.oscillatorMode == toybasic::OscillatorMode::FIXED_POINT ? "fixed" : "float";
+    std::printf("suite,algorithm,waveform,voices,effects,preset,backend,oscillator,oversampling,ns_per_sample,realtime_factor,voices_per_core\n");
+    for (const BenchResult& result : results) {
+        const BenchCase& benchCase = result.benchCase;
+        std::printf("%s,%d,%s,%d,%d,%s,%s,%s,%d,%.2f,%.2f,%.1f\n",
+                    benchCase.suite.c_str(), benchCase.algorithm + 1, waveformName(benchCase),
+                    benchCase.voices, benchCase.effects ? 1 : 0, result.presetName.c_str(),
+                    toybasic::simd::BACKEND, oscillator, options.oversampling,
+                    result.nsPerSample, result.realtimeFactor, result.voicesPerCore);
+    }
+}
+
+void printUsage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "\n"
+        "Times the synthesis engine without any audio output and prints the\n"
+        "results as JSON or CSV. ns_per_sample is the cost of one stereo output\n"
+        "frame; voices_per_core is how many voices one core renders in real time.\n"
+        "\n"
+        "Options:\n"
+        "  -s, --suite <list>        Comma-separated suites to run (default all):\n"
+        "                            algorithm, waveform, voices, effects, preset\n"
+        "  -f, --format <json|csv>   Output format (default json)\n"
+        "  -d, --duration <seconds>  Audio rendered per run (default 1)\n"
+        "  -n, --repeat <runs>       Runs per case, best is reported (default 3)\n"
+        "  -r, --rate <hz>           Sample rate (default %d)\n"
+        "  -b, --block <frames>      Frames per render call (default %d)\n"
+        "  -o, --oscillator <mode>   'float' or 'fixed' (default float)\n"
+        "  -x, --oversample <1|2|4>  Operator oversampling factor (default 1)\n"
+        "  -h, --help                Show this help\n",
+        program, toybasic::Constants::DEFAULT_SAMPLE_RATE, toybasic::Constants::DEFAULT_BLOCK_SIZE);
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+}
+
+/**
+ * @brief Entry point of the engine benchmark
+ */
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-s" || arg == "--suite") {
+            options.suites = splitList(value());
+        } else if (arg == "-f" || arg == "--format") {
+            options.format = value();
+        } else if (arg == "-d" || arg == "--duration") {
+            options.duration = std::atof(value().c_str());
+        } else if (arg == "-n" || arg == "--repeat") {
+            options.repeat = std::atoi(value().c_str());
+        } else if (arg == "-r" || arg == "--rate") {
+            options.sampleRate = std::atoi(value().c_str());
+        } else if (arg == "-b" || arg == "--block") {
+            options.blockSize = std::atoi(value().c_str());
+        } else if (arg == "-o" || arg == "--oscillator") {
+            const std::string mode = value();
+            if (mode == "fixed") {
+                options.oscillatorMode = toybasic::OscillatorMode::FIXED_POINT;
+            } else if (mode != "float") {
+                std::fprintf(stderr, "Unknown oscillator mode: %s\n", mode.c_str());
+                return 2;
+            }
+        } else if (arg == "-x" || arg == "--oversample") {
+            options.oversampling = std::atoi(value().c_str());
+        } else {
+            std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    
+    if ((options.format != "json" && options.format != "csv") || options.duration <= 0.0 || options.repeat < 1 ||
+        options.sampleRate <= 0 || options.blockSize < 1 || options.blockSize > toybasic::Constants::MAX_BLOCK_SIZE ||
+        (options.oversampling != 1 && options.oversampling != 2 && options.oversampling != 4)) {
+        std::fprintf(stderr, "Invalid format, duration, repeat count, sample rate, block size or oversampling factor\n");
+        return 2;
+    }
+    
+    try {
+        toybasic::PresetManager presets;
+        std::vector<BenchCase> cases;
+        for (const std::string& suite : options.suites) {
+            std::vector<BenchCase> suiteCases = buildCases(suite, presets);
+            cases.insert(cases.end(), suiteCases.begin(), suiteCases.end());
+        }
+        
+        std::vector<BenchResult> results;
+        for (size_t i = 0; i < cases.size(); i++) {
+            std::fprintf(stderr, "\r[%zu/%zu] %s", i + 1, cases.size(), cases[i].suite.c_str());
+            results.push_back(runCase(cases[i], options, presets));
+        }
+        std::fprintf(stderr, "\n");
+        
+        if (options.format == "csv") {
+            writeCsv(results, options);
+        } else {
+            writeJson(results, options);
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
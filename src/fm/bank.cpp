@@ -0,0 +1,338 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/bank.hpp"
+#include "fm/presets.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace toybasic {
+
+namespace {
+
+/* records start right after the header, which keeps them 8-byte aligned */
+constexpr uint64_t RECORDS_OFFSET = sizeof(PresetBank::Header);
+
+size_t indexSlotsFor(size_t count) {
+    /* keep the table at most half full so probes stay short */
+    size_t slots = 1;
+    while (slots < count * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+/* a copy of preset with every padding and unused name byte zeroed, so the
+   same presets always produce the same bank file */
+FMPresetConfig canonicalRecord(const FMPresetConfig& preset) {
+    FMPresetConfig record;
+    std::memset(&record, 0, sizeof(record));
+    record.setName(preset.getName());
+    record.algorithm = preset.algorithm;
+    record.categories = preset.categories;
+    for (size_t op = 0; op < record.operators.size(); op++) {
+        record.operators[op].frequency = preset.operators[op].frequency;
+        record.operators[op].amplitude = preset.operators[op].amplitude;
+        record.operators[op].modulationIndex = preset.operators[op].modulationIndex;
+        record.operators[op].waveform = preset.operators[op].waveform;
+        record.operators[op].attack = preset.operators[op].attack;
+        record.operators[op].decay = preset.operators[op].decay;
+        record.operators[op].sustain = preset.operators[op].sustain;
+        record.operators[op].release = preset.operators[op].release;
+    }
+    record.masterVolume = preset.masterVolume;
+    record.reverb = preset.reverb;
+    record.chorus = preset.chorus;
+    record.distortion = preset.distortion;
+    record.feedback = preset.feedback;
+    return record;
+}
+
+}
+
+/**
+ * @brief Map a bank file and check that it can be used in place
+ *
+ * @param path Bank file to open
+ * @throws std::runtime_error if the file cannot be mapped or is not a valid
+ *         bank for this build
+ */
+PresetBank::PresetBank(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        throw std::runtime_error(path + " is not a preset bank");
+    }
+    mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mappingHandle_ == nullptr) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    mapping_ = MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+    if (mapping_ == nullptr) {
+        CloseHandle(mappingHandle_);
+        mappingHandle_ = nullptr;
+        throw std::runtime_error("Cannot map " + path);
+    }
+    mappingSize_ = static_cast<size_t>(size.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(file);
+        throw std::runtime_error(path + " is not a preset bank");
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    mapping_ = mapping;
+    mappingSize_ = static_cast<size_t>(info.st_size);
+#endif
+
+    try {
+        validate(path);
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+    
+    const auto* header = static_cast<const Header*>(mapping_);
+    const auto* bytes = static_cast<const uint8_t*>(mapping_);
+    records_ = reinterpret_cast<const FMPresetConfig*>(bytes + header->recordsOffset);
+    recordCount_ = static_cast<size_t>(header->recordCount);
+    index_ = reinterpret_cast<const uint32_t*>(bytes + header->indexOffset);
+    indexSlots_ = static_cast<size_t>(header->indexSlots);
+}
+
+PresetBank::~PresetBank() {
+    close();
+}
+
+PresetBank::PresetBank(PresetBank&& other) noexcept {
+    *this = std::move(other);
+}
+
+PresetBank& PresetBank::operator=(PresetBank&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(mapping_, other.mapping_);
+        std::swap(mappingSize_, other.mappingSize_);
+#if defined(_WIN32)
+        std::swap(mappingHandle_, other.mappingHandle_);
+#endif
+        std::swap(records_, other.records_);
+        std::swap(recordCount_, other.recordCount_);
+        std::swap(index_, other.index_);
+        std::swap(indexSlots_, other.indexSlots_);
+    }
+    return *this;
+}
+
+/**
+ * @brief Unmap the bank; every record pointer it handed out becomes invalid
+ */
+void PresetBank::close() {
+    if (mapping_ != nullptr) {
+#if defined(_WIN32)
+        UnmapViewOfFile(mapping_);
+        CloseHandle(mappingHandle_);
+        mappingHandle_ = nullptr;
+#else
+        ::munmap(mapping_, mappingSize_);
+#endif
+    }
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    records_ = nullptr;
+    recordCount_ = 0;
+    index_ = nullptr;
+    indexSlots_ = 0;
+}
+
+/**
+ * @brief Check the header, the bounds of both arrays and every record
+ *
+ * Everything the renderer indexes with a preset field is range-checked
+ * here, so a damaged bank fails to open instead of misbehaving later.
+ */
+void PresetBank::validate(const std::string& path) const {
+    const auto* header = static_cast<const Header*>(mapping_);
+    if (header->magic != MAGIC) {
+        throw std::runtime_error(path + " is not a preset bank");
+    }
+    if (header->version != VERSION) {
+        throw std::runtime_error(path + ": unsupported preset bank version " + std::to_string(header->version));
+    }
+    if (header->byteOrder != ENDIAN_TAG || header->recordSize != sizeof(FMPresetConfig)) {
+        throw std::runtime_error(path + " was written with a different byte order or record layout");
+    }
+    
+    const uint64_t size = mappingSize_;
+    const uint64_t count = header->recordCount;
+    const uint64_t slots = header->indexSlots;
+    if (count >= UINT32_MAX || slots <= count || (slots & (slots - 1)) != 0 ||
+        header->recordsOffset % alignof(FMPresetConfig) != 0 || header->indexOffset % alignof(uint32_t) != 0 ||
+        header->recordsOffset < sizeof(Header) || header->recordsOffset > size ||
+        count > (size - header->recordsOffset) / sizeof(FMPresetConfig) ||
+        header->indexOffset > size || slots > (size - header->indexOffset) / sizeof(uint32_t)) {
+        throw std::runtime_error(path + ": preset bank is truncated or corrupt");
+    }
+    
+    const auto* bytes = static_cast<const uint8_t*>(mapping_);
+    const auto* records = reinterpret_cast<const FMPresetConfig*>(bytes + header->recordsOffset);
+    for (uint64_t i = 0; i < count; i++) {
+        /* read the enum through its underlying bytes so an out-of-range
+           value is caught before it is ever loaded as a WaveformType */
+        const FMPresetConfig& record = records[i];
+        bool valid = std::memchr(record.name.data(), '\0', record.name.size()) != nullptr &&
+                     record.algorithm >= 0 && record.algorithm < Constants::MAX_ALGORITHMS;
+        for (const auto& op : record.operators) {
+            int waveform;
+            std::memcpy(&waveform, &op.waveform, sizeof(waveform));
+            valid = valid && waveform >= static_cast<int>(WaveformType::SINE) &&
+                    waveform <= static_cast<int>(WaveformType::TRIANGLE);
+        }
+        if (!valid) {
+            throw std::runtime_error(path + ": invalid preset record " + std::to_string(i));
+        }
+    }
+    
+    const auto* index = reinterpret_cast<const uint32_t*>(bytes + header->indexOffset);
+    for (uint64_t slot = 0; slot < slots; slot++) {
+        if (index[slot] > count) {
+            throw std::runtime_error(path + ": invalid preset name index");
+        }
+    }
+}
+
+/**
+ * @brief Write presets to a bank file that PresetBank can map
+ *
+ * @param path File to create or replace
+ * @param presets Records to store, in order
+ * @param count Number of records
+ * @throws std::runtime_error if the file cannot be written
+ */
+void PresetBank::write(const std::string& path, const FMPresetConfig* presets, size_t count) {
+    const std::vector<uint32_t> index = buildIndex(presets, count);
+    
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.byteOrder = ENDIAN_TAG;
+    header.recordSize = sizeof(FMPresetConfig);
+    header.recordCount = count;
+    header.indexSlots = index.size();
+    header.recordsOffset = RECORDS_OFFSET;
+    header.indexOffset = RECORDS_OFFSET + count * sizeof(FMPresetConfig);
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < count; i++) {
+        const FMPresetConfig record = canonicalRecord(presets[i]);
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    file.write(reinterpret_cast<const char*>(index.data()),
+               static_cast<std::streamsize>(index.size() * sizeof(uint32_t)));
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+/**
+ * @brief 32-bit FNV-1a hash of a preset name
+ */
+uint32_t PresetBank::hashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Build the name index for an array of presets
+ *
+ * When several presets share a name only the first is indexed, so lookups
+ * find the same preset a front-to-back search would.
+ */
+std::vector<uint32_t> PresetBank::buildIndex(const FMPresetConfig* presets, size_t count) {
+    std::vector<uint32_t> index(indexSlotsFor(count), 0);
+    const size_t mask = index.size() - 1;
+    for (size_t i = 0; i < count; i++) {
+        const std::string_view name = presets[i].getName();
+        size_t slot = hashName(name) & mask;
+        while (index[slot] != 0 && presets[index[slot] - 1].getName() != name) {
+            slot = (slot + 1) & mask;
+        }
+        if (index[slot] == 0) {
+            index[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Look up a preset by name in an index built by buildIndex()
+ *
+ * @return The preset's position in presets, or -1 if no preset has the name
+ */
+int PresetBank::findName(const FMPresetConfig* presets, const uint32_t* index, size_t indexSlots,
+                         std::string_view name) {
+    const size_t mask = indexSlots - 1;
+    size_t slot = hashName(name) & mask;
+    for (size_t probe = 0; probe < indexSlots && index[slot] != 0; probe++) {
+        const uint32_t entry = index[slot] - 1;
+        if (presets[entry].getName() == name) {
+            return static_cast<int>(entry);
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+}
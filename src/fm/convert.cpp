@@ -0,0 +1,152 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/convert.hpp"
+#include "fm/fm.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace toybasic {
+
+const char* sampleFormatName(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::INT16:
+            return "16-bit integer";
+        case SampleFormat::INT32:
+            return "32-bit integer";
+        case SampleFormat::FLOAT32:
+            return "32-bit float";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Constructor for SampleConverter
+ * 
+ * Dither starts enabled and the DAC stage disabled.
+ * 
+ * @param format The format convert() writes
+ */
+SampleConverter::SampleConverter(SampleFormat format)
+    : format_(format), dither_(true), dacEmulation_(false), random_(0x9e3779b9u) {
+}
+
+size_t SampleConverter::bytesPerSample(SampleFormat format) {
+    return format == SampleFormat::INT16 ? sizeof(int16_t) : sizeof(int32_t);
+}
+
+uint32_t SampleConverter::nextRandom() {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return random_;
+}
+
+/**
+ * @brief Convert one block of planar float audio to interleaved samples
+ * 
+ * Full scale is +-1.0 in, the full range of the format out.
+ * 
+ * @param left Left channel, frames samples
+ * @param right Right channel, frames samples
+ * @param frames Number of frames
+ * @param interleaved Destination for frames * 2 samples, aligned for the format
+ */
+void SampleConverter::convert(const float* left, const float* right, size_t frames, void* interleaved) {
+    const bool dac = getDacEmulation();
+    switch (format_) {
+        case SampleFormat::INT16:
+            convertFrames(left, right, frames, static_cast<int16_t*>(interleaved),
+                          32768.0, -32768.0, 32767.0, dac, !dac && getDither());
+            break;
+        case SampleFormat::INT32:
+            convertFrames(left, right, frames, static_cast<int32_t*>(interleaved),
+                          2147483648.0, -2147483648.0, 2147483647.0, dac, false);
+            break;
+        case SampleFormat::FLOAT32:
+            convertFrames(left, right, frames, static_cast<float*>(interleaved),
+                          1.0, -1.0, 1.0, dac, false);
+            break;
+    }
+}
+
+/**
+ * @brief The conversion kernel, LANES frames per step
+ * 
+ * @param scale Output value of full scale
+ * @param minValue Lowest output value
+ * @param maxValue Highest output value
+ * @param dac Quantize to the emulated 14-bit DAC range first
+ * @param dither Add TPDF dither of one output step before rounding
+ */
+template <typename Sample>
+void SampleConverter::convertFrames(const float* left, const float* right, size_t frames, Sample* interleaved,
+                                    double scale, double minValue, double maxValue, bool dac, bool dither) {
+    constexpr bool INTEGER = std::is_integral_v<Sample>;
+    constexpr double TO_UNIT = 1.0 / 4294967296.0;
+    
+    const simd::Vec dacScale = simd::Vec::broadcast(Constants::AUDIO_SCALE);
+    const simd::Vec dacMin = simd::Vec::broadcast(Constants::AUDIO_MIN_VALUE);
+    const simd::Vec dacMax = simd::Vec::broadcast(Constants::AUDIO_MAX_VALUE);
+    /* the DAC's most negative code is full scale */
+    const simd::Vec dacOutput = simd::Vec::broadcast(scale / -Constants::AUDIO_MIN_VALUE);
+    const simd::Vec outputScale = simd::Vec::broadcast(scale);
+    const simd::Vec lowest = simd::Vec::broadcast(minValue);
+    const simd::Vec highest = simd::Vec::broadcast(maxValue);
+    
+    auto clamp = [](simd::Vec x, simd::Vec low, simd::Vec high) {
+        x = simd::select(x < low, low, x);
+        return simd::select(x > high, high, x);
+    };
+    
+    alignas(simd::ALIGNMENT) double channels[2][simd::LANES];
+    alignas(simd::ALIGNMENT) double noise[simd::LANES];
+    for (size_t frame = 0; frame < frames; frame += simd::LANES) {
+        const size_t count = std::min(simd::LANES, frames - frame);
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            channels[0][lane] = lane < count ? left[frame + lane] : 0.0;
+            channels[1][lane] = lane < count ? right[frame + lane] : 0.0;
+        }
+        
+        for (auto& channel : channels) {
+            simd::Vec x = simd::Vec::load(channel);
+            if (dac) {
+                x = clamp(simd::round(x * dacScale), dacMin, dacMax) * dacOutput;
+            } else {
+                x = x * outputScale;
+            }
+            if (dither) {
+                for (double& value : noise) {
+                    value = (static_cast<double>(nextRandom()) - static_cast<double>(nextRandom())) * TO_UNIT;
+                }
+                x = x + simd::Vec::load(noise);
+            }
+            if (INTEGER) {
+                x = simd::round(x);
+            }
+            clamp(x, lowest, highest).store(channel);
+        }
+        
+        for (size_t lane = 0; lane < count; lane++) {
+            interleaved[(frame + lane) * 2] = static_cast<Sample>(channels[0][lane]);
+            interleaved[(frame + lane) * 2 + 1] = static_cast<Sample>(channels[1][lane]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/device.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace toybasic {
+
+/**
+ * @brief Constructor for FMAudioDevice
+ * 
+ * @param source The render source that produces audio for each read
+ * @param format The sample format the sink was opened with
+ * @param parent Parent QObject
+ */
+FMAudioDevice::FMAudioDevice(AudioRenderSource& source, SampleFormat format, QObject* parent)
+    : QIODevice(parent), source_(source), converter_(format) {
+}
+
+/**
+ * @brief Report how much audio can be read
+ * 
+ * The device synthesizes on demand, so there is always at least one full
+ * block available to the sink.
+ * 
+ * @return Number of bytes that can be read without blocking
+ */
+qint64 FMAudioDevice::bytesAvailable() const {
+    return static_cast<qint64>(Constants::MAX_BLOCK_SIZE * converter_.getBytesPerFrame()) + QIODevice::bytesAvailable();
+}
+
+/**
+ * @brief Render one block ahead of the next read
+ * 
+ * Called while the sink is suspended, just before it resumes, so the first
+ * read after a long idle period finds its first block ready instead of
+ * waiting for a render on cold caches. Must not run concurrently with
+ * readData().
+ */
+void FMAudioDevice::preroll() {
+    source_.renderBlock(left_.data(), right_.data(), Constants::MAX_BLOCK_SIZE);
+    converter_.convert(left_.data(), right_.data(), Constants::MAX_BLOCK_SIZE, prerolled_.data());
+    prerollOffset_ = 0;
+    prerollBytes_ = Constants::MAX_BLOCK_SIZE * converter_.getBytesPerFrame();
+}
+
+/**
+ * @brief Render audio requested by the sink
+ * 
+ * Renders as many whole stereo frames as fit in maxSize, a block at a time.
+ * Each block is converted straight into the sink's buffer when it is
+ * suitably aligned, and through a small scratch buffer otherwise. A
+ * prerolled block is handed out first.
+ * 
+ * @param data Destination buffer provided by the sink
+ * @param maxSize Size of the destination buffer in bytes
+ * @return Number of bytes written
+ */
+qint64 FMAudioDevice::readData(char* data, qint64 maxSize) {
+    const size_t bytesPerFrame = converter_.getBytesPerFrame();
+    const size_t sampleBytes = SampleConverter::bytesPerSample(converter_.getFormat());
+    const size_t frames = static_cast<size_t>(maxSize) / bytesPerFrame;
+    const bool aligned = reinterpret_cast<uintptr_t>(data) % sampleBytes == 0;
+    
+    size_t remaining = frames;
+    char* out = data;
+    if (prerollBytes_ > 0) {
+        const size_t bytes = std::min(prerollBytes_, frames * bytesPerFrame);
+        std::memcpy(out, reinterpret_cast<const char*>(prerolled_.data()) + prerollOffset_, bytes);
+        prerollOffset_ += bytes;
+        prerollBytes_ -= bytes;
+        out += bytes;
+        remaining -= bytes / bytesPerFrame;
+    }
+    while (remaining > 0) {
+        size_t chunk = std::min(remaining, static_cast<size_t>(Constants::MAX_BLOCK_SIZE));
+        source_.renderBlock(left_.data(), right_.data(), chunk);
+        if (aligned) {
+            converter_.convert(left_.data(), right_.data(), chunk, out);
+        } else {
+            converter_.convert(left_.data(), right_.data(), chunk, scratch_.data());
+            std::memcpy(out, scratch_.data(), chunk * bytesPerFrame);
+        }
+        out += chunk * bytesPerFrame;
+        remaining -= chunk;
+    }
+    
+    return static_cast<qint64>(frames * bytesPerFrame);
+}
+
+qint64 FMAudioDevice::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+
+}
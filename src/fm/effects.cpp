@@ -0,0 +1,348 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/effects.hpp"
+#include "fm/fm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace toybasic {
+
+namespace {
+    constexpr double TWO_PI = 6.28318530717958647692;
+}
+
+/* a power of two so positions wrap with a mask; one spare sample for the interpolation */
+size_t StereoChorus::lineSize(int sampleRate) {
+    size_t size = 1;
+    while (size < static_cast<size_t>(std::ceil((DELAY + SWEEP) * sampleRate)) + 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/**
+ * @brief Allocate the delay line, long enough for MAX_SAMPLE_RATE
+ */
+StereoChorus::StereoChorus() : line_(lineSize(Constants::MAX_SAMPLE_RATE), 0.0) {
+}
+
+/**
+ * @brief Set the delay and LFO for a sample rate
+ *
+ * Only the part of the line the rate needs is used, so nothing is
+ * allocated; must still not run concurrently with process().
+ */
+void StereoChorus::setSampleRate(int sampleRate) {
+    delay_ = DELAY * sampleRate;
+    sweep_ = SWEEP * sampleRate;
+    mask_ = lineSize(sampleRate) - 1;
+    
+    rotateSin_ = std::sin(TWO_PI * RATE / sampleRate);
+    rotateCos_ = std::cos(TWO_PI * RATE / sampleRate);
+    reset();
+}
+
+void StereoChorus::reset() {
+    std::fill_n(line_.begin(), mask_ + 1, 0.0);
+    writePos_ = 0;
+    lfoSin_ = 0.0;
+    lfoCos_ = 1.0;
+}
+
+/**
+ * @brief Lock the delay line in memory
+ */
+void StereoChorus::lockBuffers(RealtimeStatus& status) const {
+    lockMemory(status, line_);
+}
+
+/**
+ * @brief Run one block of the send through the chorus
+ *
+ * @param input Mono send, frames samples
+ * @param left Left bus the left tap is added to
+ * @param right Right bus the right tap is added to
+ * @param frames Number of frames
+ */
+void StereoChorus::process(const double* input, double* left, double* right, size_t frames) {
+    const double size = static_cast<double>(mask_ + 1);
+    auto tap = [&](double delay) {
+        double position = static_cast<double>(writePos_) + size - delay;
+        double whole = std::floor(position);
+        size_t index = static_cast<size_t>(whole) & mask_;
+        double fraction = position - whole;
+        return line_[index] + fraction * (line_[(index + 1) & mask_] - line_[index]);
+    };
+    
+    for (size_t frame = 0; frame < frames; frame++) {
+        line_[writePos_] = input[frame];
+        left[frame] += tap(delay_ + sweep_ * lfoSin_);
+        right[frame] += tap(delay_ + sweep_ * lfoCos_);
+        writePos_ = (writePos_ + 1) & mask_;
+        
+        const double sin = lfoSin_ * rotateCos_ + lfoCos_ * rotateSin_;
+        lfoCos_ = lfoCos_ * rotateCos_ - lfoSin_ * rotateSin_;
+        lfoSin_ = sin;
+    }
+    
+    /* pull the phasor back onto the unit circle so rounding cannot grow it */
+    const double norm = (3.0 - (lfoSin_ * lfoSin_ + lfoCos_ * lfoCos_)) * 0.5;
+    lfoSin_ *= norm;
+    lfoCos_ *= norm;
+}
+
+/**
+ * @brief Allocate the delay lines, long enough for MAX_SAMPLE_RATE
+ *
+ * Each line gets NUDGE_MARGIN spare samples for setSampleRate() to make
+ * the lengths mutually prime.
+ */
+FeedbackDelayReverb::FeedbackDelayReverb() {
+    for (int line = 0; line < LINES; line++) {
+        lines_[line].assign(static_cast<size_t>(std::lround(LENGTHS[line] * Constants::MAX_SAMPLE_RATE)) + NUDGE_MARGIN, 0.0);
+    }
+}
+
+/**
+ * @brief Set the delay line lengths for a sample rate
+ *
+ * Line lengths follow the sample rate so the room sounds the same at any
+ * rate, and are nudged to be mutually prime so their echoes never line up.
+ * Only the part of each line the rate needs is used, so nothing is
+ * allocated; must still not run concurrently with process().
+ */
+void FeedbackDelayReverb::setSampleRate(int sampleRate) {
+    size_t longest = 0;
+    for (int line = 0; line < LINES; line++) {
+        size_t length = std::max<size_t>(1, static_cast<size_t>(std::lround(LENGTHS[line] * sampleRate)));
+        bool coprime = false;
+        while (!coprime && length < lines_[line].size()) {
+            coprime = true;
+            for (int other = 0; other < line; other++) {
+                if (std::gcd(length, lengths_[other]) != 1) {
+                    coprime = false;
+                    length++;
+                    break;
+                }
+            }
+        }
+        lengths_[line] = length;
+        feedback_[line] = std::pow(10.0, -3.0 * static_cast<double>(length) / (DECAY_TIME * sampleRate));
+        longest = std::max(longest, length);
+    }
+    /* down about 90 dB by the end of the tail */
+    tailFrames_ = static_cast<size_t>(1.5 * DECAY_TIME * sampleRate) + longest;
+    reset();
+}
+
+void FeedbackDelayReverb::reset() {
+    for (int line = 0; line < LINES; line++) {
+        std::fill_n(lines_[line].begin(), lengths_[line], 0.0);
+    }
+    positions_.fill(0);
+    lowpass_.fill(0.0);
+}
+
+/**
+ * @brief Lock the delay lines in memory
+ */
+void FeedbackDelayReverb::lockBuffers(RealtimeStatus& status) const {
+    for (const auto& line : lines_) {
+        lockMemory(status, line);
+    }
+}
+
+/**
+ * @brief Run one block of the send through the network
+ *
+ * @param input Mono send, frames samples
+ * @param left Left bus the even lines are added to
+ * @param right Right bus the odd lines are added to
+ * @param frames Number of frames
+ */
+void FeedbackDelayReverb::process(const double* input, double* left, double* right, size_t frames) {
+    /* the Hadamard butterflies below gain sqrt(LINES) */
+    static constexpr double MIX_SCALE = 0.35355339059327376220;
+    static_assert(LINES == 8, "MIX_SCALE and the butterflies assume eight lines");
+    static constexpr double INPUT_GAIN = 0.25;
+    static constexpr double OUTPUT_GAIN = RETURN_GAIN * 0.5;
+    
+    std::array<double, LINES> taps;
+    for (size_t frame = 0; frame < frames; frame++) {
+        for (int line = 0; line < LINES; line++) {
+            taps[line] = lines_[line][positions_[line]];
+        }
+        left[frame] += (taps[0] + taps[2] + taps[4] + taps[6]) * OUTPUT_GAIN;
+        right[frame] += (taps[1] + taps[3] + taps[5] + taps[7]) * OUTPUT_GAIN;
+        
+        for (int span = 1; span < LINES; span <<= 1) {
+            for (int line = 0; line < LINES; line += span << 1) {
+                for (int i = line; i < line + span; i++) {
+                    const double a = taps[i];
+                    const double b = taps[i + span];
+                    taps[i] = a + b;
+                    taps[i + span] = a - b;
+                }
+            }
+        }
+        
+        const double in = input[frame] * INPUT_GAIN;
+        for (int line = 0; line < LINES; line++) {
+            const double decayed = taps[line] * MIX_SCALE * feedback_[line];
+            lowpass_[line] = decayed + DAMPING * (lowpass_[line] - decayed);
+            lines_[line][positions_[line]] = lowpass_[line] + in;
+            if (++positions_[line] == lengths_[line]) {
+                positions_[line] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Create bus effects set up for a sample rate
+ */
+BusEffects::BusEffects(int sampleRate) {
+    setSampleRate(sampleRate);
+}
+
+/**
+ * @brief Retune every effect for a new sample rate and silence the tails
+ *
+ * Allocates nothing, since the buffers are sized for MAX_SAMPLE_RATE
+ * upfront, so the render thread can call it between blocks; it must not
+ * run concurrently with process().
+ * 
+ * @param sampleRate The new rate, at most Constants::MAX_SAMPLE_RATE
+ */
+void BusEffects::setSampleRate(int sampleRate) {
+    sampleRate = std::clamp(sampleRate, Constants::MIN_SAMPLE_RATE, Constants::MAX_SAMPLE_RATE);
+    chorus_.setSampleRate(sampleRate);
+    reverb_.setSampleRate(sampleRate);
+    chorusState_ = {};
+    reverbState_ = {};
+    chorusSend_.fill(0.0);
+    reverbSend_.fill(0.0);
+}
+
+/**
+ * @brief Start a block; clears whatever was sent to the previous one
+ */
+void BusEffects::beginBlock() {
+    if (chorusState_.sending) {
+        std::fill(chorusSend_.begin(), chorusSend_.end(), 0.0);
+        chorusState_.sending = false;
+    }
+    if (reverbState_.sending) {
+        std::fill(reverbSend_.begin(), reverbSend_.end(), 0.0);
+        reverbState_.sending = false;
+    }
+}
+
+/**
+ * @brief Add one source to the sends
+ *
+ * The stereo source is folded to mono through its bus gains and added at
+ * each send level; a zero level sends nothing and costs nothing.
+ *
+ * @param left Left channel of the source
+ * @param right Right channel of the source
+ * @param frames Number of frames
+ * @param leftGain Gain of the source's left channel on the bus
+ * @param rightGain Gain of the source's right channel on the bus
+ * @param chorus Chorus send level
+ * @param reverb Reverb send level
+ * @param offset Frame of the block the source starts at
+ */
+void BusEffects::addSend(const double* left, const double* right, size_t frames,
+                         double leftGain, double rightGain, double chorus, double reverb, size_t offset) {
+    if (chorus > 0.0) {
+        const double l = leftGain * chorus * 0.5;
+        const double r = rightGain * chorus * 0.5;
+        double* send = chorusSend_.data() + offset;
+        for (size_t frame = 0; frame < frames; frame++) {
+            send[frame] += left[frame] * l + right[frame] * r;
+        }
+        chorusState_.sending = true;
+    }
+    if (reverb > 0.0) {
+        const double l = leftGain * reverb * 0.5;
+        const double r = rightGain * reverb * 0.5;
+        double* send = reverbSend_.data() + offset;
+        for (size_t frame = 0; frame < frames; frame++) {
+            send[frame] += left[frame] * l + right[frame] * r;
+        }
+        reverbState_.sending = true;
+    }
+}
+
+/**
+ * @brief Whether an effect has to run for this block
+ *
+ * A send restarts the tail; without one the effect rings out on silence
+ * for the rest of its tail.
+ */
+bool BusEffects::shouldRun(SendState& state, size_t tailFrames, size_t frames) {
+    if (state.sending) {
+        state.tailRemaining = tailFrames;
+        return true;
+    }
+    if (state.tailRemaining == 0) {
+        return false;
+    }
+    state.tailRemaining = state.tailRemaining > frames ? state.tailRemaining - frames : 0;
+    return true;
+}
+
+/**
+ * @brief Add the effect returns for this block to the bus
+ *
+ * An effect whose tail has just ended is cleared once, so the next send
+ * starts from silence and the effect can stay off until then.
+ *
+ * @param left Left channel of the bus
+ * @param right Right channel of the bus
+ * @param frames Number of frames
+ */
+void BusEffects::process(double* left, double* right, size_t frames) {
+    if (shouldRun(chorusState_, chorus_.getTailFrames(), frames)) {
+        chorus_.process(chorusSend_.data(), left, right, frames);
+        if (chorusState_.tailRemaining == 0) {
+            chorus_.reset();
+        }
+    }
+    if (shouldRun(reverbState_, reverb_.getTailFrames(), frames)) {
+        reverb_.process(reverbSend_.data(), left, right, frames);
+        if (reverbState_.tailRemaining == 0) {
+            reverb_.reset();
+        }
+    }
+}
+
+/**
+ * @brief Lock the effect delay lines in memory
+ *
+ * The send buffers are part of the object and are locked with its owner.
+ */
+void BusEffects::lockBuffers(RealtimeStatus& status) const {
+    chorus_.lockBuffers(status);
+    reverb_.lockBuffers(status);
+}
+
+}
@@ -23,6 +23,7 @@
 #include <chrono>
 #include <thread>
 #include <condition_variable>
+#include <cstdio>
 
 namespace toybasic {
 
@@ -31,18 +32,20 @@ namespace toybasic {
  * 
  * Creates a new FM synthesizer with the specified sample rate. Initializes
  * all operators, voices, channels, and audio parameters to their default values.
- * Sets up the audio thread and sample buffer.
+ * Sets up the sample buffer; no audio device is opened, so synthesizers are
+ * cheap to create and are played through a QtAudioOutput.
  * 
  * @param sampleRate The audio sample rate in Hz (default: 44100)
  */
 FMSynthesizer::FMSynthesizer(int sampleRate) 
-    : sampleRate_(sampleRate), masterVolume_(Constants::MAX_VOLUME), timeStep_(1.0 / sampleRate),
+    : sampleRate_(sampleRate), masterVolume_(Constants::MAX_VOLUME), controlSampleRate_(sampleRate),
       reverbAmount_(Constants::MIN_EFFECT_AMOUNT), chorusAmount_(Constants::MIN_EFFECT_AMOUNT), 
       distortionAmount_(Constants::MIN_EFFECT_AMOUNT),
+      oscillatorMode_(OscillatorMode::FLOATING_POINT), renderOscillatorMode_(OscillatorMode::FLOATING_POINT),
+      stealPolicy_(VoiceStealPolicy::RELEASED_FIRST), allocator_(Constants::DEFAULT_VOICES),
       audioThreadRunning_(false), shouldStop_(false),
       sampleBuffer_(BUFFER_SIZE * 2), bufferWritePos_(0), bufferReadPos_(0),
       sampleStream_(std::make_unique<FMSampleStream>()),
-      audioIODevice_(nullptr), audioSink_(nullptr),
       freqPrecisionBits_(Constants::FREQ_PRECISION_BITS),
       freqPrecisionScale_(Constants::FREQ_PRECISION_SCALE),
       freqPrecisionInv_(Constants::FREQ_PRECISION_INV),
@@ -53,7 +56,7 @@ FMSynthesizer::FMSynthesizer(int sampleRate)
       midiA4Note_(Constants::MIDI_A4_NOTE),
       midiA4Frequency_(Constants::MIDI_A4_FREQUENCY),
       midiNotesPerOctave_(Constants::MIDI_NOTES_PER_OCTAVE),
-      maxVoices_(Constants::MAX_VOICES),
+      maxVoices_(Constants::DEFAULT_VOICES),
       maxOperators_(Constants::MAX_OPERATORS),
       maxChannels_(Constants::MAX_CHANNELS),
       maxAlgorithms_(Constants::MAX_ALGORITHMS),
@@ -73,20 +76,44 @@ FMSynthesizer::FMSynthesizer(int sampleRate)
       panLeft_(Constants::PAN_LEFT),
       panCenter_(Constants::PAN_CENTER),
       panRight_(Constants::PAN_RIGHT),
-      panScale_(Constants::PAN_SCALE) {
+      panScale_(Constants::PAN_SCALE),
+      preset_(new VoiceTemplate), pendingPreset_(nullptr),
+      retiredPresets_(RETIRED_PRESET_CAPACITY), events_(Constants::EVENT_QUEUE_CAPACITY),
+      inputEvents_(Constants::EVENT_QUEUE_CAPACITY), idle_(sampleRate), wakeSignal_(&idle_),
+      busEffects_(sampleRate) {
     
     for (int i = 0; i < 6; i++) {
-        currentPreset_.frequencies[i] = 1.0;
-        currentPreset_.amplitudes[i] = 0.5;
-        currentPreset_.modulationIndices[i] = 0.0;
-        currentPreset_.waveforms[i] = WaveformType::SINE;
-        currentPreset_.attacks[i] = 0.01;
-        currentPreset_.decays[i] = 0.1;
-        currentPreset_.sustains[i] = 0.7;
-        currentPreset_.releases[i] = 0.3;
+        preset_->operators[i].frequency = 1.0;
+        preset_->amplitudes[i] = 0.5;
+        preset_->modulationIndices[i] = 0.0;
     }
+    compileVoiceTemplate(*preset_, sampleRate);
+    pitchBendSmoothing_ = pitchBendSmoothing(sampleRate);
     
-    setupAudio();
+    for (int note = 0; note < Constants::MIDI_NOTE_COUNT; note++) {
+        noteFrequencies_[note] = noteToFrequency22Bit(note);
+    }
+    
+    const Operator defaults;
+    for (auto& lanes : lanes_) {
+        lanes.phaseAccumulator.fill(0.0);
+        lanes.phaseIncrement.fill(calculatePhaseIncrement22Bit(defaults.frequency));
+        lanes.amplitude.fill(0.5);
+        lanes.modulationIndex.fill(1.0);
+        lanes.envelopeLevel.fill(0.0);
+        lanes.envelopeRate.fill(0.0);
+        lanes.envelopeRemaining.fill(ENVELOPE_HOLD);
+        lanes.envelopeState.fill(static_cast<int>(EnvelopeState::OFF));
+        lanes.phase.fill(0);
+    }
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
+            updatePhaseStep(op, voice);
+        }
+    }
+    feedback_.level.fill(0.0);
+    feedback_.previous.fill(0.0);
+    feedback_.previous2.fill(0.0);
 }
 
 /**
@@ -96,115 +123,449 @@ FMSynthesizer::FMSynthesizer(int sampleRate)
  */
 FMSynthesizer::~FMSynthesizer() {
     stopAudioThread();
+    freeRetiredPresets();
+    delete pendingPreset_.load(std::memory_order_acquire);
+    delete preset_;
+}
+
+/**
+ * @brief Trigger a note on event
+ * 
+ * Queues the note for the renderer, which starts it at the beginning of its
+ * next block. Like every other control change below, this never touches
+ * render state directly, so it may be called from one control thread (the
+ * UI) while another thread renders. If the queue is full the event is
+ * dropped.
+ * 
+ * @param note The MIDI note number to play
+ * @param velocity The note velocity (0.0 to 1.0), a linear gain on the voice
+ */
+void FMSynthesizer::noteOn(int note, double velocity) {
+    if (note >= 0 && note < Constants::MIDI_NOTE_COUNT) {
+        postEvent(SynthEvent::Type::NOTE_ON, 0, note, {velocity});
+    }
 }
 
-void FMSynthesizer::setupAudio() {
-    QAudioFormat format;
-    format.setSampleRate(sampleRate_);
-    format.setChannelCount(2);
-    format.setSampleFormat(QAudioFormat::Int16);
+/**
+ * @brief Trigger a note off event
+ * 
+ * Queues the release of the voice holding the specified note.
+ * 
+ * @param note The MIDI note number to stop
+ */
+void FMSynthesizer::noteOff(int note) {
+    if (note >= 0 && note < Constants::MIDI_NOTE_COUNT) {
+        postEvent(SynthEvent::Type::NOTE_OFF, 0, note);
+    }
+}
 
-    QAudioDevice device = QMediaDevices::defaultAudioOutput();
-    if (device.isNull()) {
-        printf("No audio output device found\n");
-        return;
+/**
+ * @brief Stop all currently playing notes
+ * 
+ * Queues the release of all voices.
+ */
+void FMSynthesizer::allNotesOff() {
+    postEvent(SynthEvent::Type::ALL_NOTES_OFF);
+}
+
+/**
+ * @brief Queue a control change for the renderer (control thread only)
+ * 
+ * @param type What to change
+ * @param target The channel or voice to change
+ * @param index The note, operator or algorithm
+ * @param values The new value(s)
+ */
+void FMSynthesizer::postEvent(SynthEvent::Type type, int target, int index, std::array<double, 4> values) {
+    if (events_.push(SynthEvent{type, target, index, values})) {
+        wakeSignal_.load(std::memory_order_acquire)->notify();
     }
+}
 
-    if (!device.isFormatSupported(format)) {
-        printf("Audio format not supported, using nearest supported format\n");
-        format = device.preferredFormat();
+/**
+ * @brief Queue an event from a real-time input thread
+ * 
+ * The input queue has its own single producer, so one MIDI (or other
+ * input) thread can play the engine directly, without going through the
+ * control thread or contending with it. The event is applied on the frame
+ * it is due at; the block being rendered is split there, so its timing does
+ * not depend on the block size. Events must be posted in frame order.
+ * 
+ * @param event The event, with frame set from getClock(); 0 plays it as
+ *              soon as possible
+ * @return false if the queue was full and the event was dropped
+ */
+bool FMSynthesizer::postInputEvent(const SynthEvent& event) {
+    if (!inputEvents_.push(event)) {
+        return false;
     }
+    wakeSignal_.load(std::memory_order_acquire)->notify();
+    return true;
+}
 
-    audioSink_ = new QAudioSink(device, format);
-    
-    audioIODevice_ = audioSink_->start();
+/**
+ * @brief Whether a voice plays or an event waits to be applied (render thread only)
+ * 
+ * Voices are counted at the start of the last block, so a voice that
+ * finished in it counts for one more, silent, block.
+ */
+bool FMSynthesizer::hasPendingWork() const {
+    return !events_.empty() || !inputEvents_.empty() || hasHeldEvent_ || activeVoiceCount_ > 0;
+}
 
-    if (audioSink_->state() != QAudio::ActiveState) {
-        printf("Failed to start audio output\n");
-        return;
+/**
+ * @brief Apply every queued control change and the input events now due (render thread only)
+ * 
+ * Called at the start of each block, before any voice is rendered, so a
+ * block is always rendered from one consistent set of parameters. The first
+ * input event stamped for a later frame is held back, and ends the block
+ * being started at its frame (see beginBlock()).
+ */
+void FMSynthesizer::processEvents() {
+    SynthEvent event;
+    while (events_.pop(event)) {
+        applyEvent(event);
+    }
+    if (hasHeldEvent_) {
+        if (heldEvent_.frame > renderedFrames_) {
+            return;
+        }
+        applyEvent(heldEvent_);
+        hasHeldEvent_ = false;
+    }
+    while (inputEvents_.pop(event)) {
+        if (event.frame > renderedFrames_) {
+            heldEvent_ = event;
+            hasHeldEvent_ = true;
+            return;
+        }
+        applyEvent(event);
     }
+}
 
-    printf("Audio setup completed successfully\n");
+void FMSynthesizer::applyEvent(const SynthEvent& event) {
+    const double value = event.values[0];
+    switch (event.type) {
+        case SynthEvent::Type::NOTE_ON:
+            startNote(event.target, event.index, value);
+            break;
+        case SynthEvent::Type::NOTE_OFF:
+            releaseNote(event.target, event.index);
+            break;
+        case SynthEvent::Type::ALL_NOTES_OFF:
+            releaseAllNotes();
+            break;
+        case SynthEvent::Type::CHANNEL_ACTIVE:
+            channels_[event.target].active = event.index != 0;
+            break;
+        case SynthEvent::Type::ALGORITHM:
+            channels_[event.target].algorithm = event.index;
+            break;
+        case SynthEvent::Type::FEEDBACK:
+            applyFeedback(event.target, value);
+            break;
+        case SynthEvent::Type::PITCH_BEND:
+            applyPitchBend(event.target, value);
+            break;
+        case SynthEvent::Type::MODULATION_WHEEL:
+            channels_[event.target].modulationWheel = value;
+            break;
+        case SynthEvent::Type::MASTER_VOLUME:
+            masterVolume_ = value;
+            break;
+        case SynthEvent::Type::REVERB:
+            reverbAmount_ = value;
+            break;
+        case SynthEvent::Type::CHORUS:
+            chorusAmount_ = value;
+            break;
+        case SynthEvent::Type::DISTORTION:
+            distortionAmount_ = value;
+            break;
+        case SynthEvent::Type::OPERATOR_FREQUENCY:
+            voices_[event.target].operators[event.index].frequency = value;
+            lanes_[event.index].phaseIncrement[event.target] = calculatePhaseIncrement22Bit(value);
+            updatePhaseStep(event.index, event.target);
+            break;
+        case SynthEvent::Type::OPERATOR_AMPLITUDE:
+            lanes_[event.index].amplitude[event.target] = value;
+            break;
+        case SynthEvent::Type::OPERATOR_MODULATION_INDEX:
+            lanes_[event.index].modulationIndex[event.target] = value;
+            break;
+        case SynthEvent::Type::OPERATOR_WAVEFORM:
+            voices_[event.target].operators[event.index].waveform = static_cast<WaveformType>(static_cast<int>(value));
+            break;
+        case SynthEvent::Type::ENVELOPE: {
+            Operator& op = voices_[event.target].operators[event.index];
+            op.attack = event.values[0];
+            op.decay = event.values[1];
+            op.sustain = event.values[2];
+            op.release = event.values[3];
+            updateEnvelopeRates(event.target, event.index);
+            break;
+        }
+        case SynthEvent::Type::PRESET:
+            swapPreset();
+            break;
+        case SynthEvent::Type::VOICE_LIMIT:
+            applyVoiceLimit(event.index);
+            break;
+        case SynthEvent::Type::SAMPLE_RATE:
+            applySampleRate(event.index);
+            break;
+    }
 }
 
 /**
- * @brief Trigger a note on event
+ * @brief Start a note on a free voice (render thread only)
  * 
- * Starts playing a note on the synthesizer. Finds an available voice and
- * configures it with the note parameters. If no voices are available,
- * steals voice 0.
+ * A note that is already held on the channel is released first, so each
+ * key holds at most one voice. When every voice is busy, one is chosen by
+ * the steal policy and faded out over VOICE_STEAL_FADE_TIME instead of
+ * being cut off; the new note starts on it once it is silent.
  * 
+ * @param channel The channel to play on
  * @param note The MIDI note number to play
  * @param velocity The note velocity (0.0 to 1.0)
  */
-void FMSynthesizer::noteOn(int note, double velocity) {
-    int voice = findFreeVoice();
-    if (voice == -1) {
-        voice = 0;
-        releaseVoice(0);
+void FMSynthesizer::startNote(int channel, int note, double velocity) {
+    const int held = allocator_.find(channel, note);
+    if (held != allocator_.NONE) {
+        releaseVoice(held);
+    }
+    
+    int voice = allocator_.allocate(channel, note);
+    if (voice != allocator_.NONE) {
+        voices_[voice].channel = channel;
+        playNote(voice, note, velocity);
+        return;
     }
     
-    voices_[voice].active = true;
-    voices_[voice].note = note;
-    voices_[voice].velocity = velocity;
-    voices_[voice].channel = 0;
+    voice = chooseVoiceToSteal(stealPolicy_.load(std::memory_order_relaxed));
+    telemetry_.recordVoiceSteal();
+    if (voices_[voice].pendingNote < 0) {
+        fadeOutVoice(voice);
+    }
+    allocator_.reassign(voice, channel, note);
+    voices_[voice].pendingNote = note;
+    voices_[voice].pendingVelocity = velocity;
+}
+
+/**
+ * @brief Configure a voice from the current voice template and start its attack
+ * 
+ * The template's operators are copied as a block and scaled to the note's
+ * frequency. The channel's algorithm is latched too, so a preset change
+ * never reroutes a note that is already sounding.
+ * 
+ * @param voice The voice to play on; its channel must already be set
+ * @param note The MIDI note number to play
+ * @param velocity The note velocity (0.0 to 1.0)
+ */
+void FMSynthesizer::playNote(int voice, int note, double velocity) {
+    Voice& v = voices_[voice];
+    v.active = true;
+    v.note = note;
+    v.velocity = velocity;
+    v.pendingNote = -1;
     
-    double baseFreq = noteToFrequency22Bit(note);
+    const VoiceTemplate& preset = *preset_;
+    const Channel& channel = channels_[v.channel];
+    v.algorithm = channel.algorithm;
+    v.operators = preset.operators;
+    const double baseFreq = noteFrequencies_[note];
     for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-        voices_[voice].operators[op].frequency = baseFreq * currentPreset_.frequencies[op];
-        voices_[voice].operators[op].amplitude = currentPreset_.amplitudes[op];
-        voices_[voice].operators[op].modulationIndex = currentPreset_.modulationIndices[op];
-        voices_[voice].operators[op].waveform = currentPreset_.waveforms[op];
-        voices_[voice].operators[op].attack = currentPreset_.attacks[op];
-        voices_[voice].operators[op].decay = currentPreset_.decays[op];
-        voices_[voice].operators[op].sustain = currentPreset_.sustains[op];
-        voices_[voice].operators[op].release = currentPreset_.releases[op];
+        Operator& config = v.operators[op];
+        config.frequency *= baseFreq;
         
-        voices_[voice].operators[op].phaseIncrement = calculatePhaseIncrement22Bit(voices_[voice].operators[op].frequency);
-        voices_[voice].operators[op].envelopeState = static_cast<int>(EnvelopeState::ATTACK);
-        voices_[voice].operators[op].envelopeTime = 0.0;
-        voices_[voice].operators[op].envelopeLevel = 0.0;
+        OperatorLanes& lanes = lanes_[op];
+        lanes.amplitude[voice] = preset.amplitudes[op];
+        lanes.modulationIndex[voice] = preset.modulationIndices[op];
+        lanes.phaseIncrement[voice] = calculatePhaseIncrement22Bit(config.frequency);
+        updatePhaseStep(op, voice);
+        lanes.envelopeLevel[voice] = 0.0;
+        lanes.envelopeState[voice] = static_cast<int>(EnvelopeState::ATTACK);
+        lanes.envelopeRate[voice] = config.attackRate;
+        lanes.envelopeRemaining[voice] = preset.attackSamples[op];
     }
+    
+    feedback_.level[voice] = feedbackLevel(channel.feedback);
+    feedback_.previous[voice] = 0.0;
+    feedback_.previous2[voice] = 0.0;
+    decimator_.resetVoice(voice);
 }
 
 /**
- * @brief Trigger a note off event
+ * @brief Release the key a voice is playing
  * 
- * Stops playing a note on the synthesizer. Finds the voice playing the
- * specified note and triggers its release phase.
+ * A voice fading out after a steal has not started its new note yet, so
+ * the pending note is dropped and the fade left to finish.
  * 
- * @param note The MIDI note number to stop
+ * @param voice The voice to release
  */
-void FMSynthesizer::noteOff(int note) {
-    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-        if (voices_[voice].active && voices_[voice].note == note) {
-            for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-                voices_[voice].operators[op].envelopeState = static_cast<int>(EnvelopeState::RELEASE);
-                voices_[voice].operators[op].envelopeTime = 0.0;
-            }
+void FMSynthesizer::releaseVoice(int voice) {
+    Voice& v = voices_[voice];
+    if (v.pendingNote >= 0) {
+        v.pendingNote = -1;
+    } else {
+        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+            enterEnvelopeSegment(voice, op, EnvelopeState::RELEASE);
         }
     }
+    allocator_.release(voice);
+}
+
+void FMSynthesizer::releaseNote(int channel, int note) {
+    const int voice = allocator_.find(channel, note);
+    if (voice != allocator_.NONE) {
+        releaseVoice(voice);
+    }
+}
+
+void FMSynthesizer::releaseAllNotes() {
+    allocator_.forEachAllocated([this](int voice) {
+        if (!allocator_.isReleased(voice)) {
+            releaseVoice(voice);
+        }
+    });
 }
 
 /**
- * @brief Stop all currently playing notes
+ * @brief Ramp a stolen voice to silence over VOICE_STEAL_FADE_TIME
+ * 
+ * Uses the release segment with a shortened release time, which the next
+ * note on the voice overwrites from its preset.
  * 
- * Stops all notes on all voices by triggering their release phases.
+ * @param voice The voice to fade out
  */
-void FMSynthesizer::allNotesOff() {
-    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-        if (voices_[voice].active) {
-            for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-                voices_[voice].operators[op].envelopeState = static_cast<int>(EnvelopeState::RELEASE);
-                voices_[voice].operators[op].envelopeTime = 0.0;
+void FMSynthesizer::fadeOutVoice(int voice) {
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        voices_[voice].operators[op].release = Constants::VOICE_STEAL_FADE_TIME;
+        updateEnvelopeRates(voice, op);
+        enterEnvelopeSegment(voice, op, EnvelopeState::RELEASE);
+    }
+}
+
+/**
+ * @brief Return the voices that went silent during the last block
+ * 
+ * The renderer only clears Voice::active, possibly from several pool
+ * threads at once, so the allocator is brought up to date here, before the
+ * block's events are applied. A stolen voice that has finished its fade
+ * starts the note it was stolen for.
+ */
+void FMSynthesizer::reclaimVoices() {
+    allocator_.forEachAllocated([this](int voice) {
+        Voice& v = voices_[voice];
+        if (v.active) {
+            return;
+        }
+        if (v.pendingNote >= 0) {
+            v.channel = allocator_.getChannel(voice);
+            playNote(voice, v.pendingNote, v.pendingVelocity);
+        } else {
+            v.note = -1;
+            allocator_.free(voice);
+        }
+    });
+}
+
+/**
+ * @brief Change how many voices may play (render thread only)
+ * 
+ * Voices at or above the new limit that are still sounding fade out as if
+ * stolen, and are not handed out again until the limit is raised.
+ * 
+ * @param voices The new voice count
+ */
+void FMSynthesizer::applyVoiceLimit(int voices) {
+    allocator_.setLimit(static_cast<size_t>(voices));
+    allocator_.forEachAllocated([&](int voice) {
+        if (voice >= voices) {
+            if (voices_[voice].pendingNote < 0) {
+                fadeOutVoice(voice);
+            }
+            voices_[voice].pendingNote = -1;
+            allocator_.release(voice);
+        }
+    });
+}
+
+/**
+ * @brief Pick the busy voice a new note takes over
+ * 
+ * Voices already fading out for an earlier steal are taken first, since
+ * they are silent in a moment anyway; their pending note is replaced.
+ * 
+ * @param policy How to choose among the sounding voices
+ * @return The voice to steal
+ */
+int FMSynthesizer::chooseVoiceToSteal(VoiceStealPolicy policy) const {
+    int oldest = allocator_.NONE;
+    int quietest = allocator_.NONE;
+    int quietestReleased = allocator_.NONE;
+    int fading = allocator_.NONE;
+    double quietestLevel = 0.0;
+    double quietestReleasedLevel = 0.0;
+    
+    allocator_.forEachAllocated([&](int voice) {
+        if (static_cast<size_t>(voice) >= allocator_.getLimit()) {
+            return;
+        }
+        if (voices_[voice].pendingNote >= 0) {
+            if (fading == allocator_.NONE || allocator_.getStartOrder(voice) < allocator_.getStartOrder(fading)) {
+                fading = voice;
             }
+            return;
+        }
+        if (oldest == allocator_.NONE || allocator_.getStartOrder(voice) < allocator_.getStartOrder(oldest)) {
+            oldest = voice;
         }
+        const double level = voiceLevel(voice);
+        if (quietest == allocator_.NONE || level < quietestLevel) {
+            quietest = voice;
+            quietestLevel = level;
+        }
+        if (allocator_.isReleased(voice) && (quietestReleased == allocator_.NONE || level < quietestReleasedLevel)) {
+            quietestReleased = voice;
+            quietestReleasedLevel = level;
+        }
+    });
+    
+    if (fading != allocator_.NONE) {
+        return fading;
+    }
+    switch (policy) {
+        case VoiceStealPolicy::QUIETEST:
+            return quietest;
+        case VoiceStealPolicy::RELEASED_FIRST:
+            return quietestReleased != allocator_.NONE ? quietestReleased : oldest;
+        case VoiceStealPolicy::OLDEST:
+            break;
+    }
+    return oldest;
+}
+
+/**
+ * @brief How loud a voice currently is
+ * 
+ * @return The summed envelope level times amplitude of the carriers of the
+ *         voice's algorithm
+ */
+double FMSynthesizer::voiceLevel(int voice) const {
+    const AlgorithmTopology& topology = ALGORITHMS[voices_[voice].algorithm];
+    double level = 0.0;
+    for (int8_t carrier : topology.carriers) {
+        if (carrier == AlgorithmTopology::NONE) break;
+        level += lanes_[carrier].envelopeLevel[voice] * lanes_[carrier].amplitude[voice];
     }
+    return level * voices_[voice].velocity;
 }
 
 void FMSynthesizer::setChannelActive(int channel, bool active) {
     if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
-        channels_[channel].active = active;
+        postEvent(SynthEvent::Type::CHANNEL_ACTIVE, channel, active ? 1 : 0);
     }
 }
 
@@ -217,82 +578,151 @@ bool FMSynthesizer::isChannelActive(int channel) const {
 
 void FMSynthesizer::setOperatorFrequency(int voice, int opIndex, double frequency) {
     if (voice >= 0 && voice < Constants::MAX_VOICES && opIndex >= 0 && opIndex < Constants::MAX_OPERATORS) {
-        voices_[voice].operators[opIndex].frequency = frequency;
-        voices_[voice].operators[opIndex].phaseIncrement = 
-            calculatePhaseIncrement22Bit(frequency);
+        postEvent(SynthEvent::Type::OPERATOR_FREQUENCY, voice, opIndex, {frequency});
     }
 }
 
 void FMSynthesizer::setOperatorAmplitude(int voice, int opIndex, double amplitude) {
     if (voice >= 0 && voice < Constants::MAX_VOICES && opIndex >= 0 && opIndex < Constants::MAX_OPERATORS) {
-        voices_[voice].operators[opIndex].amplitude = 
-            std::clamp(amplitude, Constants::MIN_AMPLITUDE, Constants::MAX_AMPLITUDE);
+        postEvent(SynthEvent::Type::OPERATOR_AMPLITUDE, voice, opIndex,
+                  {std::clamp(amplitude, Constants::MIN_AMPLITUDE, Constants::MAX_AMPLITUDE)});
     }
 }
 
 void FMSynthesizer::setOperatorModulationIndex(int voice, int opIndex, double index) {
     if (voice >= 0 && voice < Constants::MAX_VOICES && opIndex >= 0 && opIndex < Constants::MAX_OPERATORS) {
-        voices_[voice].operators[opIndex].modulationIndex = index;
+        postEvent(SynthEvent::Type::OPERATOR_MODULATION_INDEX, voice, opIndex, {index});
     }
 }
 
 void FMSynthesizer::setOperatorWaveform(int voice, int opIndex, WaveformType waveform) {
     if (voice >= 0 && voice < Constants::MAX_VOICES && opIndex >= 0 && opIndex < Constants::MAX_OPERATORS) {
-        voices_[voice].operators[opIndex].waveform = waveform;
+        postEvent(SynthEvent::Type::OPERATOR_WAVEFORM, voice, opIndex, {static_cast<double>(waveform)});
     }
 }
 
+/**
+ * @brief Set the algorithm new notes on a channel are routed through
+ * 
+ * Notes already sounding keep the routing they started with.
+ * 
+ * @param channel The channel to change
+ * @param algorithm Algorithm index (0 to MAX_ALGORITHMS - 1)
+ */
 void FMSynthesizer::setAlgorithm(int channel, int algorithm) {
     if (channel >= 0 && channel < Constants::MAX_CHANNELS && algorithm >= 0 && algorithm < Constants::MAX_ALGORITHMS) {
-        channels_[channel].algorithm = algorithm;
+        postEvent(SynthEvent::Type::ALGORITHM, channel, algorithm);
+    }
+}
+
+/**
+ * @brief Set how strongly a channel's feedback operator modulates itself
+ * 
+ * The feedback operator of each algorithm is fed the average of its last
+ * two outputs, scaled up to MAX_FEEDBACK_DEPTH radians at full amount.
+ * Voices already sounding on the channel pick up the change at the next block.
+ * 
+ * @param channel The channel to change
+ * @param amount Feedback amount (0.0 = off to 1.0)
+ */
+void FMSynthesizer::setFeedback(int channel, double amount) {
+    if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
+        postEvent(SynthEvent::Type::FEEDBACK, channel, 0, {std::clamp(amount, 0.0, 1.0)});
+    }
+}
+
+void FMSynthesizer::applyFeedback(int channel, double amount) {
+    channels_[channel].feedback = amount;
+    allocator_.forEachOnChannel(channel, [&](int voice) {
+        feedback_.level[voice] = feedbackLevel(amount);
+    });
+}
+
+double FMSynthesizer::getFeedback(int channel) const {
+    if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
+        return channels_[channel].feedback;
     }
+    return 0.0;
 }
 
 void FMSynthesizer::setEnvelope(int voice, int opIndex, double attack, double decay, 
                                 double sustain, double release) {
     if (voice >= 0 && voice < Constants::MAX_VOICES && opIndex >= 0 && opIndex < Constants::MAX_OPERATORS) {
-        auto& op = voices_[voice].operators[opIndex];
-        op.attack = std::max(Constants::MIN_ENVELOPE_TIME, attack);
-        op.decay = std::max(Constants::MIN_ENVELOPE_TIME, decay);
-        op.sustain = std::clamp(sustain, Constants::MIN_VOLUME, Constants::MAX_VOLUME);
-        op.release = std::max(Constants::MIN_ENVELOPE_TIME, release);
+        postEvent(SynthEvent::Type::ENVELOPE, voice, opIndex,
+                  {std::max(Constants::MIN_ENVELOPE_TIME, attack),
+                   std::max(Constants::MIN_ENVELOPE_TIME, decay),
+                   std::clamp(sustain, Constants::MIN_VOLUME, Constants::MAX_VOLUME),
+                   std::max(Constants::MIN_ENVELOPE_TIME, release)});
     }
 }
 
 /**
  * @brief Set the master volume
  * 
- * Sets the overall volume level for the synthesizer output.
+ * Sets the overall volume level for the synthesizer output, ahead of the
+ * effect sends and of the mixer strip gain when played by a manager. Like
+ * the other controls it is queued and lands at the start of a span.
  * 
  * @param volume The volume level (0.0 to 1.0)
  */
 void FMSynthesizer::setMasterVolume(double volume) {
-    masterVolume_ = std::clamp(volume, Constants::MIN_VOLUME, Constants::MAX_VOLUME);
+    postEvent(SynthEvent::Type::MASTER_VOLUME, 0, 0, {std::clamp(volume, Constants::MIN_VOLUME, Constants::MAX_VOLUME)});
 }
 
 /**
  * @brief Set the audio sample rate
  * 
- * Changes the sample rate of the synthesizer and recalculates the time step.
+ * Queued like any other control change: the renderer switches rates at the
+ * event (see applySampleRate()), so nothing it owns is written from here.
+ * Presets set from now on are compiled for the new rate.
  * 
- * @param sampleRate The new sample rate in Hz
+ * @param sampleRate The new sample rate in Hz, clamped to
+ *                   MIN_SAMPLE_RATE..MAX_SAMPLE_RATE
  */
 void FMSynthesizer::setSampleRate(int sampleRate) {
+    sampleRate = std::clamp(sampleRate, Constants::MIN_SAMPLE_RATE, Constants::MAX_SAMPLE_RATE);
+    controlSampleRate_ = sampleRate;
+    postEvent(SynthEvent::Type::SAMPLE_RATE, 0, sampleRate);
+}
+
+/**
+ * @brief Switch the renderer to a new sample rate (render thread only)
+ * 
+ * Recalculates the pitch bend smoothing, the template new notes are built
+ * from and the phase and envelope steps of every voice, and retunes the bus
+ * effects, whose delay lines are already long enough for any rate, so
+ * nothing is allocated. A template still pending is recompiled when it is
+ * adopted.
+ * 
+ * @param sampleRate The new sample rate in Hz
+ */
+void FMSynthesizer::applySampleRate(int sampleRate) {
+    if (sampleRate == sampleRate_) {
+        return;
+    }
     sampleRate_ = sampleRate;
-    timeStep_ = 1.0 / sampleRate;
+    busEffects_.setSampleRate(sampleRate);
+    idle_.setSampleRate(sampleRate);
+    pitchBendSmoothing_ = pitchBendSmoothing(sampleRate);
+    compileVoiceTemplate(*preset_, sampleRate);
     
-    for (auto& voice : voices_) {
-        for (auto& op : voice.operators) {
-            op.phaseIncrement = calculatePhaseIncrement22Bit(op.frequency);
+    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
+        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+            lanes_[op].phaseIncrement[voice] = calculatePhaseIncrement22Bit(voices_[voice].operators[op].frequency);
+            updatePhaseStep(op, voice);
+            updateEnvelopeRates(voice, op);
         }
     }
 }
 
 /**
- * @brief Start the audio generation thread
+ * @brief Start audio generation
  * 
- * Starts the background thread that generates audio samples and feeds them
- * to the audio output system.
+ * Starts a background thread that generates samples into the sample stream.
+ * Real-time playback goes through QtAudioOutput instead, which pulls blocks
+ * through renderBlock() and needs no thread of the synthesizer's own. In
+ * real-time mode this returns once the thread has been promoted, and
+ * prints whatever the OS refused; getRealtimeStatus() has the details.
  */
 void FMSynthesizer::startAudioThread() {
     if (audioThreadRunning_) {
@@ -301,11 +731,44 @@ void FMSynthesizer::startAudioThread() {
     
     shouldStop_ = false;
     audioThreadRunning_ = true;
+    audioThreadReady_.store(false, std::memory_order_relaxed);
     audioThread_ = std::thread(&FMSynthesizer::audioThreadFunction, this);
+    audioThreadReady_.wait(false, std::memory_order_acquire);
+    if (!realtimeStatus_.denials.empty()) {
+        printf("Real-time mode: %s\n", realtimeStatus_.describe().c_str());
+    }
+}
+
+/**
+ * @brief Ask for real-time scheduling of the audio thread
+ * 
+ * Takes effect the next time the thread is started; see
+ * promoteCurrentThread(). The thread takes the first configured core.
+ * 
+ * @param config What to ask the OS for
+ */
+void FMSynthesizer::setRealtimeMode(const RealtimeConfig& config) {
+    realtimeConfig_ = config;
+}
+
+/**
+ * @brief Lock the voices and every buffer the renderer touches in memory
+ * 
+ * Covers the synthesizer itself, which holds the voice and operator lanes
+ * and the mix buffers, the event queues, the sample stream and the effect
+ * delay lines, which are sized for every sample rate.
+ */
+void FMSynthesizer::lockBuffers(RealtimeStatus& status) const {
+    lockMemory(status, this, sizeof(*this));
+    lockMemory(status, sampleBuffer_);
+    lockMemory(status, events_.storage(), events_.capacity() * sizeof(SynthEvent));
+    lockMemory(status, inputEvents_.storage(), inputEvents_.capacity() * sizeof(SynthEvent));
+    sampleStream_->lockBuffers(status);
+    busEffects_.lockBuffers(status);
 }
 
 /**
- * @brief Stop the audio generation thread
+ * @brief Stop audio generation
  * 
  * Stops the background audio thread and waits for it to finish.
  */
@@ -315,6 +778,7 @@ void FMSynthesizer::stopAudioThread() {
     }
     
     shouldStop_ = true;
+    idle_.wake();
     
     if (audioThread_.joinable()) {
         audioThread_.join();
@@ -341,360 +805,1269 @@ bool FMSynthesizer::isAudioThreadRunning() const {
 /**
  * @brief Generate audio samples and write them to a stream
  * 
- * Generates a buffer of audio samples and writes them to the specified
- * audio sample stream.
+ * Renders one block of DEFAULT_BLOCK_SIZE stereo frames and writes the
+ * interleaved samples to the specified audio sample stream in a single call.
+ * A stream found empty while blocks are being streamed back to back has
+ * been drained by its reader, which counts as an underrun; samples the
+ * stream has no room for are dropped and count as an overrun.
  * 
  * @param stream The audio sample stream to write to
  */
 void FMSynthesizer::generateSamples(AudioSampleStream& stream) {
-    double leftSample = 0.0, rightSample = 0.0;
-    
-    int activeVoices = 0;
-    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-            if (!voices_[voice].active) continue;
-            activeVoices++;
-            
-            for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-                updateEnvelope(voices_[voice].operators[op]);
-            }
-            
-            bool allReleased = true;
-            for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-                if (voices_[voice].operators[op].envelopeState != static_cast<int>(EnvelopeState::OFF)) {
-                    allReleased = false;
-                    break;
-                }
-            }
-            if (allReleased) {
-                voices_[voice].active = false;
-                continue;
-            }
-            
-            double voiceOutput = 0.0;
-            int channel = voices_[voice].channel;
-            switch (channels_[channel].algorithm) {
-                case 0: voiceOutput = processAlgorithm0(voices_[voice]); break;
-                case 1: voiceOutput = processAlgorithm1(voices_[voice]); break;
-                case 2: voiceOutput = processAlgorithm2(voices_[voice]); break;
-                case 3: voiceOutput = processAlgorithm3(voices_[voice]); break;
-                case 4: voiceOutput = processAlgorithm4(voices_[voice]); break;
-                case 5: voiceOutput = processAlgorithm5(voices_[voice]); break;
-                case 6: voiceOutput = processAlgorithm6(voices_[voice]); break;
-                case 7: voiceOutput = processAlgorithm7(voices_[voice]); break;
-                case 8: voiceOutput = processAlgorithm8(voices_[voice]); break;
-                case 9: voiceOutput = processAlgorithm9(voices_[voice]); break;
-                case 10: voiceOutput = processAlgorithm10(voices_[voice]); break;
-                case 11: voiceOutput = processAlgorithm11(voices_[voice]); break;
-                case 12: voiceOutput = processAlgorithm12(voices_[voice]); break;
-                case 13: voiceOutput = processAlgorithm13(voices_[voice]); break;
-                case 14: voiceOutput = processAlgorithm14(voices_[voice]); break;
-                case 15: voiceOutput = processAlgorithm15(voices_[voice]); break;
-                case 16: voiceOutput = processAlgorithm16(voices_[voice]); break;
-                case 17: voiceOutput = processAlgorithm17(voices_[voice]); break;
-                case 18: voiceOutput = processAlgorithm18(voices_[voice]); break;
-                case 19: voiceOutput = processAlgorithm19(voices_[voice]); break;
-                case 20: voiceOutput = processAlgorithm20(voices_[voice]); break;
-                case 21: voiceOutput = processAlgorithm21(voices_[voice]); break;
-                case 22: voiceOutput = processAlgorithm22(voices_[voice]); break;
-                case 23: voiceOutput = processAlgorithm23(voices_[voice]); break;
-                case 24: voiceOutput = processAlgorithm24(voices_[voice]); break;
-                case 25: voiceOutput = processAlgorithm25(voices_[voice]); break;
-                case 26: voiceOutput = processAlgorithm26(voices_[voice]); break;
-                case 27: voiceOutput = processAlgorithm27(voices_[voice]); break;
-                case 28: voiceOutput = processAlgorithm28(voices_[voice]); break;
-                case 29: voiceOutput = processAlgorithm29(voices_[voice]); break;
-                case 30: voiceOutput = processAlgorithm30(voices_[voice]); break;
-                case 31: voiceOutput = processAlgorithm31(voices_[voice]); break;
-            }
-            
-            voiceOutput = applyEffects(voiceOutput, channel);
-            
-            for (auto& op : voices_[voice].operators) {
-                updateOperatorPhase(op);
-            }
-            
-            double pan = (voice % 2 == 0) ? Constants::PAN_LEFT : Constants::PAN_RIGHT;
-            leftSample += voiceOutput * (Constants::PAN_SCALE - pan);
-            rightSample += voiceOutput * (Constants::PAN_SCALE + pan);
-        }
-    int16_t left = static_cast<int16_t>(std::clamp(leftSample * Constants::AUDIO_SCALE, 
-                                                  static_cast<double>(Constants::AUDIO_MIN_VALUE), 
-                                                  static_cast<double>(Constants::AUDIO_MAX_VALUE)));
-    int16_t right = static_cast<int16_t>(std::clamp(rightSample * Constants::AUDIO_SCALE, 
-                                                   static_cast<double>(Constants::AUDIO_MIN_VALUE), 
-                                                   static_cast<double>(Constants::AUDIO_MAX_VALUE)));
-    
-    
-    stream.writeSample(left);
-    stream.writeSample(right);
-    
+    renderBlock(blockSamples_.data(), Constants::DEFAULT_BLOCK_SIZE);
+    if (streaming_ && !stream.hasData()) {
+        telemetry_.recordUnderrun();
+    }
+    const size_t count = Constants::DEFAULT_BLOCK_SIZE * 2;
+    if (stream.writeSamples(blockSamples_.data(), count) < count) {
+        telemetry_.recordOverrun();
+    }
+    streaming_ = true;
 }
 
 void FMSynthesizer::generateSample(int16_t& left, int16_t& right) {
-    double leftSample = 0.0, rightSample = 0.0;
-    
-    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-        if (!voices_[voice].active) continue;
-        
-        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-            updateEnvelope(voices_[voice].operators[op]);
-        }
-        
-        bool allReleased = true;
-        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
-            if (voices_[voice].operators[op].envelopeState != static_cast<int>(EnvelopeState::OFF)) {
-                allReleased = false;
-                break;
-            }
-        }
-        if (allReleased) {
-            voices_[voice].active = false;
-            continue;
-        }
+    int16_t frame[2];
+    renderBlock(frame, 1);
+    left = frame[0];
+    right = frame[1];
+}
+
+/**
+ * @brief Render a block of stereo audio into separate float buffers
+ * 
+ * Voice activity, algorithm dispatch and effect enables are resolved once per
+ * block; each active voice is then rendered over all frames of the block.
+ * Blocks longer than MAX_BLOCK_SIZE are rendered in several passes.
+ * 
+ * @param left Destination for the left channel (frames samples)
+ * @param right Destination for the right channel (frames samples)
+ * @param frames Number of frames to render
+ */
+void FMSynthesizer::renderBlock(float* left, float* right, size_t frames) {
+    const uint64_t start = RenderTelemetry::now();
+    const uint64_t deadline = static_cast<uint64_t>(frames) * 1000000000ULL / sampleRate_;
+    stampClock(frames);
+    while (frames > 0) {
+        size_t chunk = std::min(frames, static_cast<size_t>(Constants::MAX_BLOCK_SIZE));
+        mixBlock(chunk);
         
-        double voiceOutput = 0.0;
-        int channel = voices_[voice].channel;
-        switch (channels_[channel].algorithm) {
-            case 0: voiceOutput = processAlgorithm0(voices_[voice]); break;
-            case 1: voiceOutput = processAlgorithm1(voices_[voice]); break;
-            case 2: voiceOutput = processAlgorithm2(voices_[voice]); break;
-            case 3: voiceOutput = processAlgorithm3(voices_[voice]); break;
-            case 4: voiceOutput = processAlgorithm4(voices_[voice]); break;
-            case 5: voiceOutput = processAlgorithm5(voices_[voice]); break;
-            case 6: voiceOutput = processAlgorithm6(voices_[voice]); break;
-            case 7: voiceOutput = processAlgorithm7(voices_[voice]); break;
-            case 8: voiceOutput = processAlgorithm8(voices_[voice]); break;
-            case 9: voiceOutput = processAlgorithm9(voices_[voice]); break;
-            case 10: voiceOutput = processAlgorithm10(voices_[voice]); break;
-            case 11: voiceOutput = processAlgorithm11(voices_[voice]); break;
-            case 12: voiceOutput = processAlgorithm12(voices_[voice]); break;
-            case 13: voiceOutput = processAlgorithm13(voices_[voice]); break;
-            case 14: voiceOutput = processAlgorithm14(voices_[voice]); break;
-            case 15: voiceOutput = processAlgorithm15(voices_[voice]); break;
-            case 16: voiceOutput = processAlgorithm16(voices_[voice]); break;
-            case 17: voiceOutput = processAlgorithm17(voices_[voice]); break;
-            case 18: voiceOutput = processAlgorithm18(voices_[voice]); break;
-            case 19: voiceOutput = processAlgorithm19(voices_[voice]); break;
-            case 20: voiceOutput = processAlgorithm20(voices_[voice]); break;
-            case 21: voiceOutput = processAlgorithm21(voices_[voice]); break;
-            case 22: voiceOutput = processAlgorithm22(voices_[voice]); break;
-            case 23: voiceOutput = processAlgorithm23(voices_[voice]); break;
-            case 24: voiceOutput = processAlgorithm24(voices_[voice]); break;
-            case 25: voiceOutput = processAlgorithm25(voices_[voice]); break;
-            case 26: voiceOutput = processAlgorithm26(voices_[voice]); break;
-            case 27: voiceOutput = processAlgorithm27(voices_[voice]); break;
-            case 28: voiceOutput = processAlgorithm28(voices_[voice]); break;
-            case 29: voiceOutput = processAlgorithm29(voices_[voice]); break;
-            case 30: voiceOutput = processAlgorithm30(voices_[voice]); break;
-            case 31: voiceOutput = processAlgorithm31(voices_[voice]); break;
+        for (size_t frame = 0; frame < chunk; frame++) {
+            left[frame] = static_cast<float>(mixLeft_[frame]);
+            right[frame] = static_cast<float>(mixRight_[frame]);
         }
         
-        voiceOutput = applyEffects(voiceOutput, channel);
+        left += chunk;
+        right += chunk;
+        frames -= chunk;
+    }
+    telemetry_.recordBlock(RenderTelemetry::now() - start, deadline);
+}
+
+/**
+ * @brief Render a block of stereo audio as interleaved 16-bit samples
+ * 
+ * Same as the float variant, but scales and clamps the mix to the emulated
+ * DAC range and writes left/right pairs into a single buffer.
+ * 
+ * @param interleaved Destination buffer (frames * 2 samples)
+ * @param frames Number of frames to render
+ */
+void FMSynthesizer::renderBlock(int16_t* interleaved, size_t frames) {
+    const uint64_t start = RenderTelemetry::now();
+    const uint64_t deadline = static_cast<uint64_t>(frames) * 1000000000ULL / sampleRate_;
+    stampClock(frames);
+    while (frames > 0) {
+        size_t chunk = std::min(frames, static_cast<size_t>(Constants::MAX_BLOCK_SIZE));
+        mixBlock(chunk);
         
-        for (auto& op : voices_[voice].operators) {
-            updateOperatorPhase(op);
+        for (size_t frame = 0; frame < chunk; frame++) {
+            interleaved[frame * 2] = static_cast<int16_t>(std::clamp(mixLeft_[frame] * Constants::AUDIO_SCALE, 
+                                                                    static_cast<double>(Constants::AUDIO_MIN_VALUE), 
+                                                                    static_cast<double>(Constants::AUDIO_MAX_VALUE)));
+            interleaved[frame * 2 + 1] = static_cast<int16_t>(std::clamp(mixRight_[frame] * Constants::AUDIO_SCALE, 
+                                                                        static_cast<double>(Constants::AUDIO_MIN_VALUE), 
+                                                                        static_cast<double>(Constants::AUDIO_MAX_VALUE)));
         }
         
-        double pan = (voice % 2 == 0) ? Constants::PAN_LEFT : Constants::PAN_RIGHT;
-        leftSample += voiceOutput * (Constants::PAN_SCALE - pan);
-        rightSample += voiceOutput * (Constants::PAN_SCALE + pan);
+        interleaved += chunk * 2;
+        frames -= chunk;
     }
-    left = static_cast<int16_t>(std::clamp(leftSample * Constants::AUDIO_SCALE, 
-                                          static_cast<double>(Constants::AUDIO_MIN_VALUE), 
-                                          static_cast<double>(Constants::AUDIO_MAX_VALUE)));
-    right = static_cast<int16_t>(std::clamp(rightSample * Constants::AUDIO_SCALE, 
-                                           static_cast<double>(Constants::AUDIO_MIN_VALUE), 
-                                           static_cast<double>(Constants::AUDIO_MAX_VALUE)));
+    telemetry_.recordBlock(RenderTelemetry::now() - start, deadline);
 }
 
-void FMSynthesizer::audioThreadFunction() {
-    while (!shouldStop_) {
-        bool hasActiveVoices = false;
-        for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-            if (voices_[voice].active) {
-                hasActiveVoices = true;
-                break;
-            }
+/**
+ * @brief Render one block into the mix buffers, split at the events that fall inside it
+ * 
+ * Each span between two events is rendered by the same lane group kernels
+ * as a whole block, so an event lands on its own frame without shrinking
+ * the block size for everything else. The master volume scales each span
+ * before the effect sends.
+ */
+void FMSynthesizer::mixBlock(size_t frames) {
+    std::fill_n(mixLeft_.begin(), frames, 0.0);
+    std::fill_n(mixRight_.begin(), frames, 0.0);
+    
+    busEffects_.beginBlock();
+    size_t offset = 0;
+    while (offset < frames) {
+        const size_t span = beginBlock(frames - offset);
+        double* left = mixLeft_.data() + offset;
+        double* right = mixRight_.data() + offset;
+        for (int slice = 0; slice < VOICE_SLICES; slice++) {
+            renderVoiceSlice(slice, span, left, right);
         }
-        
-        if (hasActiveVoices) {
-            if (audioIODevice_) {
-                const int BATCH_SIZE = 256;
-                std::vector<int16_t> sampleBuffer;
-                sampleBuffer.reserve(BATCH_SIZE * 2);
-                
-                for (int i = 0; i < BATCH_SIZE; i++) {
-                    int16_t left, right;
-                    generateSample(left, right);
-                    sampleBuffer.push_back(left);
-                    sampleBuffer.push_back(right);
-                }
-                
-                qint64 bytesToWrite = sampleBuffer.size() * sizeof(int16_t);
-                qint64 bytesWritten = audioIODevice_->write(
-                    reinterpret_cast<const char*>(sampleBuffer.data()), 
-                    bytesToWrite
-                );
-            } else {
-                if (externalStream_) {
-                    generateSamples(*externalStream_);
-                } else {
-                    generateSamples(*sampleStream_);
-                }
-            }
-            
-            std::this_thread::sleep_for(std::chrono::microseconds(5800));
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        for (size_t frame = 0; frame < span; frame++) {
+            left[frame] *= masterVolume_;
+            right[frame] *= masterVolume_;
         }
+        busEffects_.addSend(left, right, span, 1.0, 1.0,
+                            blockEffects_.chorusSend, blockEffects_.reverbSend, offset);
+        endBlock(span);
+        offset += span;
+    }
+    busEffects_.process(mixLeft_.data(), mixRight_.data(), frames);
+    
+    if (idle_.trackSilence(mixLeft_.data(), mixRight_.data(), frames, 1.0, [this] { return hasPendingWork(); })) {
+        pauseClock();
+    }
+}
+
+/**
+ * @brief Stamp the audio clock with the start of a render period
+ * 
+ * Called once per renderBlock() rather than per span, so the clock follows
+ * the device's periods and input threads schedule one period ahead. While
+ * the renderer is parked the clock stays paused, since a device may still
+ * pull a few silent blocks before it is suspended.
+ * 
+ * @param frames Length of the period about to be rendered
+ */
+void FMSynthesizer::stampClock(size_t frames) {
+    if (wakeSignal_.load(std::memory_order_relaxed)->isParked()) {
+        return;
+    }
+    clock_.stamp(renderedFrames_, RenderTelemetry::now(), sampleRate_, frames);
+}
+
+/**
+ * @brief Stop the audio clock where rendering parked (render thread only)
+ */
+void FMSynthesizer::pauseClock() {
+    clock_.pause(renderedFrames_, RenderTelemetry::now());
+}
+
+/**
+ * @brief Latch the per-block state shared by all lane groups
+ * 
+ * Returns the voices that finished in the last block to the allocator and
+ * applies the control changes queued since then and the input events due
+ * by the block's first frame. Must run before any lane group of the block
+ * is rendered, and not concurrently with them.
+ * 
+ * @param frames Length of the block about to be rendered
+ * @return How many of those frames to render before the next input event,
+ *         at least one; endBlock() must be called with the frames rendered
+ */
+size_t FMSynthesizer::beginBlock(size_t frames) {
+    reclaimVoices();
+    processEvents();
+    if (hasHeldEvent_) {
+        frames = static_cast<size_t>(std::min<uint64_t>(frames, heldEvent_.frame - renderedFrames_));
+    }
+    frames = framesUntilHandover(frames);
+    advancePitchBends();
+    frames = framesUntilModulationStep(frames);
+    
+    activeVoiceCount_ = static_cast<int>(allocator_.getAllocatedCount());
+    telemetry_.setActiveVoices(activeVoiceCount_);
+    collectActiveGroups();
+    
+    const OscillatorMode mode = oscillatorMode_.load(std::memory_order_relaxed);
+    if (mode != renderOscillatorMode_) {
+        convertOscillatorPhases(mode);
+    }
+    const int oversampling = oversampling_.load(std::memory_order_relaxed);
+    if (oversampling != renderOversampling_) {
+        applyOversampling(oversampling);
+    }
+    blockEffects_ = prepareEffects();
+    return frames;
+}
+
+/**
+ * @brief Frames until the first stolen voice finishes its fade
+ * 
+ * reclaimVoices() starts the note a voice was stolen for at the start of the
+ * block after its fade ends, so the block is ended there, and the note
+ * starts on the frame the fade ends whatever the block size.
+ * 
+ * @param frames The longest block wanted
+ */
+size_t FMSynthesizer::framesUntilHandover(size_t frames) const {
+    allocator_.forEachAllocated([&](int voice) {
+        if (voices_[voice].pendingNote < 0 || !voices_[voice].active) {
+            return;
+        }
+        int remaining = 0;
+        for (const auto& lanes : lanes_) {
+            if (lanes.envelopeState[voice] == static_cast<int>(EnvelopeState::RELEASE)) {
+                remaining = std::max(remaining, lanes.envelopeRemaining[voice]);
+            }
+        }
+        if (remaining > 0) {
+            frames = std::min(frames, static_cast<size_t>(remaining));
+        }
+    });
+    return frames;
+}
+
+/**
+ * @brief Frames until the next pitch bend step while a bend is still moving
+ * 
+ * Steps fall on multiples of MODULATION_STEP_FRAMES from the start of the
+ * audio clock, so a bend sounds the same whatever the block size.
+ * 
+ * @param frames The longest block wanted
+ */
+size_t FMSynthesizer::framesUntilModulationStep(size_t frames) const {
+    if (rampingChannels_ == 0) {
+        return frames;
+    }
+    const size_t untilStep = Constants::MODULATION_STEP_FRAMES - renderedFrames_ % Constants::MODULATION_STEP_FRAMES;
+    return std::min(frames, untilStep);
+}
+
+/**
+ * @brief Move every ramping channel's applied pitch bend one step toward its target
+ * 
+ * Runs at the start of each block, and does something only on the frames
+ * framesUntilModulationStep() ends blocks at. Each step covers a fixed
+ * fraction of the distance left and refreshes the cached phase steps of the
+ * channel's voices once, so a burst of bend messages costs one store each
+ * and the voices glide instead of jumping.
+ */
+void FMSynthesizer::advancePitchBends() {
+    if (rampingChannels_ == 0 || renderedFrames_ % Constants::MODULATION_STEP_FRAMES != 0) {
+        return;
+    }
+    for (int channel = 0; channel < Constants::MAX_CHANNELS; channel++) {
+        if (!(rampingChannels_ & (1u << channel))) {
+            continue;
+        }
+        Channel& state = channels_[channel];
+        double bend = state.appliedPitchBend + (state.pitchBend - state.appliedPitchBend) * pitchBendSmoothing_;
+        if (std::abs(state.pitchBend - bend) <= PITCH_BEND_SETTLED * state.pitchBend) {
+            bend = state.pitchBend;
+            rampingChannels_ &= ~(1u << channel);
+        }
+        state.appliedPitchBend = bend;
+        allocator_.forEachOnChannel(channel, [&](int voice) {
+            for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+                updatePhaseStep(op, voice);
+            }
+        });
+    }
+}
+
+/**
+ * @brief Fraction of the remaining bend each modulation step covers
+ * 
+ * A one-pole smoother stepped every MODULATION_STEP_FRAMES frames, with a
+ * time constant of PITCH_BEND_SMOOTHING_TIME at any sample rate.
+ * 
+ * @param sampleRate The sample rate in Hz
+ */
+double FMSynthesizer::pitchBendSmoothing(int sampleRate) {
+    return 1.0 - std::exp(-Constants::MODULATION_STEP_FRAMES / (Constants::PITCH_BEND_SMOOTHING_TIME * sampleRate));
+}
+
+/**
+ * @brief Raise levels to each operator slot's peak output level (render thread only)
+ * 
+ * The level of an operator is its envelope level times its amplitude, over
+ * the voices playing. Called between blocks, for the output monitor.
+ * 
+ * @param levels Per-slot levels, raised where this synthesizer is louder
+ */
+void FMSynthesizer::measureOperatorLevels(std::array<float, Constants::MAX_OPERATORS>& levels) const {
+    allocator_.forEachAllocated([&](int voice) {
+        if (!voices_[voice].active) {
+            return;
+        }
+        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+            const double level = lanes_[op].envelopeLevel[voice] * lanes_[op].amplitude[voice];
+            levels[op] = std::max(levels[op], static_cast<float>(level));
+        }
+    });
+}
+
+/**
+ * @brief Move the audio clock position past a rendered block
+ * 
+ * @param frames Frames rendered since beginBlock()
+ */
+void FMSynthesizer::endBlock(size_t frames) {
+    renderedFrames_ += frames;
+}
+
+/**
+ * @brief List the lane groups that have a voice playing this block
+ * 
+ * Built from the allocator's busy voices, which after reclaimVoices() and
+ * the block's events are exactly the voices playing, so the cost follows
+ * the number of voices sounding rather than the size of the voice pool.
+ */
+void FMSynthesizer::collectActiveGroups() {
+    int count = 0;
+    allocator_.forEachAllocated([&](int voice) {
+        const int group = voice / static_cast<int>(simd::LANES);
+        if (count == 0 || activeGroups_[count - 1] != group) {
+            activeGroups_[count++] = static_cast<int16_t>(group);
+        }
+    });
+    
+    int index = 0;
+    for (int slice = 0; slice < VOICE_SLICES; slice++) {
+        sliceGroups_[slice] = static_cast<int16_t>(index);
+        while (index < count && activeGroups_[index] < (slice + 1) * GROUPS_PER_SLICE) {
+            index++;
+        }
+    }
+    sliceGroups_[VOICE_SLICES] = static_cast<int16_t>(count);
+}
+
+bool FMSynthesizer::isVoiceSliceActive(int slice) const {
+    return sliceGroups_[slice] != sliceGroups_[slice + 1];
+}
+
+/**
+ * @brief Render the lane groups of one voice slice into a pair of mix buffers
+ * 
+ * Slices own whole cache lines of the voice state, so different slices of
+ * the same synthesizer can be rendered concurrently by the worker pool.
+ * Only the slice's groups listed by collectActiveGroups() are visited.
+ * 
+ * @param slice Index of the slice (voices slice * VOICES_PER_SLICE onwards)
+ * @param frames Number of frames to render
+ * @param mixLeft Left buffer the slice's voices are added to
+ * @param mixRight Right buffer the slice's voices are added to
+ */
+void FMSynthesizer::renderVoiceSlice(int slice, size_t frames, double* mixLeft, double* mixRight) {
+    for (int index = sliceGroups_[slice]; index < sliceGroups_[slice + 1]; index++) {
+        renderLaneGroup(activeGroups_[index], frames, mixLeft, mixRight);
+    }
+}
+
+/**
+ * @brief Render one lane group of voices into a pair of mix buffers
+ * 
+ * All voices of the group are computed together, one operator slot at a
+ * time, by the algorithm kernels. Lanes whose voice is idle or finishes
+ * during the block are masked out of the phase update and the mix, and the
+ * per-frame mix still adds voices in index order so the result does not
+ * depend on the lane width. When oversampling, the operators run that many
+ * times per frame and are decimated per voice; envelopes, distortion and
+ * the mix stay at the output rate. Different lane groups touch disjoint
+ * state, so they may be rendered concurrently into different buffers.
+ * 
+ * @param group Index of the lane group (voices group * LANES onwards)
+ * @param frames Number of frames to render
+ * @param mixLeft Left buffer the group's voices are added to
+ * @param mixRight Right buffer the group's voices are added to
+ */
+void FMSynthesizer::renderLaneGroup(int group, size_t frames, double* mixLeft, double* mixRight) {
+    const BlockEffects& effects = blockEffects_;
+    const int firstVoice = group * static_cast<int>(simd::LANES);
+    
+    unsigned activeLanes = 0;
+    for (size_t lane = 0; lane < simd::LANES; lane++) {
+        if (voices_[firstVoice + lane].active) {
+            activeLanes |= 1u << lane;
+        }
+    }
+    if (!activeLanes) {
+        return;
+    }
+    
+    LaneGroup lanes{};
+    lanes.firstVoice = firstVoice;
+    lanes.fixedPoint = renderOscillatorMode_ == OscillatorMode::FIXED_POINT;
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            int waveform = static_cast<int>(voices_[firstVoice + lane].operators[op].waveform);
+            lanes.waveformLanes[op][waveform] |= 1u << lane;
+        }
+    }
+    
+    /* voices of one group may be on channels with different algorithms */
+    std::array<AlgorithmFunction, simd::LANES> algorithms{};
+    std::array<unsigned, simd::LANES> algorithmLanes{};
+    size_t algorithmCount = 0;
+    for (size_t lane = 0; lane < simd::LANES; lane++) {
+        if (!(activeLanes & (1u << lane))) {
+            continue;
+        }
+        const Voice& voice = voices_[firstVoice + lane];
+        const AlgorithmFunction algorithm = ALGORITHM_TABLE[voice.algorithm][channels_[voice.channel].feedback > 0.0];
+        size_t index = 0;
+        while (index < algorithmCount && algorithms[index] != algorithm) {
+            index++;
+        }
+        if (index == algorithmCount) {
+            algorithms[algorithmCount++] = algorithm;
+        }
+        algorithmLanes[index] |= 1u << lane;
+    }
+    
+    /* the voice's pan position and its note velocity */
+    alignas(simd::ALIGNMENT) double gains[2][simd::LANES];
+    for (size_t lane = 0; lane < simd::LANES; lane++) {
+        const double pan = ((firstVoice + lane) % 2 == 0) ? Constants::PAN_LEFT : Constants::PAN_RIGHT;
+        const double velocity = voices_[firstVoice + lane].velocity;
+        gains[0][lane] = (Constants::PAN_SCALE - pan) * velocity;
+        gains[1][lane] = (Constants::PAN_SCALE + pan) * velocity;
+    }
+    const simd::Vec leftGain = simd::Vec::load(gains[0]);
+    const simd::Vec rightGain = simd::Vec::load(gains[1]);
+    
+    alignas(simd::ALIGNMENT) double left[simd::LANES];
+    alignas(simd::ALIGNMENT) double right[simd::LANES];
+    
+    /* envelopes step by their cached rates; segment ends are handled only on
+       the frames where some operator of the group actually reaches one */
+    lanes.silentOperators = findSilentOperators(firstVoice, activeLanes);
+    int untilEvent = nextEnvelopeEvent(firstVoice, activeLanes);
+    int elapsed = 0;
+    const int oversampling = renderOversampling_;
+    
+    for (size_t frame = 0; frame < frames; frame++) {
+        advanceEnvelopeLevels(lanes, activeLanes);
+        if (++elapsed == untilEvent) {
+            activeLanes = finishEnvelopeSegments(firstVoice, activeLanes, elapsed);
+            if (!activeLanes) {
+                return;
+            }
+            lanes.silentOperators = findSilentOperators(firstVoice, activeLanes);
+            untilEvent = nextEnvelopeEvent(firstVoice, activeLanes);
+            elapsed = 0;
+        }
+        
+        simd::Vec output;
+        if (oversampling == 1) {
+            output = renderCoreSample(lanes, algorithms.data(), algorithmLanes.data(), algorithmCount, activeLanes);
+        } else {
+            std::array<simd::Vec, VoiceDecimator<Constants::MAX_VOICES>::MAX_FACTOR> core;
+            for (int sample = 0; sample < oversampling; sample++) {
+                core[sample] = renderCoreSample(lanes, algorithms.data(), algorithmLanes.data(), algorithmCount, activeLanes);
+            }
+            output = decimator_.decimate(group, core.data(), oversampling);
+        }
+        output = applyEffects(output, effects);
+        
+        (output * leftGain).store(left);
+        (output * rightGain).store(right);
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            if (activeLanes & (1u << lane)) {
+                mixLeft[frame] += left[lane];
+                mixRight[frame] += right[lane];
+            }
+        }
+    }
+    
+    finishEnvelopeSegments(firstVoice, activeLanes, elapsed);
+}
+
+/**
+ * @brief Run the operator core of a lane group for one sample at the core rate
+ * 
+ * Evaluates each algorithm the group's voices use, merging the lanes, and
+ * then advances the operator phases.
+ */
+simd::Vec FMSynthesizer::renderCoreSample(LaneGroup& group, const AlgorithmFunction* algorithms,
+                                          const unsigned* algorithmLanes, size_t algorithmCount, unsigned activeLanes) {
+    group.kernelLanes = algorithmLanes[0] & activeLanes;
+    simd::Vec output = (this->*algorithms[0])(group);
+    for (size_t i = 1; i < algorithmCount; i++) {
+        group.kernelLanes = algorithmLanes[i] & activeLanes;
+        output = simd::select(simd::maskFromBits(algorithmLanes[i]), (this->*algorithms[i])(group), output);
+    }
+    updateOperatorPhases(group, activeLanes);
+    return output;
+}
+
+/**
+ * @brief Render blocks into the sample stream until stopped
+ * 
+ * Once the output has gone silent the thread parks on the idle signal and
+ * takes no CPU at all until the next event is queued or the thread is
+ * stopped.
+ */
+void FMSynthesizer::audioThreadFunction() {
+    realtimeStatus_ = promoteCurrentThread(realtimeConfig_, 0,
+                                           1000000000ULL * Constants::DEFAULT_BLOCK_SIZE / sampleRate_);
+    if (realtimeConfig_.enabled && realtimeConfig_.lockMemory) {
+        lockBuffers(realtimeStatus_);
+    }
+    audioThreadReady_.store(true, std::memory_order_release);
+    audioThreadReady_.notify_all();
+    
+    while (!shouldStop_) {
+        if (idle_.isParked()) {
+            /* the reader is expected to run dry while nothing plays */
+            streaming_ = false;
+            idle_.wait([this] { return shouldStop_.load() || hasPendingWork(); });
+            continue;
+        }
+        
+        if (externalStream_) {
+            generateSamples(*externalStream_);
+        } else {
+            generateSamples(*sampleStream_);
+        }
+        
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            1000000LL * Constants::DEFAULT_BLOCK_SIZE / sampleRate_));
     }
 }
 
 
 void FMSynthesizer::setPitchBend(int channel, double bend) {
     if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
-        channels_[channel].pitchBend = bend;
-        for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-            if (voices_[voice].channel == channel) {
-                for (auto& op : voices_[voice].operators) {
-                    op.pitchBend = bend;
+        postEvent(SynthEvent::Type::PITCH_BEND, channel, 0, {bend});
+    }
+}
+
+/* only sets the target; advancePitchBends() carries the voices there */
+void FMSynthesizer::applyPitchBend(int channel, double bend) {
+    Channel& state = channels_[channel];
+    state.pitchBend = bend;
+    if (bend != state.appliedPitchBend) {
+        rampingChannels_ |= 1u << channel;
+    }
+}
+
+void FMSynthesizer::setModulationWheel(int channel, double mod) {
+    if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
+        postEvent(SynthEvent::Type::MODULATION_WHEEL, channel, 0, {mod});
+    }
+}
+
+void FMSynthesizer::setReverb(double amount) {
+    postEvent(SynthEvent::Type::REVERB, 0, 0, {std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT)});
+}
+
+void FMSynthesizer::setChorus(double amount) {
+    postEvent(SynthEvent::Type::CHORUS, 0, 0, {std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT)});
+}
+
+void FMSynthesizer::setDistortion(double amount) {
+    postEvent(SynthEvent::Type::DISTORTION, 0, 0, {std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT)});
+}
+
+/**
+ * @brief Replace the preset that new notes are built from
+ * 
+ * The preset is compiled into a voice template on this thread and
+ * published with an atomic pointer exchange; the renderer adopts it when it
+ * reaches the matching PRESET event, so notes queued after this call always
+ * use it and notes already sounding are left alone. Templates the renderer
+ * has let go of are handed back through a queue and freed here, on the
+ * control thread, so the render path never allocates or frees memory.
+ */
+void FMSynthesizer::setPresetConfig(const std::array<double, 6>& frequencies,
+                                   const std::array<double, 6>& amplitudes,
+                                   const std::array<double, 6>& modulationIndices,
+                                   const std::array<WaveformType, 6>& waveforms,
+                                   const std::array<double, 6>& attacks,
+                                   const std::array<double, 6>& decays,
+                                   const std::array<double, 6>& sustains,
+                                   const std::array<double, 6>& releases) {
+    freeRetiredPresets();
+    
+    auto* preset = new VoiceTemplate;
+    for (int i = 0; i < 6; i++) {
+        Operator& op = preset->operators[i];
+        op.frequency = frequencies[i];
+        op.waveform = waveforms[i];
+        op.attack = attacks[i];
+        op.decay = decays[i];
+        op.sustain = sustains[i];
+        op.release = releases[i];
+        preset->amplitudes[i] = amplitudes[i];
+        preset->modulationIndices[i] = modulationIndices[i];
+    }
+    compileVoiceTemplate(*preset, controlSampleRate_);
+    
+    /* a preset still pending was never seen by the renderer */
+    delete pendingPreset_.exchange(preset, std::memory_order_acq_rel);
+    postEvent(SynthEvent::Type::PRESET);
+}
+
+/**
+ * @brief Adopt the most recently published preset (render thread only)
+ * 
+ * Several setPresetConfig() calls between two blocks leave only the last
+ * preset pending; the later PRESET events then find nothing to swap.
+ */
+void FMSynthesizer::swapPreset() {
+    VoiceTemplate* preset = pendingPreset_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!preset) {
+        return;
+    }
+    /* the control thread empties the queue before publishing, and each
+       publish retires at most one preset, so this cannot fail */
+    retiredPresets_.push(preset_);
+    preset_ = preset;
+    /* compiled before a sample rate change that has been applied since */
+    if (preset_->sampleRate != sampleRate_) {
+        compileVoiceTemplate(*preset_, sampleRate_);
+    }
+}
+
+void FMSynthesizer::freeRetiredPresets() {
+    VoiceTemplate* preset;
+    while (retiredPresets_.pop(preset)) {
+        delete preset;
+    }
+}
+
+/**
+ * @brief Refresh the cached envelope steps of one operator
+ * 
+ * Called when a note starts or its envelope times or the sample rate
+ * change, so the per-sample update never has to divide.
+ * 
+ * @param voice The voice index
+ * @param opIndex The operator index
+ */
+void FMSynthesizer::updateEnvelopeRates(int voice, int opIndex) {
+    computeEnvelopeRates(voices_[voice].operators[opIndex], sampleRate_);
+}
+
+void FMSynthesizer::computeEnvelopeRates(Operator& op, int sampleRate) {
+    const double timeStep = 1.0 / sampleRate;
+    op.attackRate = timeStep / std::max(Constants::MIN_ENVELOPE_TIME, op.attack);
+    op.decayRate = timeStep * (Constants::MAX_VOLUME - op.sustain) / std::max(Constants::MIN_ENVELOPE_TIME, op.decay);
+    op.releaseSamples = std::max(1, static_cast<int>(std::ceil(op.release * sampleRate)));
+}
+
+/**
+ * @brief Work out a voice template's envelope steps for the current sample rate
+ * 
+ * Fills in everything playNote() would otherwise compute per operator: the
+ * segment steps and the length of the attack from silence, using the same
+ * arithmetic as enterEnvelopeSegment().
+ * 
+ * @param preset Template whose operator times are already set
+ * @param sampleRate The rate the template will be played at
+ */
+void FMSynthesizer::compileVoiceTemplate(VoiceTemplate& preset, int sampleRate) {
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        Operator& config = preset.operators[op];
+        computeEnvelopeRates(config, sampleRate);
+        preset.attackSamples[op] = std::max(1, static_cast<int>(std::ceil(Constants::MAX_VOLUME / config.attackRate)));
+    }
+    preset.sampleRate = sampleRate;
+}
+
+/**
+ * @brief Start an envelope segment from the operator's current level
+ * 
+ * Works out the per-sample rate and how many samples the segment lasts.
+ * Attack and decay move at their cached rates; release reaches silence
+ * after the release time from wherever the level currently is. Sustain and
+ * off hold their level until something else changes the state.
+ * 
+ * @param voice The voice index
+ * @param opIndex The operator index
+ * @param state The segment to enter
+ */
+void FMSynthesizer::enterEnvelopeSegment(int voice, int opIndex, EnvelopeState state) {
+    const Operator& op = voices_[voice].operators[opIndex];
+    OperatorLanes& lanes = lanes_[opIndex];
+    const double level = lanes.envelopeLevel[voice];
+    
+    double rate = 0.0;
+    int samples = ENVELOPE_HOLD;
+    switch (state) {
+        case EnvelopeState::ATTACK:
+            rate = op.attackRate;
+            samples = std::max(1, static_cast<int>(std::ceil((Constants::MAX_VOLUME - level) / rate)));
+            break;
+        case EnvelopeState::DECAY:
+            rate = -op.decayRate;
+            samples = rate < 0.0 ? std::max(1, static_cast<int>(std::ceil((op.sustain - level) / rate))) : 1;
+            break;
+        case EnvelopeState::RELEASE:
+            rate = (Constants::MIN_VOLUME - level) / op.releaseSamples;
+            samples = op.releaseSamples;
+            break;
+        case EnvelopeState::SUSTAIN:
+        case EnvelopeState::OFF:
+            break;
+    }
+    
+    lanes.envelopeState[voice] = static_cast<int>(state);
+    lanes.envelopeRate[voice] = rate;
+    lanes.envelopeRemaining[voice] = samples;
+}
+
+/**
+ * @brief Step every envelope of a lane group by one sample
+ * 
+ * @param group The lane group being rendered
+ * @param activeLanes Lanes whose voices are sounding; other lanes are left untouched
+ */
+void FMSynthesizer::advanceEnvelopeLevels(const LaneGroup& group, unsigned activeLanes) {
+    const simd::Mask active = simd::maskFromBits(activeLanes);
+    const int voice = group.firstVoice;
+    
+    for (auto& lanes : lanes_) {
+        double* level = &lanes.envelopeLevel[voice];
+        simd::Vec current = simd::Vec::load(level);
+        simd::select(active, current + simd::Vec::load(&lanes.envelopeRate[voice]), current).store(level);
+    }
+}
+
+/**
+ * @brief Account for elapsed samples and move finished segments on
+ * 
+ * Operators whose segment ends are snapped to the segment's end level, so
+ * the boundary is sample accurate and rounding in the rate never
+ * accumulates, and then enter the next segment. Voices whose operators are
+ * all off are deactivated.
+ * 
+ * @param firstVoice First voice of the lane group
+ * @param activeLanes Lanes whose voices are sounding
+ * @param elapsed Samples stepped since the counters were last updated
+ * @return The lanes still sounding
+ */
+unsigned FMSynthesizer::finishEnvelopeSegments(int firstVoice, unsigned activeLanes, int elapsed) {
+    for (size_t lane = 0; lane < simd::LANES; lane++) {
+        if (!(activeLanes & (1u << lane))) {
+            continue;
+        }
+        const int voice = firstVoice + static_cast<int>(lane);
+        bool sounding = false;
+        
+        for (int opIndex = 0; opIndex < Constants::MAX_OPERATORS; opIndex++) {
+            OperatorLanes& lanes = lanes_[opIndex];
+            int& remaining = lanes.envelopeRemaining[voice];
+            const auto state = static_cast<EnvelopeState>(lanes.envelopeState[voice]);
+            
+            if (remaining != ENVELOPE_HOLD) {
+                remaining -= elapsed;
+            }
+            if (remaining <= 0) {
+                switch (state) {
+                    case EnvelopeState::ATTACK:
+                        lanes.envelopeLevel[voice] = Constants::MAX_VOLUME;
+                        enterEnvelopeSegment(voice, opIndex, EnvelopeState::DECAY);
+                        break;
+                    case EnvelopeState::DECAY:
+                        lanes.envelopeLevel[voice] = voices_[voice].operators[opIndex].sustain;
+                        enterEnvelopeSegment(voice, opIndex, EnvelopeState::SUSTAIN);
+                        break;
+                    case EnvelopeState::RELEASE:
+                        lanes.envelopeLevel[voice] = Constants::MIN_VOLUME;
+                        enterEnvelopeSegment(voice, opIndex, EnvelopeState::OFF);
+                        break;
+                    case EnvelopeState::SUSTAIN:
+                    case EnvelopeState::OFF:
+                        remaining = ENVELOPE_HOLD;
+                        break;
+                }
+            }
+            
+            if (lanes.envelopeState[voice] != static_cast<int>(EnvelopeState::OFF)) {
+                sounding = true;
+            }
+        }
+        
+        if (!sounding) {
+            voices_[voice].active = false;
+            activeLanes &= ~(1u << lane);
+        }
+    }
+    return activeLanes;
+}
+
+/**
+ * @brief Samples until the next envelope segment boundary in a lane group
+ * 
+ * @param firstVoice First voice of the lane group
+ * @param activeLanes Lanes whose voices are sounding
+ * @return The smallest remaining segment length over the group's operators
+ */
+int FMSynthesizer::nextEnvelopeEvent(int firstVoice, unsigned activeLanes) const {
+    int next = ENVELOPE_HOLD;
+    for (const auto& lanes : lanes_) {
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            if (activeLanes & (1u << lane)) {
+                next = std::min(next, lanes.envelopeRemaining[firstVoice + lane]);
+            }
+        }
+    }
+    return std::max(next, 1);
+}
+
+/**
+ * @brief Operator slots that contribute nothing for any voice of a lane group
+ * 
+ * An operator with zero amplitude or a finished envelope outputs silence
+ * whatever its phase, so the kernels skip its oscillator altogether.
+ * 
+ * @param firstVoice First voice of the lane group
+ * @param activeLanes Lanes whose voices are sounding
+ * @return Bit mask of silent operator slots
+ */
+unsigned FMSynthesizer::findSilentOperators(int firstVoice, unsigned activeLanes) const {
+    unsigned silent = 0;
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        const OperatorLanes& lanes = lanes_[op];
+        bool contributes = false;
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            const int voice = firstVoice + static_cast<int>(lane);
+            if ((activeLanes & (1u << lane)) && lanes.amplitude[voice] != 0.0 &&
+                lanes.envelopeState[voice] != static_cast<int>(EnvelopeState::OFF)) {
+                contributes = true;
+            }
+        }
+        if (!contributes) {
+            silent |= 1u << op;
+        }
+    }
+    return silent;
+}
+
+/**
+ * @brief Evaluate one waveform for a vector of phases
+ * 
+ * Sine is computed directly. The other shapes read the band-limited tables
+ * at each voice's mip level; there is no vector gather, so each lane is
+ * looked up on its own.
+ * 
+ * @param waveform The waveform shape
+ * @param lanes The operator slot being evaluated
+ * @param voice First voice of the lane group
+ * @param phase Phases in radians
+ * @return Waveform values, nominally in the range -1.0 to 1.0
+ */
+simd::Vec FMSynthesizer::generateWaveform(WaveformType waveform, const OperatorLanes& lanes, int voice,
+                                          simd::Vec phase) const {
+    if (waveform == WaveformType::SINE) {
+        return simd::sin(phase);
+    }
+    
+    alignas(simd::ALIGNMENT) double positions[simd::LANES];
+    alignas(simd::ALIGNMENT) double values[simd::LANES];
+    (phase * simd::Vec::broadcast(BandLimitedWavetables::SIZE / Constants::TWO_PI)).store(positions);
+    for (size_t lane = 0; lane < simd::LANES; lane++) {
+        values[lane] = wavetables_.lookup(waveform, lanes.wavetableLevel[voice + lane], positions[lane]);
+    }
+    return simd::Vec::load(values);
+}
+
+/**
+ * @brief Compute the output of one operator slot across a lane group
+ * 
+ * The incoming modulation is quantized to the 22-bit frequency precision,
+ * scaled by each voice's modulation index and added to its phase. Groups
+ * whose voices use different waveforms on this slot evaluate each waveform
+ * present and blend per lane.
+ * 
+ * @param group The lane group being rendered
+ * @param opIndex The operator slot
+ * @param modulation Modulation input for every lane
+ * @return Operator output for every lane
+ */
+simd::Vec FMSynthesizer::generateOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec modulation) {
+    const OperatorLanes& lanes = lanes_[opIndex];
+    const int voice = group.firstVoice;
+    
+    if (group.fixedPoint) {
+        return generateFixedOperatorOutput(group, opIndex, modulation * simd::Vec::load(&lanes.modulationIndex[voice]));
+    }
+    
+    simd::Vec modRounded = simd::round(modulation * simd::Vec::broadcast(Constants::FREQ_PRECISION_SCALE)) *
+                           simd::Vec::broadcast(Constants::FREQ_PRECISION_INV);
+    simd::Vec phase = simd::Vec::load(&lanes.phaseAccumulator[voice]) +
+                      modRounded * simd::Vec::load(&lanes.modulationIndex[voice]);
+    return generateOperatorOutputAtPhase(group, opIndex, phase);
+}
+
+/**
+ * @brief Compute the output of one operator slot with an extra phase offset
+ * 
+ * Used for the feedback operator, whose self-modulation is added to the
+ * phase directly rather than scaled by the modulation index.
+ * 
+ * @param group The lane group being rendered
+ * @param opIndex The operator slot
+ * @param modulation Modulation input for every lane
+ * @param phaseOffset Phase offset in radians for every lane
+ * @return Operator output for every lane
+ */
+simd::Vec FMSynthesizer::generateOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec modulation,
+                                                simd::Vec phaseOffset) {
+    const OperatorLanes& lanes = lanes_[opIndex];
+    const int voice = group.firstVoice;
+    
+    if (group.fixedPoint) {
+        return generateFixedOperatorOutput(group, opIndex,
+                                           modulation * simd::Vec::load(&lanes.modulationIndex[voice]) + phaseOffset);
+    }
+    
+    simd::Vec modRounded = simd::round(modulation * simd::Vec::broadcast(Constants::FREQ_PRECISION_SCALE)) *
+                           simd::Vec::broadcast(Constants::FREQ_PRECISION_INV);
+    simd::Vec phase = simd::Vec::load(&lanes.phaseAccumulator[voice]) +
+                      modRounded * simd::Vec::load(&lanes.modulationIndex[voice]) + phaseOffset;
+    return generateOperatorOutputAtPhase(group, opIndex, phase);
+}
+
+/**
+ * @brief Evaluate an operator slot's waveform at the given phase
+ * 
+ * @param group The lane group being rendered
+ * @param opIndex The operator slot
+ * @param phase Phase in radians for every lane
+ * @return Operator output for every lane, scaled by amplitude and envelope
+ */
+simd::Vec FMSynthesizer::generateOperatorOutputAtPhase(const LaneGroup& group, int opIndex, simd::Vec phase) {
+    const OperatorLanes& lanes = lanes_[opIndex];
+    const int voice = group.firstVoice;
+    
+    simd::Vec output = simd::Vec::zero();
+    const auto& waveformLanes = group.waveformLanes[opIndex];
+    for (int waveform = 0; waveform < static_cast<int>(waveformLanes.size()); waveform++) {
+        if (!waveformLanes[waveform]) {
+            continue;
+        }
+        simd::Vec wave = generateWaveform(static_cast<WaveformType>(waveform), lanes, voice, phase);
+        if (waveformLanes[waveform] == simd::ALL_LANES) {
+            output = wave;
+            break;
+        }
+        output = simd::select(simd::maskFromBits(waveformLanes[waveform]), wave, output);
+    }
+    
+    return output * simd::Vec::load(&lanes.amplitude[voice]) * simd::Vec::load(&lanes.envelopeLevel[voice]);
+}
+
+/**
+ * @brief Sine table for the fixed-point oscillator
+ * 
+ * One full cycle quantized to the 22-bit amplitude precision, with a guard
+ * entry so interpolation never has to wrap the index.
+ */
+const FMSynthesizer::SineTable FMSynthesizer::SINE_TABLE = [] {
+    SineTable table{};
+    for (int i = 0; i <= Constants::SINE_TABLE_SIZE; i++) {
+        table[i] = static_cast<int32_t>(std::lround(
+            std::sin(Constants::TWO_PI * i / Constants::SINE_TABLE_SIZE) * Constants::FREQ_PRECISION_SCALE));
+    }
+    return table;
+}();
+
+/**
+ * @brief Evaluate a waveform at a fixed-point phase
+ * 
+ * The sine is linearly interpolated between table entries in integer
+ * arithmetic; the other shapes are derived directly from the phase bits.
+ * 
+ * @param waveform The waveform type
+ * @param phase Phase where 2^32 is one full cycle
+ * @return Waveform value (-1.0 to 1.0)
+ */
+double FMSynthesizer::generateFixedWaveform(WaveformType waveform, uint32_t phase) {
+    constexpr uint32_t HALF_CYCLE = 0x80000000u;
+    constexpr double INV_HALF_CYCLE = 1.0 / HALF_CYCLE;
+    
+    switch (waveform) {
+        case WaveformType::SINE: {
+            const uint32_t index = phase >> Constants::PHASE_FRACTION_BITS;
+            const int64_t fraction = phase & ((1u << Constants::PHASE_FRACTION_BITS) - 1);
+            const int64_t a = SINE_TABLE[index];
+            const int64_t b = SINE_TABLE[index + 1];
+            const int64_t value = a + (((b - a) * fraction) >> Constants::PHASE_FRACTION_BITS);
+            return static_cast<double>(value) * Constants::FREQ_PRECISION_INV;
+        }
+        case WaveformType::SAWTOOTH:
+            return phase * INV_HALF_CYCLE - 1.0;
+        case WaveformType::SQUARE:
+            return phase < HALF_CYCLE ? 1.0 : -1.0;
+        case WaveformType::TRIANGLE:
+            return phase < HALF_CYCLE ? 2.0 * phase * INV_HALF_CYCLE - 1.0 : 3.0 - 2.0 * phase * INV_HALF_CYCLE;
+    }
+    
+    return 0.0;
+}
+
+/**
+ * @brief Compute the output of one operator slot with the fixed-point oscillator
+ * 
+ * The phase offset is rounded to phase units and added to the 32-bit phase,
+ * where any overflow wraps around the cycle for free.
+ * 
+ * @param group The lane group being rendered
+ * @param opIndex The operator slot
+ * @param phaseOffset Phase offset in radians for every lane (modulation already scaled)
+ * @return Operator output for every lane, scaled by amplitude and envelope
+ */
+simd::Vec FMSynthesizer::generateFixedOperatorOutput(const LaneGroup& group, int opIndex, simd::Vec phaseOffset) {
+    const OperatorLanes& lanes = lanes_[opIndex];
+    const int voice = group.firstVoice;
+    const auto& waveformLanes = group.waveformLanes[opIndex];
+    
+    alignas(simd::ALIGNMENT) double offsets[simd::LANES];
+    simd::round(phaseOffset * simd::Vec::broadcast(Constants::PHASE_UNITS_PER_RADIAN)).store(offsets);
+    
+    alignas(simd::ALIGNMENT) double output[simd::LANES];
+    if (waveformLanes[static_cast<int>(WaveformType::SINE)] == simd::ALL_LANES) {
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            output[lane] = generateFixedWaveform(WaveformType::SINE, lanes.phase[voice + lane] +
+                                                 static_cast<uint32_t>(static_cast<int64_t>(offsets[lane])));
+        }
+    } else {
+        for (size_t lane = 0; lane < simd::LANES; lane++) {
+            int waveform = 0;
+            while (waveform < static_cast<int>(waveformLanes.size()) - 1 && !(waveformLanes[waveform] & (1u << lane))) {
+                waveform++;
+            }
+            output[lane] = generateFixedWaveform(static_cast<WaveformType>(waveform), lanes.phase[voice + lane] +
+                                                 static_cast<uint32_t>(static_cast<int64_t>(offsets[lane])));
+        }
+    }
+    
+    return simd::Vec::load(output) * simd::Vec::load(&lanes.amplitude[voice]) *
+           simd::Vec::load(&lanes.envelopeLevel[voice]);
+}
+
+/**
+ * @brief Phase offset fed back into a lane group's feedback operator
+ * 
+ * @param group The lane group being rendered
+ * @return The scaled average of the last two feedback outputs
+ */
+simd::Vec FMSynthesizer::feedbackPhase(const LaneGroup& group) const {
+    const int voice = group.firstVoice;
+    return simd::Vec::load(&feedback_.level[voice]) *
+           (simd::Vec::load(&feedback_.previous[voice]) + simd::Vec::load(&feedback_.previous2[voice]));
+}
+
+/**
+ * @brief Push a new feedback operator output into the history
+ * 
+ * Only the lanes the current kernel was selected for are updated, so lanes
+ * on a channel running a different algorithm keep their own history.
+ * 
+ * @param group The lane group being rendered
+ * @param output The feedback operator's output for this sample
+ */
+void FMSynthesizer::updateFeedback(const LaneGroup& group, simd::Vec output) {
+    const int voice = group.firstVoice;
+    const simd::Mask lanes = simd::maskFromBits(group.kernelLanes);
+    simd::Vec previous = simd::Vec::load(&feedback_.previous[voice]);
+    simd::select(lanes, previous, simd::Vec::load(&feedback_.previous2[voice])).store(&feedback_.previous2[voice]);
+    simd::select(lanes, output, previous).store(&feedback_.previous[voice]);
+}
+
+/**
+ * @brief Advance the phase accumulators of a lane group by one sample
+ * 
+ * In fixed-point mode the 32-bit phases simply overflow back to the start
+ * of the cycle; otherwise the floating-point phases are wrapped at 2π.
+ * 
+ * @param group The lane group being rendered
+ * @param activeLanes Lanes whose voices are sounding; other lanes are left untouched
+ */
+void FMSynthesizer::updateOperatorPhases(const LaneGroup& group, unsigned activeLanes) {
+    const int voice = group.firstVoice;
+    
+    if (group.fixedPoint) {
+        for (auto& lanes : lanes_) {
+            for (size_t lane = 0; lane < simd::LANES; lane++) {
+                if (activeLanes & (1u << lane)) {
+                    lanes.phase[voice + lane] += lanes.phaseStep[voice + lane];
                 }
             }
         }
+        return;
+    }
+    
+    const simd::Vec twoPi = simd::Vec::broadcast(Constants::TWO_PI);
+    const simd::Mask active = simd::maskFromBits(activeLanes);
+    for (auto& lanes : lanes_) {
+        double* accumulator = &lanes.phaseAccumulator[voice];
+        simd::Vec phase = simd::Vec::load(accumulator);
+        simd::Vec next = phase + simd::Vec::load(&lanes.bentIncrement[voice]);
+        next = simd::select(next >= twoPi, next - twoPi, next);
+        simd::select(active, next, phase).store(accumulator);
     }
 }
 
-void FMSynthesizer::setModulationWheel(int channel, double mod) {
-    if (channel >= 0 && channel < Constants::MAX_CHANNELS) {
-        channels_[channel].modulationWheel = mod;
+/**
+ * @brief Recompute the cached phase increments and table level of one operator
+ * 
+ * Called whenever the frequency, the channel's applied pitch bend, the
+ * sample rate or the oversampling factor changes, so the per-sample update is a single add in either
+ * oscillator mode and the oscillator never has to work out which
+ * band-limited table to read.
+ * 
+ * @param opIndex The operator slot
+ * @param voice The voice
+ */
+void FMSynthesizer::updatePhaseStep(int opIndex, int voice) {
+    OperatorLanes& lanes = lanes_[opIndex];
+    const double increment = lanes.phaseIncrement[voice] * channels_[voices_[voice].channel].appliedPitchBend
+                           / renderOversampling_;
+    lanes.bentIncrement[voice] = increment;
+    lanes.phaseStep[voice] = static_cast<uint32_t>(std::llround(increment * Constants::PHASE_UNITS_PER_RADIAN));
+    lanes.wavetableLevel[voice] = BandLimitedWavetables::levelForIncrement(increment / Constants::TWO_PI);
+}
+
+/**
+ * @brief Carry the oscillator phases over to another oscillator mode
+ * 
+ * Runs on the render thread between blocks, so sounding notes continue
+ * from the same point in their cycle instead of jumping.
+ * 
+ * @param mode The mode to switch to
+ */
+void FMSynthesizer::convertOscillatorPhases(OscillatorMode mode) {
+    for (auto& lanes : lanes_) {
         for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-            if (voices_[voice].channel == channel) {
-                for (auto& op : voices_[voice].operators) {
-                    op.modulationWheel = mod;
-                }
+            if (mode == OscillatorMode::FIXED_POINT) {
+                lanes.phase[voice] = static_cast<uint32_t>(
+                    std::llround(lanes.phaseAccumulator[voice] * Constants::PHASE_UNITS_PER_RADIAN));
+            } else {
+                lanes.phaseAccumulator[voice] = lanes.phase[voice] / Constants::PHASE_UNITS_PER_RADIAN;
             }
         }
     }
+    renderOscillatorMode_ = mode;
 }
 
-void FMSynthesizer::setReverb(double amount) {
-    reverbAmount_ = std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT);
+/**
+ * @brief Select the oscillator implementation
+ * 
+ * FLOATING_POINT evaluates the waveforms from double-precision phases.
+ * FIXED_POINT uses 32-bit integer phases and an interpolated 22-bit sine
+ * table, as the hardware this emulates does, which is cheaper per operator
+ * and gives identical output on every platform. The change takes effect at
+ * the start of the next block.
+ * 
+ * @param mode The oscillator mode to use
+ */
+void FMSynthesizer::setOscillatorMode(OscillatorMode mode) {
+    oscillatorMode_.store(mode, std::memory_order_relaxed);
 }
 
-void FMSynthesizer::setChorus(double amount) {
-    chorusAmount_ = std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT);
+OscillatorMode FMSynthesizer::getOscillatorMode() const {
+    return oscillatorMode_.load(std::memory_order_relaxed);
 }
 
-void FMSynthesizer::setDistortion(double amount) {
-    distortionAmount_ = std::clamp(amount, Constants::MIN_EFFECT_AMOUNT, Constants::MAX_EFFECT_AMOUNT);
+/**
+ * @brief Run the operators at a multiple of the sample rate
+ * 
+ * High modulation indices put sidebands far above the output Nyquist
+ * frequency, which fold back as inharmonic noise. With a factor of 2 or 4
+ * only the operators and their phase updates run at that multiple; each
+ * voice's output is then brought back to the sample rate by polyphase
+ * half-band filters (see VoiceDecimator). Envelopes, the insert and bus
+ * effects and the output conversion stay at the sample rate, so this costs
+ * far less than raising the sample rate itself. Anything other than 2 or 4
+ * turns oversampling off. Takes effect at the start of the next block.
+ * 
+ * @param factor The oversampling factor: 1, 2 or 4
+ */
+void FMSynthesizer::setOversampling(int factor) {
+    oversampling_.store(factor == 2 || factor == 4 ? factor : 1, std::memory_order_relaxed);
 }
 
-void FMSynthesizer::setPresetConfig(const std::array<double, 6>& frequencies,
-                                   const std::array<double, 6>& amplitudes,
-                                   const std::array<double, 6>& modulationIndices,
-                                   const std::array<WaveformType, 6>& waveforms,
-                                   const std::array<double, 6>& attacks,
-                                   const std::array<double, 6>& decays,
-                                   const std::array<double, 6>& sustains,
-                                   const std::array<double, 6>& releases) {
-    for (int i = 0; i < 6; i++) {
-        currentPreset_.frequencies[i] = frequencies[i];
-        currentPreset_.amplitudes[i] = amplitudes[i];
-        currentPreset_.modulationIndices[i] = modulationIndices[i];
-        currentPreset_.waveforms[i] = waveforms[i];
-        currentPreset_.attacks[i] = attacks[i];
-        currentPreset_.decays[i] = decays[i];
-        currentPreset_.sustains[i] = sustains[i];
-        currentPreset_.releases[i] = releases[i];
+int FMSynthesizer::getOversampling() const {
+    return oversampling_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Switch the core rate between blocks (render thread only)
+ * 
+ * Rescales every cached phase increment to the new core rate and clears
+ * the decimator history, which belongs to the old rate.
+ * 
+ * @param factor The factor to switch to
+ */
+void FMSynthesizer::applyOversampling(int factor) {
+    renderOversampling_ = factor;
+    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
+        for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+            updatePhaseStep(op, voice);
+        }
     }
-    
+    decimator_.reset();
 }
 
-void FMSynthesizer::updateOperatorPhase(Operator& op) {
-    updateOperatorPhase22Bit(op);
+/**
+ * @brief Select which voice a note takes when every voice is busy
+ * 
+ * Takes effect from the next steal.
+ * 
+ * @param policy The steal policy to use
+ */
+void FMSynthesizer::setVoiceStealPolicy(VoiceStealPolicy policy) {
+    stealPolicy_.store(policy, std::memory_order_relaxed);
 }
 
-void FMSynthesizer::updateEnvelope(Operator& op) {
-    op.envelopeTime += timeStep_;
-    
-    switch (static_cast<EnvelopeState>(op.envelopeState)) {
-        case EnvelopeState::ATTACK:
-            op.envelopeLevel = op.envelopeTime / op.attack;
-            if (op.envelopeLevel >= Constants::MAX_VOLUME) {
-                op.envelopeLevel = Constants::MAX_VOLUME;
-                op.envelopeState = static_cast<int>(EnvelopeState::DECAY);
-                op.envelopeTime = 0.0;
-            }
-            break;
-            
-        case EnvelopeState::DECAY:
-            op.envelopeLevel = Constants::MAX_VOLUME - (op.envelopeTime / op.decay) * (Constants::MAX_VOLUME - op.sustain);
-            if (op.envelopeLevel <= op.sustain) {
-                op.envelopeLevel = op.sustain;
-                op.envelopeState = static_cast<int>(EnvelopeState::SUSTAIN);
-            }
-            break;
-            
-        case EnvelopeState::SUSTAIN:
-            op.envelopeLevel = op.sustain;
-            break;
-            
-        case EnvelopeState::RELEASE:
-            op.envelopeLevel = op.sustain * (Constants::MAX_VOLUME - op.envelopeTime / op.release);
-            if (op.envelopeLevel <= Constants::MIN_VOLUME || 
-                op.envelopeTime >= op.release) {
-                op.envelopeLevel = Constants::MIN_VOLUME;
-                op.envelopeState = static_cast<int>(EnvelopeState::OFF);
-            }
-            break;
-            
-        case EnvelopeState::OFF:
-            op.envelopeLevel = Constants::MIN_VOLUME;
-            break;
-    }
+VoiceStealPolicy FMSynthesizer::getVoiceStealPolicy() const {
+    return stealPolicy_.load(std::memory_order_relaxed);
 }
 
-double FMSynthesizer::generateOperatorOutput(Operator& op, double modulation) {
-    double modScaled = modulation * Constants::FREQ_PRECISION_SCALE;
-    double modRounded = round(modScaled) * Constants::FREQ_PRECISION_INV;
-    
-    double phase = op.phaseAccumulator + modRounded * op.modulationIndex;
-    double output = 0.0;
-    /* not sure if this makes sense on a yamaha..... lol */
-    switch (static_cast<WaveformType>(op.waveform)) {
-        case WaveformType::SINE:
-            output = sin(phase);
-            break;
-        case WaveformType::SAWTOOTH:
-            output = 2.0 * (phase / Constants::TWO_PI) - 1.0;
-            break;
-        case WaveformType::SQUARE:
-            output = (phase < Constants::PI) ? 1.0 : -1.0;
-            break;
-        case WaveformType::TRIANGLE:
-            if (phase < Constants::PI) {
-                output = 2.0 * (phase / Constants::PI) - 1.0;
-            } else {
-                output = 3.0 - 2.0 * (phase / Constants::PI);
-            }
-            break;
-    }
-    
-    return output * op.amplitude * op.envelopeLevel * op.velocity;
+/**
+ * @brief Set how many voices may play at once
+ * 
+ * Storage for MAX_VOICES voices is allocated with the synthesizer, so this
+ * only moves the limit; the renderer applies it at the start of its next
+ * block. Lowering it fades out the voices above the new limit.
+ * 
+ * @param voices The polyphony (clamped to MIN_VOICES..MAX_VOICES)
+ */
+void FMSynthesizer::setMaxVoices(int voices) {
+    maxVoices_ = std::clamp(voices, Constants::MIN_VOICES, Constants::MAX_VOICES);
+    postEvent(SynthEvent::Type::VOICE_LIMIT, 0, maxVoices_);
 }
 
-double FMSynthesizer::applyEffects(double sample, int channel) {
-    if (distortionAmount_ > Constants::MIN_EFFECT_AMOUNT) {
-        sample = tanh(sample * (Constants::MAX_VOLUME + distortionAmount_ * Constants::DISTORTION_GAIN_MULTIPLIER));
-    }
-    
-    if (chorusAmount_ > Constants::MIN_EFFECT_AMOUNT) {
-        double chorusMod = sin(Constants::TWO_PI * Constants::CHORUS_FREQUENCY * timeStep_) * chorusAmount_ * Constants::CHORUS_DEPTH;
-        sample *= (Constants::MAX_VOLUME + chorusMod);
-    }
-    
-    if (reverbAmount_ > Constants::MIN_EFFECT_AMOUNT) {
-        sample *= (Constants::MAX_VOLUME + reverbAmount_ * Constants::REVERB_GAIN);
+/**
+ * @brief Resolve the effect settings for one block
+ * 
+ * Evaluates the distortion enable and drive once so the per-sample path
+ * only applies precomputed factors, and latches the chorus and reverb send
+ * levels for whichever bus this block is mixed into.
+ * 
+ * @return The effect parameters to use for the current block
+ */
+FMSynthesizer::BlockEffects FMSynthesizer::prepareEffects() const {
+    BlockEffects effects;
+    effects.distortion = distortionAmount_ > Constants::MIN_EFFECT_AMOUNT;
+    effects.distortionDrive = Constants::MAX_VOLUME + distortionAmount_ * Constants::DISTORTION_GAIN_MULTIPLIER;
+    effects.chorusSend = chorusAmount_;
+    effects.reverbSend = reverbAmount_;
+    return effects;
+}
+
+/**
+ * @brief Apply the per-voice insert effects to a lane group's output
+ * 
+ * Only distortion is per voice, since it has to shape each note on its own;
+ * chorus and reverb run once per block on the mixed bus.
+ */
+simd::Vec FMSynthesizer::applyEffects(simd::Vec sample, const BlockEffects& effects) const {
+    if (effects.distortion) {
+        alignas(simd::ALIGNMENT) double lanes[simd::LANES];
+        sample.store(lanes);
+        for (double& value : lanes) {
+            value = tanh(value * effects.distortionDrive);
+        }
+        sample = simd::Vec::load(lanes);
     }
     
     return sample;
@@ -732,6 +2105,18 @@ double FMSynthesizer::noteToFrequency22Bit(int note) {
     return freqRounded;
 }
 
+/**
+ * @brief Convert a channel feedback amount to the per-voice lane value
+ * 
+ * Folds the averaging of the two history samples into the scale.
+ * 
+ * @param amount Feedback amount (0.0 to 1.0)
+ * @return Multiplier applied to the sum of the last two feedback outputs
+ */
+double FMSynthesizer::feedbackLevel(double amount) {
+    return amount * Constants::MAX_FEEDBACK_DEPTH * 0.5;
+}
+
 /**
  * @brief Calculate phase increment with 22-bit precision
  * 
@@ -750,79 +2135,424 @@ double FMSynthesizer::calculatePhaseIncrement22Bit(double frequency) {
     return phaseIncrement;
 }
 
-void FMSynthesizer::updateOperatorPhase22Bit(Operator& op) {
-    double phaseInc = calculatePhaseIncrement22Bit(op.frequency);
+/**
+ * @brief Constructor for FMSynthesizerManager
+ * 
+ * @param sampleRate The audio sample rate in Hz
+ * @param workerThreads Render threads to start besides the caller of
+ *                      renderBlock(); negative picks one per spare core
+ */
+FMSynthesizerManager::FMSynthesizerManager(int sampleRate, int workerThreads) 
+    : sampleRate_(sampleRate), masterVolume_(Constants::MAX_VOLUME), blockVolume_(Constants::MAX_VOLUME),
+      controlSampleRate_(sampleRate),
+      globalReverb_(Constants::MIN_EFFECT_AMOUNT), globalChorus_(Constants::MIN_EFFECT_AMOUNT), 
+      globalDistortion_(Constants::MIN_EFFECT_AMOUNT),
+      pool_(workerThreads < 0 ? RenderWorkerPool::defaultWorkerCount() : static_cast<size_t>(workerThreads)),
+      taskCount_(0), blockFrames_(0), effects_(sampleRate), idle_(sampleRate) {
+    channelVolumes_.fill(Constants::MAX_VOLUME);
+    channelPitchBends_.fill(Constants::MAX_VOLUME);
+    channelModulations_.fill(Constants::MIN_EFFECT_AMOUNT);
+}
+
+FMSynthesizerManager::~FMSynthesizerManager() {
+    for (const auto& synth : synthesizers_) {
+        if (synth) {
+            synth->wakeSignal_.store(&synth->idle_, std::memory_order_release);
+        }
+    }
+}
+
+/**
+ * @brief Add a synthesizer to the layered mix
+ * 
+ * Not real-time safe: must not be called while renderBlock() is running.
+ * From now on, events queued on the synthesizer wake the manager's
+ * renderer.
+ * 
+ * @param synth The synthesizer to add
+ */
+void FMSynthesizerManager::addSynthesizer(std::shared_ptr<FMSynthesizer> synth) {
+    if (synth) {
+        synth->wakeSignal_.store(&idle_, std::memory_order_release);
+    }
+    synthesizers_.push_back(synth);
+    strips_.push_back({Constants::MAX_VOLUME, Constants::PAN_CENTER});
+    reserveRenderTasks();
+}
+
+void FMSynthesizerManager::removeSynthesizer(std::shared_ptr<FMSynthesizer> synth) {
+    for (size_t index = synthesizers_.size(); index-- > 0;) {
+        if (synthesizers_[index] == synth) {
+            if (synth) {
+                synth->wakeSignal_.store(&synth->idle_, std::memory_order_release);
+            }
+            synthesizers_.erase(synthesizers_.begin() + index);
+            strips_.erase(strips_.begin() + index);
+        }
+    }
+    reserveRenderTasks();
+}
+
+/**
+ * @brief Set how loud a synthesizer is on the shared bus
+ * 
+ * @param index Position of the synthesizer in the order it was added
+ * @param gain Linear gain (clamped to MIN_VOLUME..MAX_VOLUME)
+ */
+void FMSynthesizerManager::setSynthesizerGain(size_t index, double gain) {
+    if (index < strips_.size()) {
+        strips_[index].gain.store(std::clamp(gain, Constants::MIN_VOLUME, Constants::MAX_VOLUME), std::memory_order_relaxed);
+    }
+}
+
+double FMSynthesizerManager::getSynthesizerGain(size_t index) const {
+    return index < strips_.size() ? strips_[index].gain.load(std::memory_order_relaxed) : Constants::MIN_VOLUME;
+}
+
+/**
+ * @brief Place a synthesizer in the stereo field of the shared bus
+ * 
+ * A balance control: the centre leaves both sides untouched and moving
+ * towards one side fades out the other, so a centred synthesizer sounds
+ * exactly as it does on its own.
+ * 
+ * @param index Position of the synthesizer in the order it was added
+ * @param pan -1 for hard left to 1 for hard right (clamped)
+ */
+void FMSynthesizerManager::setSynthesizerPan(size_t index, double pan) {
+    if (index < strips_.size()) {
+        strips_[index].pan.store(std::clamp(pan, Constants::MIN_MIXER_PAN, Constants::MAX_MIXER_PAN), std::memory_order_relaxed);
+    }
+}
+
+double FMSynthesizerManager::getSynthesizerPan(size_t index) const {
+    return index < strips_.size() ? strips_[index].pan.load(std::memory_order_relaxed) : Constants::PAN_CENTER;
+}
+
+/**
+ * @brief Size the task list and scratch buses for every possible voice slice
+ * 
+ * Done whenever the synthesizer list changes so rendering never allocates.
+ */
+void FMSynthesizerManager::reserveRenderTasks() {
+    const size_t slices = synthesizers_.size() * FMSynthesizer::VOICE_SLICES;
+    tasks_.resize(slices);
+    scratch_.resize(slices);
+}
+
+/**
+ * @brief Render all synthesizers, summed, as stereo float audio
+ * 
+ * The active voice slices of every synthesizer are rendered in parallel by
+ * the worker pool, each into its own scratch bus, and the buses are then
+ * summed in a fixed order through each synthesizer's gain and pan, and into
+ * the shared chorus and reverb at its send levels. The result is identical
+ * whatever the number of worker threads or how the tasks were scheduled.
+ * 
+ * @param left Output buffer for the left channel
+ * @param right Output buffer for the right channel
+ * @param frames Number of frames to render
+ */
+void FMSynthesizerManager::renderBlock(float* left, float* right, size_t frames) {
+    const uint64_t start = RenderTelemetry::now();
+    applySampleRate();
+    const uint64_t deadline = static_cast<uint64_t>(frames) * 1000000000ULL / sampleRate_;
+    promoteRenderThread();
+    stampClocks(frames);
+    while (frames > 0) {
+        size_t chunk = std::min(frames, static_cast<size_t>(Constants::MAX_BLOCK_SIZE));
+        mixBlock(chunk);
+        
+        for (size_t frame = 0; frame < chunk; frame++) {
+            left[frame] = static_cast<float>(mixLeft_[frame] * blockVolume_);
+            right[frame] = static_cast<float>(mixRight_[frame] * blockVolume_);
+        }
+        
+        left += chunk;
+        right += chunk;
+        frames -= chunk;
+    }
+    telemetry_.recordBlock(RenderTelemetry::now() - start, deadline);
+}
+
+/**
+ * @brief Render all synthesizers as interleaved 16-bit samples
+ * 
+ * This is what the single QtAudioOutput pulls from: the mix is scaled and
+ * clamped to the emulated DAC range once, after all synthesizers are summed.
+ * 
+ * @param interleaved Destination buffer (frames * 2 samples)
+ * @param frames Number of frames to render
+ */
+void FMSynthesizerManager::renderBlock(int16_t* interleaved, size_t frames) {
+    const uint64_t start = RenderTelemetry::now();
+    applySampleRate();
+    const uint64_t deadline = static_cast<uint64_t>(frames) * 1000000000ULL / sampleRate_;
+    promoteRenderThread();
+    stampClocks(frames);
+    while (frames > 0) {
+        size_t chunk = std::min(frames, static_cast<size_t>(Constants::MAX_BLOCK_SIZE));
+        mixBlock(chunk);
+        
+        for (size_t frame = 0; frame < chunk; frame++) {
+            interleaved[frame * 2] = static_cast<int16_t>(std::clamp(mixLeft_[frame] * blockVolume_ * Constants::AUDIO_SCALE, 
+                                                                    static_cast<double>(Constants::AUDIO_MIN_VALUE), 
+                                                                    static_cast<double>(Constants::AUDIO_MAX_VALUE)));
+            interleaved[frame * 2 + 1] = static_cast<int16_t>(std::clamp(mixRight_[frame] * blockVolume_ * Constants::AUDIO_SCALE, 
+                                                                        static_cast<double>(Constants::AUDIO_MIN_VALUE), 
+                                                                        static_cast<double>(Constants::AUDIO_MAX_VALUE)));
+        }
+        
+        interleaved += chunk * 2;
+        frames -= chunk;
+    }
+    telemetry_.recordBlock(RenderTelemetry::now() - start, deadline);
+}
+
+/**
+ * @brief Promote the calling thread if setRealtimeMode() asked for it
+ * 
+ * The thread that renders belongs to the audio output and only exists once
+ * the output has started, so it promotes itself on the first block after
+ * real-time mode was enabled, taking the first configured core. The result
+ * is published to getRealtimeStatus() once it is complete.
+ */
+void FMSynthesizerManager::promoteRenderThread() {
+    if (!promoteRenderThread_.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+    renderThreadStatus_ = promoteCurrentThread(realtimeConfig_, 0, 1000000000ULL * Constants::MAX_BLOCK_SIZE / sampleRate_);
+    renderThreadPromoted_.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Switch the shared bus to the rate setSampleRate() asked for, if any
+ * 
+ * The synthesizers switch at their own SAMPLE_RATE events, which they reach
+ * in the same block.
+ */
+void FMSynthesizerManager::applySampleRate() {
+    const int sampleRate = pendingSampleRate_.exchange(0, std::memory_order_acquire);
+    if (sampleRate == 0 || sampleRate == sampleRate_) {
+        return;
+    }
+    sampleRate_ = sampleRate;
+    effects_.setSampleRate(sampleRate);
+    idle_.setSampleRate(sampleRate);
+}
+
+void FMSynthesizerManager::stampClocks(size_t frames) {
+    for (const auto& synth : synthesizers_) {
+        if (synth) {
+            synth->stampClock(frames);
+        }
+    }
+}
+
+/**
+ * @brief Render one block of every synthesizer into the mix buffers
+ * 
+ * All synthesizers share one timeline, so the block is split wherever any
+ * of them has an input event due, and each span is rendered across the
+ * pool like a whole block.
+ */
+void FMSynthesizerManager::mixBlock(size_t frames) {
+    blockVolume_ = masterVolume_.load(std::memory_order_relaxed);
+    std::fill_n(mixLeft_.begin(), frames, 0.0);
+    std::fill_n(mixRight_.begin(), frames, 0.0);
     
-    double pitchBendPhaseInc = phaseInc * op.pitchBend;
+    effects_.beginBlock();
+    size_t offset = 0;
+    while (offset < frames) {
+        const size_t span = mixSpan(offset, frames - offset);
+        for (const auto& synth : synthesizers_) {
+            if (synth) {
+                synth->endBlock(span);
+            }
+        }
+        offset += span;
+    }
+    effects_.process(mixLeft_.data(), mixRight_.data(), frames);
     
-    op.phaseAccumulator += pitchBendPhaseInc;
+    if (scope_.write(mixLeft_.data(), mixRight_.data(), frames, blockVolume_)) {
+        std::array<float, Constants::MAX_OPERATORS> levels{};
+        for (const auto& synth : synthesizers_) {
+            if (synth) {
+                synth->measureOperatorLevels(levels);
+            }
+        }
+        scope_.publish(levels, sampleRate_);
+    }
     
-    if (op.phaseAccumulator >= Constants::TWO_PI) {
-        op.phaseAccumulator -= Constants::TWO_PI;
+    if (idle_.trackSilence(mixLeft_.data(), mixRight_.data(), frames, blockVolume_, [this] { return hasPendingWork(); })) {
+        for (const auto& synth : synthesizers_) {
+            if (synth) {
+                synth->pauseClock();
+            }
+        }
     }
 }
 
-
 /**
- * @brief Find an available voice for playing a note
+ * @brief Ask for real-time scheduling of the render workers
  * 
- * Searches for a voice that is not currently playing a note.
- * If no voices are available, returns -1.
+ * Every worker of the pool promotes itself (see promoteCurrentThread()),
+ * worker i taking the configured core after the i-th, and the mix buffers,
+ * the bus effects and every registered synthesizer are locked in memory.
+ * The thread that calls renderBlock() belongs to the audio output, so it
+ * promotes itself on its next block with the first configured core; until
+ * then getRealtimeStatus() reports it as pending. Not real-time safe: must
+ * not be called while renderBlock() is running, and synthesizers added
+ * later are not locked.
  * 
- * @return The index of an available voice, or -1 if none available
+ * @param config What to ask the OS for
+ * @return Whatever the OS refused for the workers, which is also printed
  */
-int FMSynthesizer::findFreeVoice() {
-    for (int voice = 0; voice < Constants::MAX_VOICES; voice++) {
-        if (!voices_[voice].active) {
-            return voice;
+RealtimeStatus FMSynthesizerManager::setRealtimeMode(const RealtimeConfig& config) {
+    realtimeConfig_ = config;
+    renderThreadPromoted_.store(false, std::memory_order_relaxed);
+    promoteRenderThread_.store(config.enabled, std::memory_order_release);
+    
+    RealtimeStatus status = pool_.promoteWorkers(config, 1000000000ULL * Constants::MAX_BLOCK_SIZE / controlSampleRate_);
+    status.requested = config.enabled;
+    if (config.enabled && config.lockMemory) {
+        lockMemory(status, this, sizeof(*this));
+        lockMemory(status, tasks_);
+        lockMemory(status, scratch_);
+        effects_.lockBuffers(status);
+        for (const auto& synth : synthesizers_) {
+            if (synth) {
+                synth->lockBuffers(status);
+            }
         }
     }
-    return -1;
+    if (!status.denials.empty()) {
+        printf("Real-time mode: %s\n", status.describe().c_str());
+    }
+    realtimeStatus_ = status;
+    return status;
 }
 
 /**
- * @brief Release a voice and stop it from playing
+ * @brief What real-time mode got, for the workers and the render thread
  * 
- * Stops the specified voice and marks it as available for new notes.
- * 
- * @param voice The index of the voice to release
+ * The render thread only counts once it has rendered a block since
+ * setRealtimeMode(), so this is not granted before audio has started.
  */
-void FMSynthesizer::releaseVoice(int voice) {
-    if (voice >= 0 && voice < Constants::MAX_VOICES) {
-        voices_[voice].active = false;
-        voices_[voice].note = -1;
+RealtimeStatus FMSynthesizerManager::getRealtimeStatus() const {
+    RealtimeStatus status = realtimeStatus_;
+    if (renderThreadPromoted_.load(std::memory_order_acquire)) {
+        status.merge(renderThreadStatus_);
     }
+    return status;
 }
 
-FMSynthesizerManager::FMSynthesizerManager(int sampleRate) 
-    : sampleRate_(sampleRate), masterVolume_(Constants::MAX_VOLUME),
-      globalReverb_(Constants::MIN_EFFECT_AMOUNT), globalChorus_(Constants::MIN_EFFECT_AMOUNT), 
-      globalDistortion_(Constants::MIN_EFFECT_AMOUNT) {
-    channelVolumes_.fill(Constants::MAX_VOLUME);
-    channelPitchBends_.fill(Constants::MAX_VOLUME);
-    channelModulations_.fill(Constants::MIN_EFFECT_AMOUNT);
+bool FMSynthesizerManager::hasPendingWork() const {
+    for (const auto& synth : synthesizers_) {
+        if (synth && synth->hasPendingWork()) {
+            return true;
+        }
+    }
+    return false;
 }
 
-FMSynthesizerManager::~FMSynthesizerManager() {
+/**
+ * @brief Render the frames up to the next input event of any synthesizer
+ * 
+ * @param offset Frame of the block the span starts at
+ * @param frames Frames left in the block
+ * @return The number of frames rendered
+ */
+size_t FMSynthesizerManager::mixSpan(size_t offset, size_t frames) {
+    taskCount_ = 0;
+    int activeVoices = 0;
+    for (size_t index = 0; index < synthesizers_.size(); index++) {
+        FMSynthesizer* synth = synthesizers_[index].get();
+        if (!synth) {
+            continue;
+        }
+        frames = synth->beginBlock(frames);
+        
+        const double gain = strips_[index].gain.load(std::memory_order_relaxed) * synth->masterVolume_;
+        const double pan = strips_[index].pan.load(std::memory_order_relaxed);
+        const double leftGain = gain * (pan > 0.0 ? 1.0 - pan : 1.0);
+        const double rightGain = gain * (pan < 0.0 ? 1.0 + pan : 1.0);
+        activeVoices += synth->activeVoiceCount_;
+        const FMSynthesizer::BlockEffects& sends = synth->blockEffects_;
+        for (int slice = 0; slice < FMSynthesizer::VOICE_SLICES; slice++) {
+            if (synth->isVoiceSliceActive(slice)) {
+                tasks_[taskCount_++] = {synth, slice, leftGain, rightGain, sends.chorusSend, sends.reverbSend};
+            }
+        }
+    }
+    
+    telemetry_.setActiveVoices(activeVoices);
+    
+    blockFrames_ = frames;
+    pool_.run(&FMSynthesizerManager::renderTask, this, taskCount_);
+    
+    double* mixLeft = mixLeft_.data() + offset;
+    double* mixRight = mixRight_.data() + offset;
+    for (size_t task = 0; task < taskCount_; task++) {
+        const ScratchBus& bus = scratch_[task];
+        const RenderTask& renderTask = tasks_[task];
+        const double leftGain = renderTask.leftGain;
+        const double rightGain = renderTask.rightGain;
+        for (size_t frame = 0; frame < frames; frame++) {
+            mixLeft[frame] += bus.left[frame] * leftGain;
+            mixRight[frame] += bus.right[frame] * rightGain;
+        }
+        effects_.addSend(bus.left.data(), bus.right.data(), frames, leftGain, rightGain,
+                         renderTask.chorusSend, renderTask.reverbSend, offset);
+    }
+    return frames;
 }
 
-void FMSynthesizerManager::addSynthesizer(std::shared_ptr<FMSynthesizer> synth) {
-    synthesizers_.push_back(synth);
+/**
+ * @brief Statistics of the shared bus since the previous call
+ * 
+ * Block times, load and xruns are the manager's own; voice steals are
+ * totalled over every registered synthesizer. Call from one polling thread.
+ */
+RenderStatistics FMSynthesizerManager::collectStatistics() {
+    RenderStatistics stats = telemetry_.collect();
+    for (const auto& synth : synthesizers_) {
+        if (synth) {
+            stats.voiceSteals += synth->getTelemetry().collect().voiceSteals;
+        }
+    }
+    return stats;
 }
 
-void FMSynthesizerManager::removeSynthesizer(std::shared_ptr<FMSynthesizer> synth) {
-    synthesizers_.erase(
-        std::remove(synthesizers_.begin(), synthesizers_.end(), synth),
-        synthesizers_.end()
-    );
+void FMSynthesizerManager::renderTask(void* context, size_t task) {
+    auto* manager = static_cast<FMSynthesizerManager*>(context);
+    const RenderTask& renderTask = manager->tasks_[task];
+    ScratchBus& bus = manager->scratch_[task];
+    
+    std::fill_n(bus.left.begin(), manager->blockFrames_, 0.0);
+    std::fill_n(bus.right.begin(), manager->blockFrames_, 0.0);
+    renderTask.synth->renderVoiceSlice(renderTask.slice, manager->blockFrames_, bus.left.data(), bus.right.data());
 }
 
 void FMSynthesizerManager::setMasterVolume(double volume) {
-    masterVolume_ = std::clamp(volume, Constants::MIN_VOLUME, Constants::MAX_VOLUME);
+    masterVolume_.store(std::clamp(volume, Constants::MIN_VOLUME, Constants::MAX_VOLUME), std::memory_order_relaxed);
 }
 
+/**
+ * @brief Set the sample rate of the shared bus and every synthesizer
+ * 
+ * Safe while rendering: the rate is handed to the render thread, which
+ * switches the bus effects and the idle detector at its next block, and
+ * each synthesizer queues the change like its other controls. Synthesizers
+ * added later keep the rate they were created with.
+ * 
+ * @param sampleRate The new sample rate in Hz, clamped to
+ *                   MIN_SAMPLE_RATE..MAX_SAMPLE_RATE
+ */
 void FMSynthesizerManager::setSampleRate(int sampleRate) {
-    sampleRate_ = sampleRate;
+    sampleRate = std::clamp(sampleRate, Constants::MIN_SAMPLE_RATE, Constants::MAX_SAMPLE_RATE);
+    controlSampleRate_ = sampleRate;
+    pendingSampleRate_.store(sampleRate, std::memory_order_release);
     for (auto& synth : synthesizers_) {
         if (synth) {
             synth->setSampleRate(sampleRate);
@@ -919,7 +2649,6 @@ void FMSynthesizer::setAudioScale(double scale) { audioScale_ = scale; }
 void FMSynthesizer::setMidiA4Note(int note) { midiA4Note_ = note; }
 void FMSynthesizer::setMidiA4Frequency(double frequency) { midiA4Frequency_ = frequency; }
 void FMSynthesizer::setMidiNotesPerOctave(int notes) { midiNotesPerOctave_ = notes; }
-void FMSynthesizer::setMaxVoices(int voices) { maxVoices_ = voices; }
 void FMSynthesizer::setMaxOperators(int operators) { maxOperators_ = operators; }
 void FMSynthesizer::setMaxChannels(int channels) { maxChannels_ = channels; }
 void FMSynthesizer::setMaxAlgorithms(int algorithms) { maxAlgorithms_ = algorithms; }
@@ -0,0 +1,86 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "fm/idle.hpp"
+
+namespace toybasic {
+
+/**
+ * @brief Constructor for IdleSignal
+ *
+ * @param sampleRate Rate of the rendered audio, which sets the tail length
+ */
+IdleSignal::IdleSignal(int sampleRate) {
+    setSampleRate(sampleRate);
+}
+
+/**
+ * @brief Set the rate of the audio fed to trackSilence() (render thread only)
+ */
+void IdleSignal::setSampleRate(int sampleRate) {
+    tailFrames_ = static_cast<size_t>(TAIL_TIME * sampleRate);
+    silentFrames_ = 0;
+}
+
+/**
+ * @brief Set who is told when the renderer parks and wakes
+ *
+ * Not real-time safe: must not be called while anything renders or posts
+ * events.
+ *
+ * @param function Called on every change of state, or nullptr
+ * @param context Passed through to function
+ */
+void IdleSignal::setStateFunction(StateFunction function, void* context) {
+    stateFunction_ = function;
+    stateContext_ = context;
+}
+
+/**
+ * @brief Wake the renderer if it is parked (any thread, after queueing an event)
+ *
+ * The fence orders the event written before it against the renderer's
+ * parked flag: either the renderer sees the event when it checks again
+ * after parking, or this sees it parked and wakes it. Of several threads
+ * notifying at once, only one wakes it.
+ */
+void IdleSignal::notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed) && parked_.exchange(false, std::memory_order_acq_rel)) {
+        wake();
+        if (stateFunction_) {
+            stateFunction_(stateContext_, false);
+        }
+    }
+}
+
+/**
+ * @brief Return from wait() whether or not the renderer is parked (any thread)
+ *
+ * For shutting the render thread down; set the condition its ready()
+ * checks first.
+ */
+void IdleSignal::wake() {
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+}
+
+void IdleSignal::unpark() {
+    parked_.store(false, std::memory_order_relaxed);
+}
+
+}
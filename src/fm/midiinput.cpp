@@ -0,0 +1,505 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/midiinput.hpp"
+#include "fm/telemetry.hpp"
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <CoreMIDI/CoreMIDI.h>
+#include <mach/mach_time.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <mmsystem.h>
+#elif defined(SORTASOUND_HAVE_ALSA)
+#include <alsa/asoundlib.h>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace toybasic {
+
+namespace {
+
+constexpr uint8_t STATUS_NOTE_OFF = 0x80;
+constexpr uint8_t STATUS_NOTE_ON = 0x90;
+constexpr uint8_t STATUS_CONTROL_CHANGE = 0xB0;
+constexpr uint8_t STATUS_PROGRAM_CHANGE = 0xC0;
+constexpr uint8_t STATUS_CHANNEL_PRESSURE = 0xD0;
+constexpr uint8_t STATUS_PITCH_BEND = 0xE0;
+constexpr uint8_t STATUS_SYSEX = 0xF0;
+constexpr uint8_t STATUS_SYSEX_END = 0xF7;
+constexpr uint8_t STATUS_REALTIME = 0xF8;
+
+constexpr int CONTROLLER_ALL_SOUND_OFF = 120;
+constexpr int CONTROLLER_ALL_NOTES_OFF = 123;
+constexpr double PITCH_BEND_RANGE_SEMITONES = 2.0;
+constexpr int PITCH_BEND_CENTER = 8192;
+
+/* data bytes that follow a channel or system common status byte */
+size_t dataLength(uint8_t status) {
+    if (status < STATUS_SYSEX) {
+        const uint8_t type = status & 0xF0;
+        return type == STATUS_PROGRAM_CHANGE || type == STATUS_CHANNEL_PRESSURE ? 1 : 2;
+    }
+    switch (status) {
+        case 0xF1:
+        case 0xF3:
+            return 1;
+        case 0xF2:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+}
+
+#if defined(__APPLE__)
+
+struct MidiInput::Backend {
+    MIDIClientRef client = 0;
+    MIDIPortRef port = 0;
+    
+    static std::string sourceName(MIDIEndpointRef source) {
+        CFStringRef name = nullptr;
+        char buffer[256] = "";
+        if (MIDIObjectGetStringProperty(source, kMIDIPropertyDisplayName, &name) == noErr && name) {
+            CFStringGetCString(name, buffer, sizeof(buffer), kCFStringEncodingUTF8);
+            CFRelease(name);
+        }
+        return buffer;
+    }
+    
+    /* CoreMIDI stamps packets with host time; 0 means now */
+    static uint64_t toSteadyNanoseconds(MIDITimeStamp timeStamp) {
+        const uint64_t now = RenderTelemetry::now();
+        if (timeStamp == 0) {
+            return now;
+        }
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        const double hostNow = static_cast<double>(mach_absolute_time());
+        const double age = (hostNow - static_cast<double>(timeStamp)) * timebase.numer / timebase.denom;
+        return static_cast<uint64_t>(static_cast<double>(now) - age);
+    }
+    
+    static void read(const MIDIPacketList* packets, void* context, void*) {
+        auto* input = static_cast<MidiInput*>(context);
+        const MIDIPacket* packet = &packets->packet[0];
+        for (UInt32 i = 0; i < packets->numPackets; i++) {
+            input->handleBytes(packet->data, packet->length, toSteadyNanoseconds(packet->timeStamp));
+            packet = MIDIPacketNext(packet);
+        }
+    }
+    
+    Backend(MidiInput& input, int index) {
+        if (index < 0 || index >= static_cast<int>(MIDIGetNumberOfSources())) {
+            throw std::out_of_range("MIDI input port out of range");
+        }
+        if (MIDIClientCreate(CFSTR("SortaSound"), nullptr, nullptr, &client) != noErr ||
+            MIDIInputPortCreate(client, CFSTR("MIDI In"), &Backend::read, &input, &port) != noErr ||
+            MIDIPortConnectSource(port, MIDIGetSource(index), nullptr) != noErr) {
+            if (client) MIDIClientDispose(client);
+            throw std::runtime_error("Cannot open CoreMIDI input");
+        }
+    }
+    
+    ~Backend() {
+        MIDIPortDispose(port);
+        MIDIClientDispose(client);
+    }
+    
+    static std::vector<std::string> ports() {
+        std::vector<std::string> names;
+        for (ItemCount i = 0; i < MIDIGetNumberOfSources(); i++) {
+            names.push_back(sourceName(MIDIGetSource(i)));
+        }
+        return names;
+    }
+};
+
+#elif defined(_WIN32)
+
+struct MidiInput::Backend {
+    HMIDIIN handle = nullptr;
+    uint64_t startNanoseconds = 0;
+    
+    /* WinMM stamps messages in milliseconds since midiInStart() */
+    static void CALLBACK callback(HMIDIIN, UINT message, DWORD_PTR instance, DWORD_PTR param1, DWORD_PTR param2) {
+        if (message != MIM_DATA) {
+            return;
+        }
+        auto* input = reinterpret_cast<MidiInput*>(instance);
+        const uint8_t bytes[3] = {static_cast<uint8_t>(param1 & 0xFF), static_cast<uint8_t>((param1 >> 8) & 0xFF),
+                                  static_cast<uint8_t>((param1 >> 16) & 0xFF)};
+        input->handleBytes(bytes, 1 + dataLength(bytes[0]),
+                           input->backend_->startNanoseconds + static_cast<uint64_t>(param2) * 1000000);
+    }
+    
+    Backend(MidiInput& input, int index) {
+        if (index < 0 || index >= static_cast<int>(midiInGetNumDevs())) {
+            throw std::out_of_range("MIDI input port out of range");
+        }
+        if (midiInOpen(&handle, static_cast<UINT>(index), reinterpret_cast<DWORD_PTR>(&Backend::callback),
+                       reinterpret_cast<DWORD_PTR>(&input), CALLBACK_FUNCTION) != MMSYSERR_NOERROR) {
+            throw std::runtime_error("Cannot open WinMM MIDI input");
+        }
+    }
+    
+    /* started only once backend_ is set, since the callback reads it */
+    void start() {
+        startNanoseconds = RenderTelemetry::now();
+        midiInStart(handle);
+    }
+    
+    ~Backend() {
+        midiInStop(handle);
+        midiInReset(handle);
+        midiInClose(handle);
+    }
+    
+    static std::vector<std::string> ports() {
+        std::vector<std::string> names;
+        const UINT count = midiInGetNumDevs();
+        for (UINT i = 0; i < count; i++) {
+            MIDIINCAPSA caps;
+            names.push_back(midiInGetDevCapsA(i, &caps, sizeof(caps)) == MMSYSERR_NOERROR ? caps.szPname : "");
+        }
+        return names;
+    }
+};
+
+#elif defined(SORTASOUND_HAVE_ALSA)
+
+struct MidiInput::Backend {
+    struct Address {
+        int client;
+        int port;
+        std::string name;
+    };
+    
+    snd_seq_t* sequencer = nullptr;
+    int wakePipe[2] = {-1, -1};
+    std::thread thread;
+    
+    static std::vector<Address> sources(snd_seq_t* sequencer) {
+        std::vector<Address> addresses;
+        snd_seq_client_info_t* client;
+        snd_seq_port_info_t* port;
+        snd_seq_client_info_alloca(&client);
+        snd_seq_port_info_alloca(&port);
+        snd_seq_client_info_set_client(client, -1);
+        while (snd_seq_query_next_client(sequencer, client) >= 0) {
+            const int id = snd_seq_client_info_get_client(client);
+            if (id == SND_SEQ_CLIENT_SYSTEM || id == snd_seq_client_id(sequencer)) {
+                continue;
+            }
+            snd_seq_port_info_set_client(port, id);
+            snd_seq_port_info_set_port(port, -1);
+            while (snd_seq_query_next_port(sequencer, port) >= 0) {
+                const unsigned wanted = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+                if ((snd_seq_port_info_get_capability(port) & wanted) != wanted) {
+                    continue;
+                }
+                addresses.push_back({id, snd_seq_port_info_get_port(port),
+                                     std::string(snd_seq_client_info_get_name(client)) + ": " +
+                                     snd_seq_port_info_get_name(port)});
+            }
+        }
+        return addresses;
+    }
+    
+    /* sequencer events arrive decoded; turn them back into MIDI bytes */
+    static void deliver(MidiInput& input, const snd_seq_event_t& event, uint64_t nanoseconds) {
+        uint8_t bytes[3];
+        switch (event.type) {
+            case SND_SEQ_EVENT_NOTEON:
+            case SND_SEQ_EVENT_NOTEOFF:
+                bytes[0] = (event.type == SND_SEQ_EVENT_NOTEON ? STATUS_NOTE_ON : STATUS_NOTE_OFF) |
+                           (event.data.note.channel & 0x0F);
+                bytes[1] = event.data.note.note & 0x7F;
+                bytes[2] = event.data.note.velocity & 0x7F;
+                break;
+            case SND_SEQ_EVENT_CONTROLLER:
+                bytes[0] = STATUS_CONTROL_CHANGE | (event.data.control.channel & 0x0F);
+                bytes[1] = event.data.control.param & 0x7F;
+                bytes[2] = event.data.control.value & 0x7F;
+                break;
+            case SND_SEQ_EVENT_PITCHBEND: {
+                const int value = event.data.control.value + PITCH_BEND_CENTER;
+                bytes[0] = STATUS_PITCH_BEND | (event.data.control.channel & 0x0F);
+                bytes[1] = value & 0x7F;
+                bytes[2] = (value >> 7) & 0x7F;
+                break;
+            }
+            default:
+                return;
+        }
+        input.handleBytes(bytes, sizeof(bytes), nanoseconds);
+    }
+    
+    void run(MidiInput& input) {
+        const int count = snd_seq_poll_descriptors_count(sequencer, POLLIN);
+        std::vector<pollfd> descriptors(count + 1);
+        snd_seq_poll_descriptors(sequencer, descriptors.data(), count, POLLIN);
+        descriptors[count] = {wakePipe[0], POLLIN, 0};
+        
+        for (;;) {
+            if (poll(descriptors.data(), descriptors.size(), -1) < 0) {
+                continue;
+            }
+            if (descriptors[count].revents & POLLIN) {
+                return;
+            }
+            const uint64_t now = RenderTelemetry::now();
+            snd_seq_event_t* event;
+            int result;
+            while ((result = snd_seq_event_input(sequencer, &event)) >= 0 || result == -ENOSPC) {
+                if (result >= 0) {
+                    deliver(input, *event, now);
+                }
+            }
+        }
+    }
+    
+    Backend(MidiInput& input, int index) {
+        if (snd_seq_open(&sequencer, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+            throw std::runtime_error("Cannot open the ALSA sequencer");
+        }
+        snd_seq_set_client_name(sequencer, "SortaSound");
+        const std::vector<Address> addresses = sources(sequencer);
+        if (index < 0 || index >= static_cast<int>(addresses.size())) {
+            snd_seq_close(sequencer);
+            throw std::out_of_range("MIDI input port out of range");
+        }
+        const int port = snd_seq_create_simple_port(sequencer, "MIDI In",
+                                                    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                                    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+        if (port < 0 || snd_seq_connect_from(sequencer, port, addresses[index].client, addresses[index].port) < 0 ||
+            pipe(wakePipe) != 0) {
+            snd_seq_close(sequencer);
+            throw std::runtime_error("Cannot connect to " + addresses[index].name);
+        }
+        thread = std::thread(&Backend::run, this, std::ref(input));
+    }
+    
+    ~Backend() {
+        const char stop = 0;
+        ssize_t written = ::write(wakePipe[1], &stop, 1);
+        (void)written;
+        thread.join();
+        ::close(wakePipe[0]);
+        ::close(wakePipe[1]);
+        snd_seq_close(sequencer);
+    }
+    
+    static std::vector<std::string> ports() {
+        std::vector<std::string> names;
+        snd_seq_t* sequencer;
+        if (snd_seq_open(&sequencer, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+            return names;
+        }
+        for (const Address& address : sources(sequencer)) {
+            names.push_back(address.name);
+        }
+        snd_seq_close(sequencer);
+        return names;
+    }
+};
+
+#else
+
+struct MidiInput::Backend {
+    Backend(MidiInput&, int) {
+        throw std::runtime_error("MIDI input is not supported in this build");
+    }
+    
+    static std::vector<std::string> ports() { return {}; }
+};
+
+#endif
+
+/**
+ * @brief Create an input that is not connected to any port yet
+ * 
+ * @param synth Synthesizer to play; its input event queue must have no other producer
+ * @param channel Synthesizer channel that every MIDI channel plays
+ */
+MidiInput::MidiInput(FMSynthesizer& synth, int channel)
+    : synth_(synth), channel_(channel) {}
+
+MidiInput::~MidiInput() {
+    close();
+}
+
+/**
+ * @brief Names of the MIDI sources that open() can connect to, by index
+ */
+std::vector<std::string> MidiInput::listPorts() {
+    return Backend::ports();
+}
+
+/**
+ * @brief Connect to a MIDI source, closing any port already open
+ * 
+ * @param port Index into listPorts()
+ * @throws std::out_of_range if there is no such port
+ * @throws std::runtime_error if the port cannot be opened, or the build has
+ *         no MIDI backend
+ */
+void MidiInput::open(int port) {
+    close();
+    const std::vector<std::string> ports = listPorts();
+    runningStatus_ = 0;
+    pendingCount_ = 0;
+    inSysEx_ = false;
+    clearHeld();
+    backend_ = std::make_unique<Backend>(*this, port);
+#if defined(_WIN32)
+    backend_->start();
+#endif
+    portName_ = port >= 0 && port < static_cast<int>(ports.size()) ? ports[port] : std::string();
+}
+
+/**
+ * @brief Disconnect; returns once the input thread has stopped delivering
+ */
+void MidiInput::close() {
+    backend_.reset();
+    portName_.clear();
+    clearHeld();
+}
+
+/**
+ * @brief The notes held down on the open port, for display (any thread)
+ * 
+ * Follows note on and note off as they arrive rather than as they sound,
+ * and is cleared by all notes off and by closing the port.
+ */
+std::bitset<Constants::MIDI_NOTE_COUNT> MidiInput::getHeldNotes() const {
+    std::bitset<Constants::MIDI_NOTE_COUNT> notes;
+    for (int note = 0; note < Constants::MIDI_NOTE_COUNT; note++) {
+        notes[note] = (heldNotes_[note / HELD_WORD_BITS].load(std::memory_order_relaxed) >> (note % HELD_WORD_BITS)) & 1;
+    }
+    return notes;
+}
+
+/**
+ * @brief Decode a raw MIDI byte stream (input thread only)
+ * 
+ * Handles running status, real-time bytes interleaved anywhere and SysEx,
+ * which is skipped. A message split across calls is completed by the next
+ * call.
+ * 
+ * @param bytes MIDI bytes as received
+ * @param length Number of bytes
+ * @param nanoseconds When they arrived, on the RenderTelemetry::now() clock
+ */
+void MidiInput::handleBytes(const uint8_t* bytes, size_t length, uint64_t nanoseconds) {
+    for (size_t i = 0; i < length; i++) {
+        const uint8_t byte = bytes[i];
+        if (byte >= STATUS_REALTIME) {
+            continue;
+        }
+        if (byte & 0x80) {
+            pendingCount_ = 0;
+            inSysEx_ = byte == STATUS_SYSEX;
+            runningStatus_ = dataLength(byte) > 0 ? byte : 0;
+            continue;
+        }
+        if (inSysEx_ || runningStatus_ == 0) {
+            continue;
+        }
+        pending_[pendingCount_++] = byte;
+        if (pendingCount_ == dataLength(runningStatus_)) {
+            handleMessage(runningStatus_, pending_[0], pendingCount_ > 1 ? pending_[1] : 0, nanoseconds);
+            pendingCount_ = 0;
+            /* only channel messages may use running status */
+            if (runningStatus_ >= STATUS_SYSEX) {
+                runningStatus_ = 0;
+            }
+        }
+    }
+}
+
+void MidiInput::handleMessage(uint8_t status, uint8_t data1, uint8_t data2, uint64_t nanoseconds) {
+    switch (status & 0xF0) {
+        case STATUS_NOTE_ON:
+            if (data2 > 0) {
+                post(SynthEvent::Type::NOTE_ON, data1, data2 / 127.0, nanoseconds);
+                setHeld(data1, true);
+                break;
+            }
+            [[fallthrough]];
+        case STATUS_NOTE_OFF:
+            post(SynthEvent::Type::NOTE_OFF, data1, 0.0, nanoseconds);
+            setHeld(data1, false);
+            break;
+        case STATUS_CONTROL_CHANGE:
+            if (data1 == static_cast<int>(MIDIController::MODULATION_WHEEL)) {
+                post(SynthEvent::Type::MODULATION_WHEEL, 0, data2 / 127.0, nanoseconds);
+            } else if (data1 == static_cast<int>(MIDIController::VOLUME)) {
+                post(SynthEvent::Type::MASTER_VOLUME, 0, data2 / 127.0, nanoseconds);
+            } else if (data1 == CONTROLLER_ALL_SOUND_OFF || data1 == CONTROLLER_ALL_NOTES_OFF) {
+                post(SynthEvent::Type::ALL_NOTES_OFF, 0, 0.0, nanoseconds);
+                clearHeld();
+            }
+            break;
+        case STATUS_PITCH_BEND: {
+            const int value = (data2 << 7) | data1;
+            const double semitones = PITCH_BEND_RANGE_SEMITONES * (value - PITCH_BEND_CENTER) / PITCH_BEND_CENTER;
+            post(SynthEvent::Type::PITCH_BEND, 0, std::pow(2.0, semitones / 12.0), nanoseconds);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void MidiInput::post(SynthEvent::Type type, int index, double value, uint64_t nanoseconds) {
+    SynthEvent event{type, channel_, index, {value}};
+    event.frame = synth_.getClock().scheduleFrame(nanoseconds);
+    if (synth_.postInputEvent(event)) {
+        eventCount_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        droppedCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MidiInput::setHeld(int note, bool held) {
+    const uint64_t bit = uint64_t(1) << (note % HELD_WORD_BITS);
+    std::atomic<uint64_t>& word = heldNotes_[note / HELD_WORD_BITS];
+    if (held) {
+        word.fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        word.fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+void MidiInput::clearHeld() {
+    for (std::atomic<uint64_t>& word : heldNotes_) {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+}
@@ -0,0 +1,312 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/output.hpp"
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <cstdio>
+
+namespace toybasic {
+
+/**
+ * @brief Constructor for QtAudioOutput
+ * 
+ * Starts the audio thread and opens the default output device on it, but
+ * does not start the stream; call start() once the render source is ready
+ * to be pulled from.
+ * 
+ * @param source Renders every block the device asks for
+ * @param sampleRate The stream sample rate in Hz
+ * @param telemetry Receives the sink's underruns, or nullptr
+ */
+QtAudioOutput::QtAudioOutput(AudioRenderSource& source, int sampleRate, RenderTelemetry* telemetry)
+    : source_(source), telemetry_(telemetry), sampleRate_(sampleRate),
+      bufferFrames_(Constants::DEFAULT_BUFFER_FRAMES), running_(false), suspended_(false),
+      format_(SampleFormat::INT16), dither_(true), dacEmulation_(false),
+      device_(nullptr), sink_(nullptr), idle_(source.getIdleSignal()), receiver_(new QObject) {
+    thread_.setObjectName("Audio Output");
+    receiver_->moveToThread(&thread_);
+    /* deleted on its own thread once the event loop has finished */
+    QObject::connect(&thread_, &QThread::finished, receiver_, &QObject::deleteLater);
+    thread_.start(QThread::TimeCriticalPriority);
+    
+    if (idle_) {
+        idle_->setStateFunction(&QtAudioOutput::idleStateChanged, this);
+    }
+    runOnAudioThread([this] { open(); });
+}
+
+QtAudioOutput::~QtAudioOutput() {
+    if (idle_) {
+        idle_->setStateFunction(nullptr, nullptr);
+    }
+    runOnAudioThread([this] {
+        stopStream();
+        close();
+    });
+    thread_.quit();
+    thread_.wait();
+}
+
+/**
+ * @brief Run a function on the audio thread and wait for it to return
+ * 
+ * Everything that touches the sink or the device goes through here, so
+ * they are only ever used from the thread whose event loop drives them.
+ */
+template <typename Function>
+void QtAudioOutput::runOnAudioThread(Function function) {
+    if (QThread::currentThread() == &thread_) {
+        function();
+        return;
+    }
+    QMetaObject::invokeMethod(receiver_, function, Qt::BlockingQueuedConnection);
+}
+
+/**
+ * @brief Note that the source parked or woke (render or event thread)
+ * 
+ * The sink can only be suspended and resumed from its own thread, so the
+ * change is queued there; followIdleState() reads the state afresh, so
+ * changes overtaking each other on the way are harmless.
+ */
+void QtAudioOutput::idleStateChanged(void* context, bool parked) {
+    Q_UNUSED(parked);
+    auto* output = static_cast<QtAudioOutput*>(context);
+    QMetaObject::invokeMethod(output->receiver_, [output] { output->followIdleState(); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Suspend the stream while the source is parked, resume it once it wakes (audio thread)
+ * 
+ * On resume one block is prerolled before the sink restarts, so the event
+ * that woke the source is already rendered when the first request comes.
+ */
+void QtAudioOutput::followIdleState() {
+    if (!running_ || !idle_) {
+        return;
+    }
+    const bool parked = idle_->isParked();
+    const bool suspended = suspended_.load(std::memory_order_relaxed);
+    if (parked && !suspended) {
+        sink_->suspend();
+        suspended_.store(true, std::memory_order_relaxed);
+    } else if (!parked && suspended) {
+        device_->preroll();
+        sink_->resume();
+        suspended_.store(false, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Open the default audio output in pull mode (audio thread)
+ * 
+ * Negotiates the sample format: the first of Float32, Int32 and Int16
+ * stereo at the stream rate that the device supports natively. Creates a
+ * QAudioSink whose buffer holds bufferFrames_ stereo frames and a
+ * FMAudioDevice that renders directly into it in that format. The sink
+ * going idle with an underrun error while the stream runs means the device
+ * was starved.
+ */
+void QtAudioOutput::open() {
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    if (device.isNull()) {
+        printf("No audio output device found\n");
+        return;
+    }
+
+    static constexpr std::array<std::pair<SampleFormat, QAudioFormat::SampleFormat>, 3> CANDIDATES = {{
+        {SampleFormat::FLOAT32, QAudioFormat::Float},
+        {SampleFormat::INT32, QAudioFormat::Int32},
+        {SampleFormat::INT16, QAudioFormat::Int16},
+    }};
+
+    QAudioFormat format;
+    format.setSampleRate(sampleRate_);
+    format.setChannelCount(2);
+    bool supported = false;
+    for (const auto& [sampleFormat, qtFormat] : CANDIDATES) {
+        format.setSampleFormat(qtFormat);
+        if (device.isFormatSupported(format)) {
+            format_ = sampleFormat;
+            supported = true;
+            break;
+        }
+    }
+    if (!supported) {
+        /* the system converts, but at least the samples match the format */
+        printf("No native stereo format at %d Hz, requesting 16-bit integer\n", sampleRate_);
+        format.setSampleFormat(QAudioFormat::Int16);
+        format_ = SampleFormat::INT16;
+    }
+
+    sink_ = new QAudioSink(device, format);
+    sink_->setBufferSize(bufferFrames_ * 2 * static_cast<int>(SampleConverter::bytesPerSample(format_)));
+    if (telemetry_) {
+        QObject::connect(sink_, &QAudioSink::stateChanged, sink_, [this](QAudio::State state) {
+            if (running_ && state == QAudio::IdleState && sink_->error() == QAudio::UnderrunError) {
+                telemetry_->recordUnderrun();
+            }
+        });
+    }
+    
+    device_ = new FMAudioDevice(source_, format_);
+    device_->getConverter().setDither(dither_);
+    device_->getConverter().setDacEmulation(dacEmulation_);
+    device_->open(QIODevice::ReadOnly);
+
+    printf("Audio setup completed successfully (%s)\n", sampleFormatName(format_));
+}
+
+/**
+ * @brief Stop and release the audio output (audio thread)
+ */
+void QtAudioOutput::close() {
+    if (sink_) {
+        sink_->stop();
+        delete sink_;
+        sink_ = nullptr;
+    }
+    
+    if (device_) {
+        device_->close();
+        delete device_;
+        device_ = nullptr;
+    }
+}
+
+/**
+ * @brief Start pulling audio from the render source
+ * 
+ * @return True if the stream is running
+ */
+bool QtAudioOutput::start() {
+    bool started = false;
+    runOnAudioThread([this, &started] { started = startStream(); });
+    return started;
+}
+
+/**
+ * @brief Stop the stream; the render source is not called again until start()
+ */
+void QtAudioOutput::stop() {
+    runOnAudioThread([this] { stopStream(); });
+}
+
+bool QtAudioOutput::startStream() {
+    if (running_) {
+        return true;
+    }
+    if (!sink_ || !device_) {
+        return false;
+    }
+    
+    sink_->start(device_);
+    if (sink_->state() == QAudio::StoppedState && sink_->error() != QAudio::NoError) {
+        printf("Failed to start audio output\n");
+        return false;
+    }
+    running_ = true;
+    /* a source that parked while the stream was stopped says so only once */
+    followIdleState();
+    return true;
+}
+
+void QtAudioOutput::stopStream() {
+    if (!running_) {
+        return;
+    }
+    sink_->stop();
+    running_ = false;
+    suspended_.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set the output buffer size
+ * 
+ * The buffer size is the latency target of the audio output: the sink asks
+ * for audio whenever its buffer drains, so smaller buffers react faster to
+ * note events at the cost of more frequent callbacks. Reopens the output if
+ * it is currently running.
+ * 
+ * @param frames Buffer size in stereo frames (clamped to MIN_BUFFER_FRAMES..MAX_BUFFER_FRAMES)
+ */
+void QtAudioOutput::setBufferFrames(int frames) {
+    frames = std::clamp(frames, Constants::MIN_BUFFER_FRAMES, Constants::MAX_BUFFER_FRAMES);
+    runOnAudioThread([this, frames] {
+        if (frames == bufferFrames_) {
+            return;
+        }
+        
+        bool running = running_;
+        stopStream();
+        close();
+        
+        bufferFrames_ = frames;
+        
+        open();
+        if (running) {
+            startStream();
+        }
+    });
+}
+
+/**
+ * @brief Dither 16-bit output
+ * 
+ * Takes effect on the next block; has no effect on float or 32-bit output,
+ * or while the DAC stage is on.
+ * 
+ * @param enabled Whether to add TPDF dither before rounding
+ */
+void QtAudioOutput::setDither(bool enabled) {
+    runOnAudioThread([this, enabled] {
+        dither_ = enabled;
+        if (device_) {
+            device_->getConverter().setDither(enabled);
+        }
+    });
+}
+
+/**
+ * @brief Route the output through the emulated 14-bit DAC
+ * 
+ * Takes effect on the next block.
+ * 
+ * @param enabled Whether to quantize to the DAC range before conversion
+ */
+void QtAudioOutput::setDacEmulation(bool enabled) {
+    runOnAudioThread([this, enabled] {
+        dacEmulation_ = enabled;
+        if (device_) {
+            device_->getConverter().setDacEmulation(enabled);
+        }
+    });
+}
+
+/**
+ * @brief Get the output latency implied by the buffer size
+ * 
+ * @return Buffer duration in milliseconds
+ */
+double QtAudioOutput::getOutputLatencyMs() const {
+    return 1000.0 * bufferFrames_ / sampleRate_;
+}
+
+}
@@ -0,0 +1,191 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/pool.hpp"
+#include <algorithm>
+
+namespace toybasic {
+
+/**
+ * @brief Spawn the worker threads
+ *
+ * @param workerCount Threads to start in addition to the caller of run();
+ *                    zero runs every batch on the calling thread
+ */
+RenderWorkerPool::RenderWorkerPool(size_t workerCount)
+    : slots_(std::make_unique<WorkerSlot[]>(workerCount)), workerStatus_(workerCount) {
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        workers_.emplace_back(&RenderWorkerPool::workerLoop, this, i);
+    }
+}
+
+RenderWorkerPool::~RenderWorkerPool() {
+    stopping_.store(true, std::memory_order_relaxed);
+    for (size_t i = 0; i < workers_.size(); i++) {
+        wakeWorker(i);
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Number of helper threads to use on this machine
+ *
+ * One less than the hardware threads, since the audio thread calling run()
+ * renders too.
+ */
+size_t RenderWorkerPool::defaultWorkerCount() {
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+/**
+ * @brief Run task 0 to taskCount - 1 across the pool and wait for all of them
+ *
+ * Wakes at most taskCount - 1 workers, the caller taking a task too, and
+ * returns once every task has finished. A worker that wakes too late to
+ * claim a task never touches the context, so no worker can still be inside
+ * this batch afterwards.
+ *
+ * @param function Called once per task index, from any pool thread
+ * @param context Passed through to function
+ * @param taskCount Number of tasks in the batch, at most MAX_TASKS
+ */
+void RenderWorkerPool::run(TaskFunction function, void* context, size_t taskCount) {
+    if (taskCount == 0) {
+        return;
+    }
+    if (workers_.empty() || taskCount == 1) {
+        for (size_t task = 0; task < taskCount; task++) {
+            function(context, task);
+        }
+        return;
+    }
+
+    function_ = function;
+    context_ = context;
+    pendingTasks_.store(taskCount, std::memory_order_relaxed);
+    batchNumber_++;
+    batch_.store(static_cast<uint64_t>(batchNumber_) << 32 | static_cast<uint64_t>(taskCount) << 16,
+                 std::memory_order_release);
+
+    const size_t helpers = std::min(taskCount - 1, workers_.size());
+    for (size_t i = 0; i < helpers; i++) {
+        wakeWorker(i);
+    }
+
+    runTasks();
+
+    size_t pending = pendingTasks_.load(std::memory_order_acquire);
+    while (pending != 0) {
+        pendingTasks_.wait(pending, std::memory_order_acquire);
+        pending = pendingTasks_.load(std::memory_order_acquire);
+    }
+}
+
+/**
+ * @brief Have every worker ask the OS for real-time treatment
+ *
+ * Each worker is woken to promote itself, since some systems only let a
+ * thread change its own scheduling. Worker i takes the core after the i-th
+ * of the configuration, the first being left to the thread that calls
+ * run(). Like run(), must not be called while another batch is running.
+ *
+ * @param config What to ask for
+ * @param periodNanoseconds How often a batch is run
+ * @return Whatever the OS refused any of the workers
+ */
+RealtimeStatus RenderWorkerPool::promoteWorkers(const RealtimeConfig& config, uint64_t periodNanoseconds) {
+    RealtimeStatus status;
+    if (workers_.empty() || !config.enabled) {
+        return status;
+    }
+
+    promotion_ = &config;
+    promotionPeriod_ = periodNanoseconds;
+    pendingPromotions_.store(workers_.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < workers_.size(); i++) {
+        slots_[i].promote.store(true, std::memory_order_release);
+        wakeWorker(i);
+    }
+
+    size_t pending = pendingPromotions_.load(std::memory_order_acquire);
+    while (pending != 0) {
+        pendingPromotions_.wait(pending, std::memory_order_acquire);
+        pending = pendingPromotions_.load(std::memory_order_acquire);
+    }
+    promotion_ = nullptr;
+
+    for (const RealtimeStatus& worker : workerStatus_) {
+        status.merge(worker);
+    }
+    return status;
+}
+
+void RenderWorkerPool::wakeWorker(size_t index) {
+    slots_[index].wake.fetch_add(1, std::memory_order_release);
+    slots_[index].wake.notify_one();
+}
+
+/*
+ * Claim tasks of whichever batch is running until none are left. The
+ * compare-exchange only succeeds while the batch it read is still the
+ * running one, and that batch cannot finish before the claimed task does,
+ * so function_ and context_ are stable for as long as the task runs.
+ */
+void RenderWorkerPool::runTasks() {
+    uint64_t batch = batch_.load(std::memory_order_acquire);
+    for (;;) {
+        const size_t task = batch & 0xFFFF;
+        const size_t taskCount = (batch >> 16) & 0xFFFF;
+        if (task >= taskCount) {
+            return;
+        }
+        if (!batch_.compare_exchange_weak(batch, batch + 1, std::memory_order_acquire)) {
+            continue;
+        }
+        function_(context_, task);
+        if (pendingTasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pendingTasks_.notify_one();
+        }
+        batch = batch_.load(std::memory_order_acquire);
+    }
+}
+
+void RenderWorkerPool::workerLoop(size_t index) {
+    WorkerSlot& slot = slots_[index];
+    uint32_t seen = 0;
+    for (;;) {
+        slot.wake.wait(seen, std::memory_order_acquire);
+        seen = slot.wake.load(std::memory_order_acquire);
+        if (stopping_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (slot.promote.exchange(false, std::memory_order_acq_rel)) {
+            workerStatus_[index] = promoteCurrentThread(*promotion_, index + 1, promotionPeriod_);
+            if (pendingPromotions_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                pendingPromotions_.notify_one();
+            }
+        }
+        runTasks();
+    }
+}
+
+}
@@ -17,7 +17,9 @@
  */
 
 #include "fm/presets.hpp"
+#include "fm/sysex.hpp"
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 namespace toybasic {
@@ -31,6 +33,15 @@ namespace toybasic {
  */
 PresetManager::PresetManager() {
     initializePresets();
+    useOwnedPresets();
+}
+
+/**
+ * @brief Store a name, truncated to fit, with the rest of the field zeroed
+ */
+void FMPresetConfig::setName(std::string_view text) {
+    name.fill('\0');
+    std::memcpy(name.data(), text.data(), std::min(text.size(), NAME_SIZE - 1));
 }
 
 /**
@@ -44,30 +55,39 @@ PresetManager::PresetManager() {
  * @throws std::out_of_range if index is invalid
  */
 const FMPresetConfig& PresetManager::getPreset(int index) const {
-    if (index < 0 || index >= static_cast<int>(presets_.size())) {
+    if (index < 0 || index >= static_cast<int>(recordCount_)) {
         throw std::out_of_range("Preset index out of range");
     }
-    return presets_[index];
+    return records_[index];
 }
 
 /**
  * @brief Get a preset configuration by name
  * 
- * Searches for a preset configuration by its name and returns a reference to it.
- * The search is case-sensitive.
+ * Looks the name up in the hashed name index and returns a reference to the
+ * preset. The match is case-sensitive; if several presets share a name the
+ * first one is returned.
  * 
  * @param name The name of the preset to retrieve
  * @return Reference to the preset configuration
  * @throws std::invalid_argument if preset name is not found
  */
 const FMPresetConfig& PresetManager::getPreset(const std::string& name) const {
-    auto it = std::find_if(presets_.begin(), presets_.end(),
-        [&name](const FMPresetConfig& preset) { return preset.name == name; });
-    
-    if (it == presets_.end()) {
+    const int index = findPreset(name);
+    if (index < 0) {
         throw std::invalid_argument("Preset not found: " + name);
     }
-    return *it;
+    return records_[index];
+}
+
+/**
+ * @brief Find the index of a preset by name
+ * 
+ * @param name The name of the preset to find
+ * @return The preset's index, or -1 if no preset has that name
+ */
+int PresetManager::findPreset(std::string_view name) const {
+    return PresetBank::findName(records_, nameSlots_, nameSlotCount_, name);
 }
 
 /**
@@ -78,7 +98,7 @@ const FMPresetConfig& PresetManager::getPreset(const std::string& name) const {
  * @return The number of presets available
  */
 int PresetManager::getPresetCount() const {
-    return static_cast<int>(presets_.size());
+    return static_cast<int>(recordCount_);
 }
 
 /**
@@ -90,12 +110,84 @@ int PresetManager::getPresetCount() const {
  */
 std::vector<std::string> PresetManager::getPresetNames() const {
     std::vector<std::string> names;
-    for (const auto& preset : presets_) {
-        names.push_back(preset.name);
+    names.reserve(recordCount_);
+    for (size_t i = 0; i < recordCount_; i++) {
+        names.emplace_back(records_[i].getName());
     }
     return names;
 }
 
+/**
+ * @brief Get the indices of every preset tagged with a category
+ * 
+ * @param category The category to filter by
+ * @return Indices of the matching presets, in preset order
+ */
+std::vector<int> PresetManager::getPresetsByCategory(PresetCategory category) const {
+    std::vector<int> indices;
+    for (size_t i = 0; i < recordCount_; i++) {
+        if (records_[i].hasCategory(category)) {
+            indices.push_back(static_cast<int>(i));
+        }
+    }
+    return indices;
+}
+
+/**
+ * @brief Replace the presets with a bank file
+ * 
+ * The bank is memory-mapped and its records used in place. References
+ * returned by getPreset() before the call become invalid.
+ * 
+ * @param path Bank file written by saveBank()
+ * @throws std::runtime_error if the bank cannot be opened or holds no presets
+ */
+void PresetManager::loadBank(const std::string& path) {
+    PresetBank bank(path);
+    if (bank.getRecordCount() == 0) {
+        throw std::runtime_error(path + " holds no presets");
+    }
+    bank_ = std::move(bank);
+    presets_.clear();
+    presets_.shrink_to_fit();
+    nameIndex_.clear();
+    records_ = bank_.getRecords();
+    recordCount_ = bank_.getRecordCount();
+    nameSlots_ = bank_.getIndex();
+    nameSlotCount_ = bank_.getIndexSlots();
+}
+
+/**
+ * @brief Write the current presets to a bank file
+ * 
+ * @param path File to create or replace
+ * @throws std::runtime_error if the file cannot be written
+ */
+void PresetManager::saveBank(const std::string& path) const {
+    PresetBank::write(path, records_, recordCount_);
+}
+
+/**
+ * @brief Append the voices of a DX7 32-voice SysEx bank to the presets
+ * 
+ * If a bank is mapped, its presets are copied out first. References
+ * returned by getPreset() before the call become invalid.
+ * 
+ * @param path SysEx file to import
+ * @return The number of presets added
+ * @throws std::runtime_error if the file is not a DX7 voice bank
+ */
+int PresetManager::importSysEx(const std::string& path) {
+    std::vector<FMPresetConfig> imported = importDx7SysEx(path);
+    if (bank_.isOpen()) {
+        presets_.assign(records_, records_ + recordCount_);
+        bank_.close();
+    }
+    presets_.insert(presets_.end(), imported.begin(), imported.end());
+    useOwnedPresets();
+    return static_cast<int>(imported.size());
+}
+
 /**
  * @brief Apply a preset to a synthesizer channel by index
  * 
@@ -169,6 +261,7 @@ void PresetManager::applyPreset(FMSynthesizer& synth, int channel, const FMPrese
     synth.setReverb(preset.reverb);
     synth.setChorus(preset.chorus);
     synth.setDistortion(preset.distortion);
+    synth.setFeedback(channel, preset.feedback);
 }
 
 void PresetManager::initializePresets() {
@@ -184,6 +277,14 @@ void PresetManager::initializePresets() {
     presets_.push_back(createSineFlute());
 }
 
+void PresetManager::useOwnedPresets() {
+    nameIndex_ = PresetBank::buildIndex(presets_.data(), presets_.size());
+    records_ = presets_.data();
+    recordCount_ = presets_.size();
+    nameSlots_ = nameIndex_.data();
+    nameSlotCount_ = nameIndex_.size();
+}
+
 /**
  * @brief Create an operator configuration with specified parameters
  * 
@@ -215,8 +316,9 @@ FMPresetConfig::OperatorConfig PresetManager::createOperator(double freq, double
  * @return Configured piano preset
  */
 FMPresetConfig PresetManager::createSinePiano() {
-    FMPresetConfig preset;
-    preset.name = "PIANO";
+    FMPresetConfig preset{};
+    preset.setName("PIANO");
+    preset.categories = presetCategoryBit(PresetCategory::KEYBOARD);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_2_PARALLEL_5AND6TO4TO3TO2TO1);
     preset.masterVolume = 0.8;
     preset.reverb = 0.3;
@@ -242,8 +344,9 @@ FMPresetConfig PresetManager::createSinePiano() {
  * @return Configured bass preset
  */
 FMPresetConfig PresetManager::createSineBass() {
-    FMPresetConfig preset;
-    preset.name = "BASS";
+    FMPresetConfig preset{};
+    preset.setName("BASS");
+    preset.categories = presetCategoryBit(PresetCategory::BASS);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_1_SERIAL_6TO5TO4TO3TO2TO1);
     preset.masterVolume = 0.9;
     preset.reverb = 0.2;
@@ -269,8 +372,9 @@ FMPresetConfig PresetManager::createSineBass() {
  * @return Configured lead preset
  */
 FMPresetConfig PresetManager::createSineLead() {
-    FMPresetConfig preset;
-    preset.name = "LEAD";
+    FMPresetConfig preset{};
+    preset.setName("LEAD");
+    preset.categories = presetCategoryBit(PresetCategory::SYNTH);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_7_SERIAL_6TO5TO4_AND_6TO3_AND_6TO2TO1);
     preset.masterVolume = 0.9;
     preset.reverb = 0.2;
@@ -296,8 +400,9 @@ FMPresetConfig PresetManager::createSineLead() {
  * @return Configured pad preset
  */
 FMPresetConfig PresetManager::createSinePad() {
-    FMPresetConfig preset;
-    preset.name = "PAD";
+    FMPresetConfig preset{};
+    preset.setName("PAD");
+    preset.categories = presetCategoryBit(PresetCategory::SYNTH);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_32_ALL_6_PARALLEL_CARRIERS);
     preset.masterVolume = 0.7;
     preset.reverb = 0.6;
@@ -323,8 +428,9 @@ FMPresetConfig PresetManager::createSinePad() {
  * @return Configured bell preset
  */
 FMPresetConfig PresetManager::createSineBell() {
-    FMPresetConfig preset;
-    preset.name = "BELL";
+    FMPresetConfig preset{};
+    preset.setName("BELL");
+    preset.categories = presetCategoryBit(PresetCategory::PERCUSSION);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_8_SERIAL_6TO5_AND_6TO4_AND_6TO3_AND_6TO2TO1);
     preset.masterVolume = 0.8;
     preset.reverb = 0.5;
@@ -350,8 +456,9 @@ FMPresetConfig PresetManager::createSineBell() {
  * @return Configured pluck preset
  */
 FMPresetConfig PresetManager::createSinePluck() {
-    FMPresetConfig preset;
-    preset.name = "PLUCK";
+    FMPresetConfig preset{};
+    preset.setName("PLUCK");
+    preset.categories = presetCategoryBit(PresetCategory::STRINGS);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_3_SERIAL_6TO5TO4TO3TO2_AND_6TO1);
     preset.masterVolume = 0.8;
     preset.reverb = 0.2;
@@ -377,8 +484,9 @@ FMPresetConfig PresetManager::createSinePluck() {
  * @return Configured brass preset
  */
 FMPresetConfig PresetManager::createSineBrass() {
-    FMPresetConfig preset;
-    preset.name = "BRASS";
+    FMPresetConfig preset{};
+    preset.setName("BRASS");
+    preset.categories = presetCategoryBit(PresetCategory::BRASS);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_4_SERIAL_6TO5TO4TO3_AND_6TO2TO1);
     preset.masterVolume = 0.8;
     preset.reverb = 0.4;
@@ -404,8 +512,9 @@ FMPresetConfig PresetManager::createSineBrass() {
  * @return Configured flute preset
  */
 FMPresetConfig PresetManager::createSineFlute() {
-    FMPresetConfig preset;
-    preset.name = "FLUTE";
+    FMPresetConfig preset{};
+    preset.setName("FLUTE");
+    preset.categories = presetCategoryBit(PresetCategory::WOODWIND);
     preset.algorithm = static_cast<int>(FMAlgorithm::ALG_5_SERIAL_6TO5TO4_AND_6TO3TO2TO1);
     preset.masterVolume = 0.7;
     preset.reverb = 0.4;
@@ -0,0 +1,270 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "fm/realtime.hpp"
+#include <algorithm>
+#include <string>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_error.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace toybasic {
+
+namespace {
+
+/* stack every promoted thread faults in and locks up front */
+constexpr size_t STACK_PREFAULT_BYTES = 128 * 1024;
+constexpr size_t PREFAULT_STRIDE = 4096;
+
+#if defined(__APPLE__)
+
+void raisePriority(RealtimeStatus& status, const RealtimeConfig&, uint64_t periodNanoseconds) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    const double ticksPerNanosecond = static_cast<double>(timebase.denom) / timebase.numer;
+    const uint32_t period = static_cast<uint32_t>(periodNanoseconds * ticksPerNanosecond);
+    
+    thread_time_constraint_policy_data_t policy;
+    policy.period = period;
+    policy.computation = period / 2;
+    policy.constraint = period;
+    policy.preemptible = TRUE;
+    const kern_return_t result = thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                                                   reinterpret_cast<thread_policy_t>(&policy),
+                                                   THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+    if (result != KERN_SUCCESS) {
+        status.deny(std::string("time-constraint scheduling: ") + mach_error_string(result));
+    }
+}
+
+void pinToCore(RealtimeStatus& status, int) {
+    status.deny("pinning to a core: not supported on macOS");
+}
+
+#elif defined(_WIN32)
+
+void raisePriority(RealtimeStatus& status, const RealtimeConfig&, uint64_t) {
+    DWORD taskIndex = 0;
+    HANDLE task = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    if (task) {
+        AvSetMmThreadPriority(task, AVRT_PRIORITY_CRITICAL);
+        return;
+    }
+    const DWORD error = GetLastError();
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        status.deny("MMCSS Pro Audio class: error " + std::to_string(error) + ", running at time-critical priority instead");
+    } else {
+        status.deny("MMCSS Pro Audio class and time-critical priority: error " + std::to_string(GetLastError()));
+    }
+}
+
+void pinToCore(RealtimeStatus& status, int core) {
+    if (core < 0 || core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        status.deny("pinning to core " + std::to_string(core) + ": no such core");
+        return;
+    }
+    if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) == 0) {
+        status.deny("pinning to core " + std::to_string(core) + ": error " + std::to_string(GetLastError()));
+    }
+}
+
+#else
+
+void raisePriority(RealtimeStatus& status, const RealtimeConfig& config, uint64_t) {
+    sched_param param{};
+    param.sched_priority = std::clamp(config.priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        std::string reason = "SCHED_FIFO priority " + std::to_string(param.sched_priority) + ": " + std::strerror(error);
+        if (error == EPERM) {
+            reason += " (needs CAP_SYS_NICE or an rtprio limit)";
+        }
+        status.deny(reason);
+    }
+}
+
+void pinToCore(RealtimeStatus& status, int core) {
+#if defined(__linux__)
+    if (core < 0 || core >= CPU_SETSIZE) {
+        status.deny("pinning to core " + std::to_string(core) + ": no such core");
+        return;
+    }
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+    if (error != 0) {
+        status.deny("pinning to core " + std::to_string(core) + ": " + std::strerror(error));
+    }
+#else
+    (void)core;
+    status.deny("pinning to a core: not supported on this system");
+#endif
+}
+
+#endif
+
+void prefaultStack(RealtimeStatus& status) {
+    volatile unsigned char stack[STACK_PREFAULT_BYTES];
+    for (size_t offset = 0; offset < sizeof(stack); offset += PREFAULT_STRIDE) {
+        stack[offset] = 0;
+    }
+    lockMemory(status, const_cast<unsigned char*>(stack), sizeof(stack));
+}
+
+}
+
+/**
+ * @brief Record a request the OS refused
+ * 
+ * @param reason What was asked for and why it was refused
+ */
+void RealtimeStatus::deny(const std::string& reason) {
+    if (std::find(denials.begin(), denials.end(), reason) == denials.end()) {
+        denials.push_back(reason);
+    }
+}
+
+/**
+ * @brief Add the outcome for another thread
+ * 
+ * The same refusal from several threads is listed once.
+ */
+void RealtimeStatus::merge(const RealtimeStatus& other) {
+    requested = requested || other.requested;
+    threads += other.threads;
+    for (const std::string& reason : other.denials) {
+        deny(reason);
+    }
+}
+
+/**
+ * @brief One line for logs and the UI
+ */
+std::string RealtimeStatus::describe() const {
+    if (!requested) {
+        return "Off";
+    }
+    if (denials.empty()) {
+        return threads > 0 ? "Granted" : "Waiting for the render thread";
+    }
+    std::string text = "Denied: ";
+    for (size_t index = 0; index < denials.size(); index++) {
+        text += (index > 0 ? "; " : "") + denials[index];
+    }
+    return text;
+}
+
+/**
+ * @brief Ask the OS to treat the calling thread as a real-time render thread
+ * 
+ * Raises it to SCHED_FIFO on Linux, the time-constraint policy on macOS or
+ * the MMCSS Pro Audio class on Windows, pins it to its core from the
+ * configuration, and faults in and locks the top of its stack. These are
+ * per-thread settings that some systems only let a thread make for itself,
+ * so every render thread calls this on its own. Nothing is attempted if
+ * the configuration is not enabled.
+ * 
+ * @param config What to ask for
+ * @param thread Which of the render threads this is; picks its core
+ * @param periodNanoseconds How often the thread renders a block
+ * @return Whatever the OS refused
+ */
+RealtimeStatus promoteCurrentThread(const RealtimeConfig& config, size_t thread, uint64_t periodNanoseconds) {
+    RealtimeStatus status;
+    if (!config.enabled) {
+        return status;
+    }
+    status.requested = true;
+    status.threads = 1;
+    raisePriority(status, config, periodNanoseconds);
+    if (!config.cores.empty()) {
+        pinToCore(status, config.cores[thread % config.cores.size()]);
+    }
+    if (config.lockMemory) {
+        prefaultStack(status);
+    }
+    return status;
+}
+
+/**
+ * @brief Fault in a buffer and keep it resident
+ * 
+ * Locking makes the OS fault every page in now, so the render thread never
+ * takes a page fault on it later, and keeps it from being paged out.
+ * 
+ * @param status Receives the refusal if the buffer could not be locked
+ * @param data Start of the buffer
+ * @param bytes Size of the buffer
+ */
+void lockMemory(RealtimeStatus& status, const void* data, size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+#if defined(_WIN32)
+    void* address = const_cast<void*>(data);
+    if (VirtualLock(address, bytes)) {
+        return;
+    }
+    if (GetLastError() == ERROR_WORKING_SET_QUOTA) {
+        /* locked pages count against the working set, so make room for them */
+        SIZE_T minimum = 0;
+        SIZE_T maximum = 0;
+        HANDLE process = GetCurrentProcess();
+        if (GetProcessWorkingSetSize(process, &minimum, &maximum)) {
+            SetProcessWorkingSetSize(process, minimum + bytes, maximum + bytes);
+        }
+        if (VirtualLock(address, bytes)) {
+            return;
+        }
+    }
+    status.deny("locking memory: error " + std::to_string(GetLastError()));
+#else
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(data) + bytes + page - 1) & ~(page - 1);
+    if (mlock(reinterpret_cast<const void*>(start), end - start) != 0) {
+        const int error = errno;
+        std::string reason = std::string("locking memory: ") + std::strerror(error);
+        if (error == ENOMEM || error == EPERM) {
+            reason += " (raise the locked memory limit, ulimit -l)";
+        }
+        status.deny(reason);
+    }
+#endif
+}
+
+}
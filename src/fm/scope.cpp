@@ -0,0 +1,86 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/scope.hpp"
+#include <algorithm>
+
+namespace toybasic {
+
+/**
+ * @brief Add a rendered block to the history (render thread only)
+ *
+ * @param left Left channel of the block
+ * @param right Right channel of the block
+ * @param frames Number of frames
+ * @param gain Gain the block is recorded at
+ * @return true when a snapshot is due and publish() should be called
+ */
+bool ScopeTap::write(const double* left, const double* right, size_t frames, double gain) {
+    if (!isEnabled()) {
+        return false;
+    }
+    for (size_t frame = 0; frame < frames; frame++) {
+        historyLeft_[historyPosition_] = static_cast<float>(left[frame] * gain);
+        historyRight_[historyPosition_] = static_cast<float>(right[frame] * gain);
+        historyPosition_ = (historyPosition_ + 1) % ScopeSnapshot::FRAMES;
+    }
+    pendingFrames_ += frames;
+    if (pendingFrames_ < PUBLISH_FRAMES) {
+        return false;
+    }
+    pendingFrames_ = 0;
+    return true;
+}
+
+/**
+ * @brief Publish the history and operator levels as the newest snapshot (render thread only)
+ *
+ * @param operatorLevels Level of each operator slot at the end of the history
+ * @param sampleRate Rate the history was rendered at
+ */
+void ScopeTap::publish(const std::array<float, Algorithms::OPERATORS>& operatorLevels, int sampleRate) {
+    ScopeSnapshot& snapshot = slots_[back_];
+    const size_t older = ScopeSnapshot::FRAMES - historyPosition_;
+    std::copy_n(historyLeft_.begin() + historyPosition_, older, snapshot.left.begin());
+    std::copy_n(historyLeft_.begin(), historyPosition_, snapshot.left.begin() + older);
+    std::copy_n(historyRight_.begin() + historyPosition_, older, snapshot.right.begin());
+    std::copy_n(historyRight_.begin(), historyPosition_, snapshot.right.begin() + older);
+    snapshot.operatorLevels = operatorLevels;
+    snapshot.sampleRate = sampleRate;
+    snapshot.sequence = ++published_;
+    
+    back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+/**
+ * @brief The newest snapshot (monitoring thread only)
+ *
+ * The snapshot stays valid and unchanged until the next call. Compare its
+ * sequence with the previous one to tell whether it is new.
+ *
+ * @return The snapshot, or nullptr if nothing has been published yet
+ */
+const ScopeSnapshot* ScopeTap::acquire() {
+    if (middle_.load(std::memory_order_relaxed) & FRESH) {
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    const ScopeSnapshot& snapshot = slots_[front_];
+    return snapshot.sequence != 0 ? &snapshot : nullptr;
+}
+
+}
@@ -0,0 +1,185 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/sysex.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace toybasic {
+
+namespace {
+
+constexpr uint8_t SYSEX_START = 0xF0;
+constexpr uint8_t SYSEX_END = 0xF7;
+constexpr uint8_t YAMAHA_ID = 0x43;
+constexpr uint8_t FORMAT_32_VOICES = 0x09;
+constexpr size_t BULK_HEADER_BYTES = 6;
+constexpr size_t BULK_DATA_BYTES = 4096;
+constexpr size_t VOICE_BYTES = 128;
+constexpr size_t OPERATOR_BYTES = 17;
+constexpr int VOICES_PER_BULK = 32;
+
+/* offsets in a packed voice, after the six operators (stored OP6 first) */
+constexpr size_t VOICE_ALGORITHM = 110;
+constexpr size_t VOICE_FEEDBACK = 111;
+constexpr size_t VOICE_NAME = 118;
+constexpr size_t VOICE_NAME_LENGTH = 10;
+
+/* offsets within a packed operator */
+constexpr size_t OP_RATE_1 = 0;
+constexpr size_t OP_RATE_2 = 1;
+constexpr size_t OP_RATE_4 = 3;
+constexpr size_t OP_LEVEL_3 = 6;
+constexpr size_t OP_OUTPUT_LEVEL = 14;
+constexpr size_t OP_MODE_COARSE = 15;
+constexpr size_t OP_FINE = 16;
+
+constexpr int DX_MAX = 99;
+constexpr double MIN_SEGMENT_TIME = 0.001;
+constexpr double MAX_SEGMENT_TIME = 10.0;
+/* peak phase deviation in radians of a full-level modulator on a DX7 */
+constexpr double DX7_MODULATION_DEPTH = 2.0 * Constants::TWO_PI;
+/* fixed-frequency operators become a ratio to this pitch */
+constexpr double FIXED_FREQUENCY_REFERENCE = 440.0;
+
+/* DX7 levels are about 0.75 dB per step, 8 steps per halving */
+double levelToAmplitude(int level) {
+    return level <= 0 ? 0.0 : std::pow(2.0, (std::min(level, DX_MAX) - DX_MAX) / 8.0);
+}
+
+/* envelope rates map exponentially onto segment times, rate 99 fastest */
+double rateToSeconds(int rate) {
+    const double position = std::min(rate, DX_MAX) / static_cast<double>(DX_MAX);
+    return MAX_SEGMENT_TIME * std::pow(MIN_SEGMENT_TIME / MAX_SEGMENT_TIME, position);
+}
+
+double operatorFrequency(const uint8_t* op) {
+    const bool fixed = op[OP_MODE_COARSE] & 0x01;
+    const int coarse = (op[OP_MODE_COARSE] >> 1) & 0x1F;
+    const int fine = std::min<int>(op[OP_FINE], DX_MAX);
+    if (fixed) {
+        const double hz = std::pow(10.0, coarse & 0x03) * std::pow(10.0, fine / 100.0);
+        return hz / FIXED_FREQUENCY_REFERENCE;
+    }
+    return (coarse == 0 ? 0.5 : coarse) * (1.0 + fine / 100.0);
+}
+
+FMPresetConfig convertVoice(const uint8_t* voice, int number) {
+    FMPresetConfig preset{};
+    
+    std::string name;
+    for (size_t i = 0; i < VOICE_NAME_LENGTH; i++) {
+        const char c = static_cast<char>(voice[VOICE_NAME + i] & 0x7F);
+        name += (c >= 0x20 && c < 0x7F) ? c : ' ';
+    }
+    name.erase(name.find_last_not_of(' ') + 1);
+    name.erase(0, name.find_first_not_of(' '));
+    preset.setName(name.empty() ? "DX7 " + std::to_string(number + 1) : name);
+    
+    preset.algorithm = voice[VOICE_ALGORITHM] & 0x1F;
+    preset.feedback = (voice[VOICE_FEEDBACK] & 0x07) / 7.0;
+    preset.masterVolume = PresetConstants::VOLUME_LOUD;
+    
+    const AlgorithmTopology& topology = ALGORITHMS[preset.algorithm];
+    for (int op = 0; op < Constants::MAX_OPERATORS; op++) {
+        const uint8_t* data = voice + (Constants::MAX_OPERATORS - 1 - op) * OPERATOR_BYTES;
+        auto& config = preset.operators[op];
+        config.frequency = operatorFrequency(data);
+        config.amplitude = levelToAmplitude(data[OP_OUTPUT_LEVEL]);
+        config.modulationIndex = topology.inputs[op][0] != AlgorithmTopology::NONE ? DX7_MODULATION_DEPTH : 0.0;
+        config.waveform = WaveformType::SINE;
+        config.attack = rateToSeconds(data[OP_RATE_1]);
+        config.decay = rateToSeconds(data[OP_RATE_2]);
+        config.sustain = levelToAmplitude(data[OP_LEVEL_3]);
+        config.release = rateToSeconds(data[OP_RATE_4]);
+    }
+    return preset;
+}
+
+}
+
+/**
+ * @brief Import every 32-voice bulk dump in a DX7 SysEx file
+ *
+ * Each voice becomes one preset named after the patch. The DX7 envelope,
+ * with four rates and four levels, is reduced to attack (rate 1), decay
+ * (rate 2), sustain (level 3) and release (rate 4). Output levels and
+ * frequency ratios carry over. The algorithm number is kept but played
+ * with this synthesizer's own routing for that number. Fixed-frequency
+ * operators become a ratio to A440. Detune, key and velocity scaling, the
+ * pitch envelope and the LFO are not imported. Other SysEx messages are
+ * skipped.
+ *
+ * @param path SysEx file to read
+ * @return The imported presets, 32 per bulk dump
+ * @throws std::runtime_error if the file cannot be read, a dump is
+ *         truncated, or the file contains no 32-voice dump
+ */
+std::vector<FMPresetConfig> importDx7SysEx(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    std::vector<FMPresetConfig> presets;
+    size_t position = 0;
+    while ((position = static_cast<size_t>(std::find(data.begin() + position, data.end(), SYSEX_START) -
+                                           data.begin())) < data.size()) {
+        const uint8_t* message = data.data() + position;
+        const size_t remaining = data.size() - position;
+        const bool bulkDump = remaining >= BULK_HEADER_BYTES && message[1] == YAMAHA_ID &&
+                              (message[2] & 0xF0) == 0x00 && message[3] == FORMAT_32_VOICES &&
+                              message[4] == 0x20 && message[5] == 0x00;
+        if (!bulkDump) {
+            position++;
+            continue;
+        }
+        
+        const size_t messageBytes = BULK_HEADER_BYTES + BULK_DATA_BYTES + 2;
+        if (remaining < messageBytes || message[messageBytes - 1] != SYSEX_END) {
+            throw std::runtime_error(path + ": truncated DX7 bulk dump");
+        }
+        
+        const uint8_t* voices = message + BULK_HEADER_BYTES;
+        unsigned sum = 0;
+        for (size_t i = 0; i < BULK_DATA_BYTES; i++) {
+            sum += voices[i];
+        }
+        if (((128 - (sum & 0x7F)) & 0x7F) != message[BULK_HEADER_BYTES + BULK_DATA_BYTES]) {
+            printf("Checksum mismatch in DX7 bulk dump at byte %zu of %s\n", position, path.c_str());
+        }
+        
+        for (int voice = 0; voice < VOICES_PER_BULK; voice++) {
+            presets.push_back(convertVoice(voices + voice * VOICE_BYTES, static_cast<int>(presets.size())));
+        }
+        position += messageBytes;
+    }
+    
+    if (presets.empty()) {
+        throw std::runtime_error(path + " contains no DX7 32-voice bulk dump");
+    }
+    return presets;
+}
+
+}
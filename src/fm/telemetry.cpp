@@ -0,0 +1,161 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/telemetry.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+
+namespace toybasic {
+
+RenderTelemetry::RenderTelemetry()
+    : blocks_(0), renderNanoseconds_(0), deadlineNanoseconds_(0),
+      minNanoseconds_(std::numeric_limits<uint64_t>::max()), maxNanoseconds_(0), peakLoadPermille_(0),
+      underruns_(0), overruns_(0), voiceSteals_(0), activeVoices_(0),
+      lastBlocks_(0), lastRenderNanoseconds_(0), lastDeadlineNanoseconds_(0) {
+    for (auto& bucket : histogram_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    lastHistogram_.fill(0);
+}
+
+/**
+ * @brief Monotonic timestamp for timing blocks
+ */
+uint64_t RenderTelemetry::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Record one rendered block (render thread only)
+ * 
+ * @param renderNanoseconds How long rendering the block took
+ * @param deadlineNanoseconds How long the block's audio lasts, i.e. the
+ *                            time available to render it
+ */
+void RenderTelemetry::recordBlock(uint64_t renderNanoseconds, uint64_t deadlineNanoseconds) {
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+    renderNanoseconds_.fetch_add(renderNanoseconds, std::memory_order_relaxed);
+    deadlineNanoseconds_.fetch_add(deadlineNanoseconds, std::memory_order_relaxed);
+    histogram_[bucketIndex(renderNanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    
+    /* the poller resets these, so update with a compare-exchange rather than a store */
+    uint64_t min = minNanoseconds_.load(std::memory_order_relaxed);
+    while (renderNanoseconds < min && !minNanoseconds_.compare_exchange_weak(min, renderNanoseconds, std::memory_order_relaxed)) {
+    }
+    uint64_t max = maxNanoseconds_.load(std::memory_order_relaxed);
+    while (renderNanoseconds > max && !maxNanoseconds_.compare_exchange_weak(max, renderNanoseconds, std::memory_order_relaxed)) {
+    }
+    if (deadlineNanoseconds > 0) {
+        const uint32_t load = static_cast<uint32_t>(std::min<uint64_t>(
+            renderNanoseconds * 1000 / deadlineNanoseconds, std::numeric_limits<uint32_t>::max()));
+        uint32_t peak = peakLoadPermille_.load(std::memory_order_relaxed);
+        while (load > peak && !peakLoadPermille_.compare_exchange_weak(peak, load, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+/**
+ * @brief Statistics since the previous call (polling thread only)
+ * 
+ * Counters may be mid-update while they are read, so a window can be off
+ * by the block being rendered at that moment; it is never lost, only
+ * counted in the next window.
+ */
+RenderStatistics RenderTelemetry::collect() {
+    RenderStatistics stats;
+    
+    const uint64_t blocks = blocks_.load(std::memory_order_relaxed);
+    const uint64_t render = renderNanoseconds_.load(std::memory_order_relaxed);
+    const uint64_t deadline = deadlineNanoseconds_.load(std::memory_order_relaxed);
+    const uint64_t min = minNanoseconds_.exchange(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    const uint64_t max = maxNanoseconds_.exchange(0, std::memory_order_relaxed);
+    const uint32_t peakLoad = peakLoadPermille_.exchange(0, std::memory_order_relaxed);
+    
+    std::array<uint32_t, BUCKETS> window;
+    uint64_t counted = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        const uint32_t count = histogram_[i].load(std::memory_order_relaxed);
+        window[i] = count - lastHistogram_[i];
+        lastHistogram_[i] = count;
+        counted += window[i];
+    }
+    
+    stats.blocks = blocks - lastBlocks_;
+    if (stats.blocks > 0) {
+        const uint64_t windowRender = render - lastRenderNanoseconds_;
+        const uint64_t windowDeadline = deadline - lastDeadlineNanoseconds_;
+        stats.averageBlockMicroseconds = windowRender / 1000.0 / stats.blocks;
+        stats.dspLoadPercent = windowDeadline ? 100.0 * windowRender / windowDeadline : 0.0;
+        if (min != std::numeric_limits<uint64_t>::max()) {
+            stats.minBlockMicroseconds = min / 1000.0;
+        }
+        stats.maxBlockMicroseconds = max / 1000.0;
+        stats.peakDspLoadPercent = peakLoad / 10.0;
+        
+        /* smallest bucket with at least 99% of the window's blocks at or below it */
+        const uint64_t target = counted - counted / 100;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += window[i];
+            if (seen >= target && seen > 0) {
+                stats.p99BlockMicroseconds = std::min(bucketValue(i) / 1000.0, stats.maxBlockMicroseconds);
+                break;
+            }
+        }
+    }
+    lastBlocks_ = blocks;
+    lastRenderNanoseconds_ = render;
+    lastDeadlineNanoseconds_ = deadline;
+    
+    stats.underruns = underruns_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.voiceSteals = voiceSteals_.load(std::memory_order_relaxed);
+    stats.activeVoices = activeVoices_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/*
+ * Values below SUB_BUCKETS get a bucket each; above that, each octave
+ * [2^e, 2^(e+1)) is split into SUB_BUCKETS equal steps.
+ */
+int RenderTelemetry::bucketIndex(uint64_t nanoseconds) {
+    if (nanoseconds < SUB_BUCKETS) {
+        return static_cast<int>(nanoseconds);
+    }
+    const int exponent = std::min(static_cast<int>(std::bit_width(nanoseconds)) - 1, MAX_EXPONENT);
+    if (exponent == MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    const int step = static_cast<int>((nanoseconds >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + step;
+}
+
+/* upper edge of a bucket, so a percentile is never reported low */
+double RenderTelemetry::bucketValue(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const int step = index % SUB_BUCKETS;
+    return static_cast<double>((static_cast<uint64_t>(SUB_BUCKETS + step + 1)) << (exponent - SUB_BUCKET_BITS));
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fm/wavetable.hpp"
+#include "fm/fm.hpp"
+#include <algorithm>
+
+namespace toybasic {
+
+/**
+ * @brief The process-wide tables, built on first use
+ *
+ * The synthesizer constructor calls this, so the tables already exist by
+ * the time an audio thread reads them.
+ */
+const BandLimitedWavetables& BandLimitedWavetables::get() {
+    static const BandLimitedWavetables tables;
+    return tables;
+}
+
+/**
+ * @brief Sum the Fourier series of every shape into its mip chain
+ *
+ * The series match the naive waveforms' phase alignment, so switching a
+ * patch to the tables keeps its timbre and only removes the harmonics that
+ * would alias. Harmonics are taken from one sampled sine cycle, which is
+ * exact because every harmonic lands on a table sample, and each level
+ * continues the sum of the level below it.
+ */
+BandLimitedWavetables::BandLimitedWavetables()
+    : tables_(static_cast<size_t>(SHAPES * LEVELS) * STRIDE) {
+    std::vector<double> sine(SIZE);
+    for (int i = 0; i < SIZE; i++) {
+        sine[i] = std::sin(Constants::TWO_PI * i / SIZE);
+    }
+
+    const WaveformType shapes[SHAPES] = {WaveformType::SAWTOOTH, WaveformType::SQUARE, WaveformType::TRIANGLE};
+    std::vector<double> sum(SIZE);
+    for (WaveformType waveform : shapes) {
+        std::fill(sum.begin(), sum.end(), 0.0);
+        int harmonic = 1;
+        for (int level = 0; level < LEVELS; level++) {
+            for (; harmonic <= (1 << level); harmonic++) {
+                double gain = 0.0;
+                int offset = 0;
+                switch (waveform) {
+                    case WaveformType::SAWTOOTH:
+                        gain = -2.0 / (Constants::PI * harmonic);
+                        break;
+                    case WaveformType::SQUARE:
+                        gain = harmonic % 2 ? 4.0 / (Constants::PI * harmonic) : 0.0;
+                        break;
+                    case WaveformType::TRIANGLE:
+                        /* cosine terms, read a quarter cycle ahead */
+                        gain = harmonic % 2 ? -8.0 / (Constants::PI * Constants::PI * harmonic * harmonic) : 0.0;
+                        offset = SIZE / 4;
+                        break;
+                    default:
+                        break;
+                }
+                if (gain == 0.0) {
+                    continue;
+                }
+                for (int i = 0; i < SIZE; i++) {
+                    sum[i] += gain * sine[(harmonic * i + offset) & (SIZE - 1)];
+                }
+            }
+
+            float* samples = &tables_[(static_cast<size_t>(static_cast<int>(waveform) - 1) * LEVELS + level) * STRIDE];
+            for (int i = 0; i < SIZE; i++) {
+                samples[i] = static_cast<float>(sum[i]);
+            }
+            samples[SIZE] = samples[0];
+        }
+    }
+}
+
+/**
+ * @brief Richest mip level that stays below Nyquist
+ *
+ * @param cyclesPerSample Oscillator frequency divided by the sample rate
+ * @return Level whose 2^level harmonics all fit under half the sample rate;
+ *         level 0, the bare fundamental, when even that does not fit
+ */
+int BandLimitedWavetables::levelForIncrement(double cyclesPerSample) {
+    if (cyclesPerSample <= 0.5 / (1 << (LEVELS - 1))) {
+        return LEVELS - 1;
+    }
+    int harmonics = static_cast<int>(0.5 / cyclesPerSample);
+    int level = 0;
+    while (level + 1 < LEVELS && (2 << level) <= harmonics) {
+        level++;
+    }
+    return level;
+}
+
+}
@@ -17,6 +17,7 @@
  */
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QMainWindow>
 #include <QMessageBox>
 
@@ -29,6 +30,8 @@
  * Initializes the Qt application and creates the main window for the
  * FM synthesizer interface. This includes setting up the synthesizer
  * engine, keyboard widget, and all user interface components.
+ * --realtime asks for real-time scheduling of the render threads, pinned
+ * to the cores listed with --realtime-cores.
  * 
  * @param argc Number of command line arguments
  * @param argv Array of command line argument strings
@@ -42,11 +45,36 @@ int main(int argc, char *argv[])
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("Paige Thompson");
     
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption realtimeOption("realtime",
+        "Run the render threads at real-time priority with their memory locked.");
+    QCommandLineOption coresOption("realtime-cores",
+        "Pin the render threads to these cores, in turn.", "list");
+    QCommandLineOption priorityOption("realtime-priority",
+        "SCHED_FIFO priority of the render threads (Linux).", "priority",
+        QString::number(toybasic::RealtimeConfig::DEFAULT_PRIORITY));
+    parser.addOption(realtimeOption);
+    parser.addOption(coresOption);
+    parser.addOption(priorityOption);
+    parser.process(app);
+    
+    toybasic::RealtimeConfig realtime;
+    realtime.enabled = parser.isSet(realtimeOption);
+    realtime.priority = parser.value(priorityOption).toInt();
+    for (const QString& core : parser.value(coresOption).split(',', Qt::SkipEmptyParts)) {
+        realtime.cores.push_back(core.trimmed().toInt());
+    }
+    
     // Apply Catppuccin Frappé theme
     ThemeManager::getInstance().applyTheme(&app);
     
     try {
         MainWindow window;
+        if (realtime.enabled) {
+            window.enableRealtimeMode(realtime);
+        }
         window.show();
         
         return app.exec();
@@ -0,0 +1,323 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fm/convert.hpp"
+#include "fm/fm.hpp"
+#include "fm/presets.hpp"
+#include "render/score.hpp"
+#include "render/wav.hpp"
+
+namespace {
+
+struct RenderOptions {
+    std::string input;
+    std::string output;
+    std::string preset = "0";
+    std::string bank;
+    std::string saveBank;
+    bool listPresets = false;
+    int sampleRate = toybasic::Constants::DEFAULT_SAMPLE_RATE;
+    double tail = 2.0;
+    int channel = -1;
+    int voices = toybasic::Constants::DEFAULT_VOICES;
+    toybasic::OscillatorMode oscillatorMode = toybasic::OscillatorMode::FLOATING_POINT;
+    int oversampling = 1;
+    bool dither = true;
+    bool dacEmulation = false;
+};
+
+void printUsage(const char* program) {
+    std::printf(
+        "Usage: %s [options] <score.mid|score.txt> <output.wav>\n"
+        "\n"
+        "Renders a Standard MIDI File or text note list offline, as fast as\n"
+        "the CPU allows, to a full-scale 16-bit stereo WAV file. Every MIDI\n"
+        "channel plays the preset; pitch bend and the modulation wheel only\n"
+        "move their own channel, with channels 9-16 sharing those of 1-8.\n"
+        "\n"
+        "Options:\n"
+        "  -p, --preset <index|name>  Preset to play (default 0)\n"
+        "  -r, --rate <hz>            Sample rate (default %d)\n"
+        "  -t, --tail <seconds>       Audio kept after the last event (default 2)\n"
+        "  -c, --channel <1-16>       Only render this MIDI channel (default all)\n"
+        "  -v, --voices <1-%d>       Polyphony (default %d)\n"
+        "  -o, --oscillator <mode>    'float' or 'fixed' (default float)\n"
+        "  -x, --oversample <1|2|4>   Run the operators at 2x or 4x the rate\n"
+        "                             (default 1)\n"
+        "      --no-dither            Round to 16 bits without TPDF dither\n"
+        "      --dac                  Go through the emulated 14-bit DAC first,\n"
+        "                             which also turns dither off\n"
+        "  -b, --bank <file>          Load presets from a bank, or import a DX7\n"
+        "                             32-voice bank if the file ends in .syx\n"
+        "      --save-bank <file>     Write the presets to a bank file and exit\n"
+        "  -l, --list-presets         List the available presets and exit\n"
+        "  -h, --help                 Show this help\n",
+        program, toybasic::Constants::DEFAULT_SAMPLE_RATE,
+        toybasic::Constants::MAX_VOICES, toybasic::Constants::DEFAULT_VOICES);
+}
+
+bool hasSuffix(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           std::equal(suffix.rbegin(), suffix.rend(), text.rbegin(),
+                      [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+}
+
+void loadPresets(toybasic::PresetManager& presets, const std::string& bank) {
+    if (bank.empty()) {
+        return;
+    }
+    if (hasSuffix(bank, ".syx")) {
+        presets.importSysEx(bank);
+    } else {
+        presets.loadBank(bank);
+    }
+}
+
+bool isNumber(const std::string& text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+/**
+ * @brief Synthesizer event for a score event, on its own synthesizer channel
+ * 
+ * MIDI channel n plays synthesizer channel n modulo Constants::MAX_CHANNELS,
+ * so a bend or modulation wheel only moves the notes of its channel (and of
+ * the one channel that shares its synthesizer channel). All notes off
+ * releases every channel.
+ */
+toybasic::SynthEvent toSynthEvent(const toybasic::ScoreEvent& event, uint64_t frame) {
+    using Type = toybasic::ScoreEvent::Type;
+    using SynthType = toybasic::SynthEvent::Type;
+    const int channel = event.channel % toybasic::Constants::MAX_CHANNELS;
+    toybasic::SynthEvent synthEvent{SynthType::ALL_NOTES_OFF, channel, 0, {}};
+    switch (event.type) {
+        case Type::NOTE_ON:
+            synthEvent = {SynthType::NOTE_ON, channel, event.note, {event.value}};
+            break;
+        case Type::NOTE_OFF:
+            synthEvent = {SynthType::NOTE_OFF, channel, event.note, {}};
+            break;
+        case Type::PITCH_BEND:
+            synthEvent = {SynthType::PITCH_BEND, channel, 0, {event.value}};
+            break;
+        case Type::MODULATION_WHEEL:
+            synthEvent = {SynthType::MODULATION_WHEEL, channel, 0, {event.value}};
+            break;
+        case Type::ALL_NOTES_OFF:
+            break;
+    }
+    synthEvent.frame = frame;
+    return synthEvent;
+}
+
+/**
+ * @brief Render the whole score into the WAV file
+ * 
+ * The score is fed through the synthesizer's input queue with every event
+ * stamped with its frame, a block ahead of the audio, and the synthesizer
+ * splits each block at the events inside it, the same path live MIDI
+ * takes. Every event takes effect on the sample it is scheduled for.
+ * Nothing waits on a clock; the loop runs flat out. The float mix goes
+ * through the same SampleConverter as a 16-bit audio device, so the file
+ * uses the full 16-bit range.
+ */
+size_t renderScore(toybasic::FMSynthesizer& synth, const toybasic::Score& score,
+                   const RenderOptions& options, toybasic::WavWriter& wav) {
+    const auto& events = score.getEvents();
+    const double rate = options.sampleRate;
+    const size_t totalFrames = static_cast<size_t>(std::llround((score.getEndTime() + options.tail) * rate));
+    std::vector<float> left(toybasic::Constants::MAX_BLOCK_SIZE);
+    std::vector<float> right(toybasic::Constants::MAX_BLOCK_SIZE);
+    std::vector<int16_t> block(toybasic::Constants::MAX_BLOCK_SIZE * 2);
+    
+    toybasic::SampleConverter converter(toybasic::SampleFormat::INT16);
+    converter.setDither(options.dither);
+    converter.setDacEmulation(options.dacEmulation);
+    
+    size_t frame = 0;
+    size_t next = 0;
+    while (frame < totalFrames) {
+        size_t chunk = std::min(totalFrames - frame, static_cast<size_t>(toybasic::Constants::MAX_BLOCK_SIZE));
+        while (next < events.size()) {
+            const size_t eventFrame = static_cast<size_t>(std::llround(events[next].time * rate));
+            if (eventFrame >= frame + chunk) {
+                break;
+            }
+            if (options.channel < 0 || events[next].channel == options.channel) {
+                if (!synth.postInputEvent(toSynthEvent(events[next], eventFrame))) {
+                    /* queue full: stop the block short and post the rest after it */
+                    chunk = std::max(eventFrame, frame + 1) - frame;
+                    break;
+                }
+            }
+            next++;
+        }
+        
+        synth.renderBlock(left.data(), right.data(), chunk);
+        converter.convert(left.data(), right.data(), chunk, block.data());
+        wav.write(block.data(), chunk);
+        frame += chunk;
+    }
+    return totalFrames;
+}
+
+}
+
+/**
+ * @brief Entry point of the offline renderer
+ * 
+ * Uses the same FMSynthesizer core and presets as the GUI, without Qt or an
+ * audio device, so it runs on headless build machines.
+ */
+int main(int argc, char* argv[])
+{
+    RenderOptions options;
+    std::vector<std::string> positional;
+    
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-l" || arg == "--list-presets") {
+            options.listPresets = true;
+        } else if (arg == "-b" || arg == "--bank") {
+            options.bank = value();
+        } else if (arg == "--save-bank") {
+            options.saveBank = value();
+        } else if (arg == "-p" || arg == "--preset") {
+            options.preset = value();
+        } else if (arg == "-r" || arg == "--rate") {
+            options.sampleRate = std::atoi(value().c_str());
+        } else if (arg == "-t" || arg == "--tail") {
+            options.tail = std::atof(value().c_str());
+        } else if (arg == "-c" || arg == "--channel") {
+            options.channel = std::atoi(value().c_str()) - 1;
+        } else if (arg == "-v" || arg == "--voices") {
+            options.voices = std::atoi(value().c_str());
+        } else if (arg == "-o" || arg == "--oscillator") {
+            const std::string mode = value();
+            if (mode == "fixed") {
+                options.oscillatorMode = toybasic::OscillatorMode::FIXED_POINT;
+            } else if (mode != "float") {
+                std::fprintf(stderr, "Unknown oscillator mode: %s\n", mode.c_str());
+                return 2;
+            }
+        } else if (arg == "-x" || arg == "--oversample") {
+            options.oversampling = std::atoi(value().c_str());
+        } else if (arg == "--no-dither") {
+            options.dither = false;
+        } else if (arg == "--dac") {
+            options.dacEmulation = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            printUsage(argv[0]);
+            return 2;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    toybasic::PresetManager presets;
+    try {
+        loadPresets(presets, options.bank);
+        if (!options.saveBank.empty()) {
+            presets.saveBank(options.saveBank);
+            std::printf("Wrote %d presets to %s\n", presets.getPresetCount(), options.saveBank.c_str());
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    if (options.listPresets) {
+        for (int index = 0; index < presets.getPresetCount(); index++) {
+            const std::string_view name = presets.getPreset(index).getName();
+            std::printf("%2d  %.*s\n", index, static_cast<int>(name.size()), name.data());
+        }
+        return 0;
+    }
+    if (!options.saveBank.empty() && positional.empty()) {
+        return 0;
+    }
+    
+    if (positional.size() != 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    options.input = positional[0];
+    options.output = positional[1];
+    if (options.sampleRate <= 0 || options.tail < 0.0 || options.channel < -1 || options.channel > 15 ||
+        options.voices < toybasic::Constants::MIN_VOICES || options.voices > toybasic::Constants::MAX_VOICES ||
+        (options.oversampling != 1 && options.oversampling != 2 && options.oversampling != 4)) {
+        std::fprintf(stderr, "Invalid sample rate, tail, channel, voice count or oversampling factor\n");
+        return 2;
+    }
+    
+    try {
+        const toybasic::Score score = toybasic::Score::load(options.input);
+        
+        toybasic::FMSynthesizer synth(options.sampleRate);
+        for (int channel = 0; channel < toybasic::Constants::MAX_CHANNELS; channel++) {
+            if (isNumber(options.preset)) {
+                presets.applyPreset(synth, channel, std::atoi(options.preset.c_str()));
+            } else {
+                presets.applyPreset(synth, channel, options.preset);
+            }
+        }
+        synth.setOscillatorMode(options.oscillatorMode);
+        synth.setOversampling(options.oversampling);
+        synth.setMaxVoices(options.voices);
+        
+        toybasic::WavWriter wav(options.output, options.sampleRate, 2);
+        const auto start = std::chrono::steady_clock::now();
+        const size_t frames = renderScore(synth, score, options, wav);
+        wav.close();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        const double seconds = static_cast<double>(frames) / options.sampleRate;
+        std::printf("Rendered %.2f s (%zu events) to %s in %.1f ms, %.0fx realtime\n",
+                    seconds, score.getEvents().size(), options.output.c_str(), elapsed * 1000.0,
+                    elapsed > 0.0 ? seconds / elapsed : 0.0);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    
+    return 0;
+}
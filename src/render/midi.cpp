@@ -0,0 +1,278 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "render/score.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace toybasic {
+
+namespace {
+
+constexpr double DEFAULT_MICROSECONDS_PER_QUARTER = 500000.0;
+constexpr double PITCH_BEND_RANGE_SEMITONES = 2.0;
+constexpr int CONTROLLER_MODULATION_WHEEL = 1;
+constexpr int CONTROLLER_ALL_SOUND_OFF = 120;
+constexpr int CONTROLLER_ALL_NOTES_OFF = 123;
+
+/* a channel event before tick times are converted to seconds */
+struct TickEvent {
+    uint64_t tick;
+    ScoreEvent event;
+};
+
+struct TempoChange {
+    uint64_t tick;
+    double microsecondsPerQuarter;
+};
+
+/* bounds-checked big-endian reader over one chunk */
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size), position_(0) {}
+    
+    bool atEnd() const { return position_ >= size_; }
+    
+    uint8_t peek() const {
+        require(1);
+        return data_[position_];
+    }
+    
+    uint8_t byte() {
+        require(1);
+        return data_[position_++];
+    }
+    
+    uint32_t word(int bytes) {
+        uint32_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = (value << 8) | byte();
+        }
+        return value;
+    }
+    
+    /* MIDI variable-length quantity: 7 bits per byte, high bit continues */
+    uint32_t variableLength() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            uint8_t b = byte();
+            value = (value << 7) | (b & 0x7F);
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Invalid variable-length quantity in MIDI file");
+    }
+    
+    void skip(size_t bytes) {
+        require(bytes);
+        position_ += bytes;
+    }
+    
+    const uint8_t* current() const { return data_ + position_; }
+
+private:
+    void require(size_t bytes) const {
+        if (size_ - position_ < bytes) {
+            throw std::runtime_error("Truncated MIDI file");
+        }
+    }
+    
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_;
+};
+
+void readTrack(ByteReader track, std::vector<TickEvent>& events, std::vector<TempoChange>& tempo) {
+    uint64_t tick = 0;
+    uint8_t runningStatus = 0;
+    
+    while (!track.atEnd()) {
+        tick += track.variableLength();
+        
+        uint8_t status = track.peek();
+        if (status & 0x80) {
+            track.byte();
+        } else if (runningStatus) {
+            status = runningStatus;
+        } else {
+            throw std::runtime_error("MIDI data byte without a status");
+        }
+        
+        if (status == 0xFF) {
+            uint8_t type = track.byte();
+            uint32_t length = track.variableLength();
+            if (type == 0x51 && length == 3) {
+                tempo.push_back({tick, static_cast<double>(track.word(3))});
+            } else if (type == 0x2F) {
+                return;
+            } else {
+                track.skip(length);
+            }
+            runningStatus = 0;
+            continue;
+        }
+        if (status == 0xF0 || status == 0xF7) {
+            track.skip(track.variableLength());
+            runningStatus = 0;
+            continue;
+        }
+        
+        runningStatus = status;
+        const int channel = status & 0x0F;
+        switch (status & 0xF0) {
+            case 0x80: {
+                int note = track.byte();
+                track.byte();
+                events.push_back({tick, {0.0, ScoreEvent::Type::NOTE_OFF, channel, note, 0.0}});
+                break;
+            }
+            case 0x90: {
+                int note = track.byte();
+                int velocity = track.byte();
+                if (velocity == 0) {
+                    events.push_back({tick, {0.0, ScoreEvent::Type::NOTE_OFF, channel, note, 0.0}});
+                } else {
+                    events.push_back({tick, {0.0, ScoreEvent::Type::NOTE_ON, channel, note, velocity / 127.0}});
+                }
+                break;
+            }
+            case 0xB0: {
+                int controller = track.byte();
+                int value = track.byte();
+                if (controller == CONTROLLER_MODULATION_WHEEL) {
+                    events.push_back({tick, {0.0, ScoreEvent::Type::MODULATION_WHEEL, channel, 0, value / 127.0}});
+                } else if (controller == CONTROLLER_ALL_SOUND_OFF || controller == CONTROLLER_ALL_NOTES_OFF) {
+                    events.push_back({tick, {0.0, ScoreEvent::Type::ALL_NOTES_OFF, channel, 0, 0.0}});
+                }
+                break;
+            }
+            case 0xE0: {
+                int lsb = track.byte();
+                int msb = track.byte();
+                double bend = ((msb << 7 | lsb) - 8192) / 8192.0;
+                double ratio = std::pow(2.0, bend * PITCH_BEND_RANGE_SEMITONES / 12.0);
+                events.push_back({tick, {0.0, ScoreEvent::Type::PITCH_BEND, channel, 0, ratio}});
+                break;
+            }
+            case 0xA0:
+                track.skip(2);
+                break;
+            case 0xC0:
+            case 0xD0:
+                track.skip(1);
+                break;
+            default:
+                throw std::runtime_error("Unsupported MIDI status byte");
+        }
+    }
+}
+
+}
+
+/**
+ * @brief Load a Standard MIDI File (format 0 or 1)
+ * 
+ * Note on/off, pitch bend (+/-2 semitones), the modulation wheel and the
+ * all-notes-off controllers are kept; other messages are skipped. Tempo
+ * changes in any track apply to all tracks, and both metrical and SMPTE
+ * time divisions are supported.
+ * 
+ * @param path File to read
+ * @return The sorted score, times in seconds
+ * @throws std::runtime_error if the file is not a valid MIDI file
+ */
+Score Score::loadMidiFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    ByteReader reader(data.data(), data.size());
+    if (reader.word(4) != 0x4D546864) {
+        throw std::runtime_error(path + " is not a MIDI file");
+    }
+    uint32_t headerLength = reader.word(4);
+    if (headerLength < 6) {
+        throw std::runtime_error("Invalid MIDI header in " + path);
+    }
+    uint32_t format = reader.word(2);
+    uint32_t trackCount = reader.word(2);
+    uint32_t division = reader.word(2);
+    reader.skip(headerLength - 6);
+    if (format > 1) {
+        throw std::runtime_error("MIDI format " + std::to_string(format) + " is not supported");
+    }
+    
+    std::vector<TickEvent> events;
+    std::vector<TempoChange> tempo;
+    for (uint32_t track = 0; track < trackCount && !reader.atEnd(); track++) {
+        uint32_t id = reader.word(4);
+        uint32_t length = reader.word(4);
+        const uint8_t* chunk = reader.current();
+        reader.skip(length);
+        if (id == 0x4D54726B) {
+            readTrack(ByteReader(chunk, length), events, tempo);
+        }
+    }
+    
+    /* tracks are concatenated, so order by tick while keeping track order within a tick */
+    std::stable_sort(events.begin(), events.end(),
+        [](const TickEvent& a, const TickEvent& b) { return a.tick < b.tick; });
+    std::stable_sort(tempo.begin(), tempo.end(),
+        [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+    
+    Score score;
+    if (division & 0x8000) {
+        const int framesPerSecond = -static_cast<int8_t>(division >> 8);
+        const int ticksPerFrame = division & 0xFF;
+        if (framesPerSecond <= 0 || ticksPerFrame == 0) {
+            throw std::runtime_error("Invalid SMPTE time division in " + path);
+        }
+        const double secondsPerTick = 1.0 / (framesPerSecond * ticksPerFrame);
+        for (TickEvent& tickEvent : events) {
+            tickEvent.event.time = tickEvent.tick * secondsPerTick;
+            score.add(tickEvent.event);
+        }
+        return score;
+    }
+    
+    const double ticksPerQuarter = division ? division : 1;
+    double microsecondsPerQuarter = DEFAULT_MICROSECONDS_PER_QUARTER;
+    uint64_t segmentTick = 0;
+    double segmentTime = 0.0;
+    size_t nextTempo = 0;
+    for (TickEvent& tickEvent : events) {
+        while (nextTempo < tempo.size() && tempo[nextTempo].tick <= tickEvent.tick) {
+            segmentTime += (tempo[nextTempo].tick - segmentTick) * microsecondsPerQuarter / ticksPerQuarter * 1e-6;
+            segmentTick = tempo[nextTempo].tick;
+            microsecondsPerQuarter = tempo[nextTempo].microsecondsPerQuarter;
+            nextTempo++;
+        }
+        tickEvent.event.time = segmentTime + (tickEvent.tick - segmentTick) * microsecondsPerQuarter / ticksPerQuarter * 1e-6;
+        score.add(tickEvent.event);
+    }
+    return score;
+}
+
+}
@@ -0,0 +1,154 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "render/score.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace toybasic {
+
+void Score::add(const ScoreEvent& event) {
+    events_.push_back(event);
+}
+
+/**
+ * @brief Order events by time
+ * 
+ * The sort is stable, so events at the same time keep the order they were
+ * added in (a note off followed by a note on of the same key retriggers it).
+ */
+void Score::sort() {
+    std::stable_sort(events_.begin(), events_.end(),
+        [](const ScoreEvent& a, const ScoreEvent& b) { return a.time < b.time; });
+}
+
+double Score::getEndTime() const {
+    double end = 0.0;
+    for (const ScoreEvent& event : events_) {
+        end = std::max(end, event.time);
+    }
+    return end;
+}
+
+/**
+ * @brief Load a score, picking the format from the file contents
+ * 
+ * Files starting with an "MThd" chunk are read as Standard MIDI Files,
+ * anything else as a text score.
+ * 
+ * @param path File to read
+ * @return The sorted score
+ * @throws std::runtime_error if the file cannot be read or parsed
+ */
+Score Score::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    char magic[4] = {};
+    file.read(magic, sizeof(magic));
+    if (file.gcount() == 4 && std::string(magic, 4) == "MThd") {
+        return loadMidiFile(path);
+    }
+    return loadTextScore(path);
+}
+
+/**
+ * @brief Load a plain-text note list
+ * 
+ * One event per line, times in seconds; '#' starts a comment:
+ * 
+ *     <time> on <note> [velocity]
+ *     <time> off <note>
+ *     <time> note <note> <duration> [velocity]
+ *     <time> bend <ratio>
+ *     <time> mod <amount>
+ *     <time> alloff
+ * 
+ * Notes are MIDI note numbers, velocities and mod amounts range 0.0-1.0
+ * (velocity defaults to 1.0), and a bend ratio of 1.0 is no bend.
+ * 
+ * @param path File to read
+ * @return The sorted score
+ * @throws std::runtime_error on a malformed line
+ */
+Score Score::loadTextScore(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    
+    Score score;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        
+        double time;
+        std::string command;
+        if (!(fields >> time)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected a time");
+        }
+        if (!(fields >> command) || time < 0.0) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected an event");
+        }
+        
+        bool valid = true;
+        if (command == "on" || command == "note") {
+            int note = 0;
+            double duration = 0.0;
+            double velocity = 1.0;
+            valid = static_cast<bool>(fields >> note);
+            if (valid && command == "note") {
+                valid = static_cast<bool>(fields >> duration) && duration >= 0.0;
+            }
+            fields >> velocity;
+            score.add({time, ScoreEvent::Type::NOTE_ON, 0, note, velocity});
+            if (command == "note") {
+                score.add({time + duration, ScoreEvent::Type::NOTE_OFF, 0, note, 0.0});
+            }
+        } else if (command == "off") {
+            int note = 0;
+            valid = static_cast<bool>(fields >> note);
+            score.add({time, ScoreEvent::Type::NOTE_OFF, 0, note, 0.0});
+        } else if (command == "bend" || command == "mod") {
+            double value = 0.0;
+            valid = static_cast<bool>(fields >> value);
+            score.add({time, command == "bend" ? ScoreEvent::Type::PITCH_BEND : ScoreEvent::Type::MODULATION_WHEEL,
+                       0, 0, value});
+        } else if (command == "alloff") {
+            score.add({time, ScoreEvent::Type::ALL_NOTES_OFF, 0, 0, 0.0});
+        } else {
+            valid = false;
+        }
+        
+        if (!valid) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": malformed '" + command + "' event");
+        }
+    }
+    
+    score.sort();
+    return score;
+}
+
+}
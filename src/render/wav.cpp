@@ -0,0 +1,116 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "render/wav.hpp"
+#include <stdexcept>
+
+namespace toybasic {
+
+namespace {
+    constexpr int BITS_PER_SAMPLE = 16;
+    constexpr int HEADER_BYTES = 44;
+    constexpr uint32_t FORMAT_PCM = 1;
+}
+
+/**
+ * @brief Create the file and write a provisional header
+ * 
+ * @param path Output file
+ * @param sampleRate Sample rate in Hz
+ * @param channels Interleaved channels per frame
+ * @throws std::runtime_error if the file cannot be created
+ */
+WavWriter::WavWriter(const std::string& path, int sampleRate, int channels)
+    : file_(path, std::ios::binary | std::ios::trunc), path_(path),
+      sampleRate_(sampleRate), channels_(channels), framesWritten_(0) {
+    if (!file_) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    writeHeader();
+}
+
+WavWriter::~WavWriter() {
+    if (file_.is_open()) {
+        file_.flush();
+        writeHeader();
+        file_.close();
+    }
+}
+
+/**
+ * @brief Append frames to the data chunk
+ * 
+ * @param interleaved frames * channels samples
+ * @param frames Number of frames
+ */
+void WavWriter::write(const int16_t* interleaved, size_t frames) {
+    const size_t samples = frames * channels_;
+    bytes_.resize(samples * 2);
+    for (size_t i = 0; i < samples; i++) {
+        const uint16_t sample = static_cast<uint16_t>(interleaved[i]);
+        bytes_[i * 2] = static_cast<char>(sample & 0xFF);
+        bytes_[i * 2 + 1] = static_cast<char>(sample >> 8);
+    }
+    file_.write(bytes_.data(), static_cast<std::streamsize>(bytes_.size()));
+    framesWritten_ += frames;
+}
+
+/**
+ * @brief Patch the chunk sizes and close the file
+ * 
+ * @throws std::runtime_error if any write failed
+ */
+void WavWriter::close() {
+    if (!file_.is_open()) {
+        return;
+    }
+    writeHeader();
+    file_.close();
+    if (file_.fail()) {
+        throw std::runtime_error("Failed to write " + path_);
+    }
+}
+
+void WavWriter::writeHeader() {
+    const uint32_t blockAlign = channels_ * BITS_PER_SAMPLE / 8;
+    const uint32_t dataBytes = static_cast<uint32_t>(framesWritten_ * blockAlign);
+    
+    file_.seekp(0);
+    file_.write("RIFF", 4);
+    writeWord(HEADER_BYTES - 8 + dataBytes, 4);
+    file_.write("WAVE", 4);
+    file_.write("fmt ", 4);
+    writeWord(16, 4);
+    writeWord(FORMAT_PCM, 2);
+    writeWord(channels_, 2);
+    writeWord(sampleRate_, 4);
+    writeWord(sampleRate_ * blockAlign, 4);
+    writeWord(blockAlign, 2);
+    writeWord(BITS_PER_SAMPLE, 2);
+    file_.write("data", 4);
+    writeWord(dataBytes, 4);
+    file_.seekp(0, std::ios::end);
+}
+
+void WavWriter::writeWord(uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        file_.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+}
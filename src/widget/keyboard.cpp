@@ -20,8 +20,10 @@
 #include <QPainter>
 #include <QMouseEvent>
 #include <QResizeEvent>
+#include <QPaintEvent>
 #include <QApplication>
 #include <algorithm>
+#include <array>
 
 // Piano key colors with glossy gradients
 QColor KeyboardWidget::getWhiteKeyColor() const
@@ -60,6 +62,8 @@ QColor KeyboardWidget::getKeyTextColor() const
  */
 KeyboardWidget::KeyboardWidget(QWidget *parent)
     : QWidget(parent)
+    , cacheValid_(false)
+    , labelFont_("Arial", 7)
     , alignment_(Qt::AlignLeft)
     , currentOctave_(2)
 {
@@ -75,7 +79,7 @@ KeyboardWidget::KeyboardWidget(QWidget *parent)
  * @brief Set the currently active notes
  * 
  * Updates the visual state of the keyboard to show which notes are currently
- * being played. This affects the color and highlighting of the corresponding keys.
+ * being played. Only the keys whose state changed are repainted.
  * 
  * @param notes Set of MIDI note numbers that are currently active
  */
@@ -83,7 +87,7 @@ void KeyboardWidget::setActiveNotes(const std::set<int>& notes)
 {
     if (activeNotes_ != notes) {
         activeNotes_ = notes;
-        update();
+        updateActiveStates();
     }
 }
 
@@ -129,7 +133,6 @@ void KeyboardWidget::setCurrentOctave(int octave)
     currentOctave_ = qBound(MIN_OCTAVE, octave, MAX_OCTAVE);
     pressedNotes_.clear();
     setupKeys();
-    update();
 }
 
 /**
@@ -137,7 +140,8 @@ void KeyboardWidget::setCurrentOctave(int octave)
  * 
  * Calculates and positions all the keys on the keyboard based on the current
  * octave and widget size. This includes determining key sizes, positions,
- * and the proper layout for white and black keys.
+ * and the proper layout for white and black keys. The cached keyboard is
+ * rebuilt on the next paint.
  */
 void KeyboardWidget::setupKeys()
 {
@@ -165,6 +169,9 @@ void KeyboardWidget::setupKeys()
             key.note = note;
             key.isBlack = octavePattern[i];
             key.isActive = false;
+            if (i == 0) {
+                key.label = QString("C%1").arg(currentOctave_ + octave);
+            }
             
             if (key.isBlack) {
                 key.rect = QRect(x - blackKeyWidth/2, 0, blackKeyWidth, BLACK_KEY_HEIGHT);
@@ -184,6 +191,8 @@ void KeyboardWidget::setupKeys()
         }
     }
     
+    cacheValid_ = false;
+    update();
     updateActiveStates();
 }
 
@@ -199,75 +208,150 @@ void KeyboardWidget::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
     setupKeys();
-    update();
+}
+
+/**
+ * @brief Handle widget state change events
+ * 
+ * A palette or style change alters the theme colors, so the cached
+ * keyboard is rebuilt on the next paint.
+ * 
+ * @param event The change event
+ */
+void KeyboardWidget::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange) {
+        cacheValid_ = false;
+        update();
+    }
 }
 
 /**
  * @brief Update the active state of all keys
  * 
  * Updates the visual state of each key based on whether it corresponds to
- * an active note or is currently being pressed by the user.
+ * an active note or is currently being pressed by the user, and schedules a
+ * repaint of just the keys that changed. The displayed keys are consecutive
+ * notes, so only the part of each note set inside the displayed range is
+ * visited.
  */
 void KeyboardWidget::updateActiveStates()
 {
-    for (auto& key : keys_) {
-        key.isActive = (activeNotes_.find(key.note) != activeNotes_.end()) || 
-                      (pressedNotes_.find(key.note) != pressedNotes_.end());
+    constexpr int KEYS_DISPLAYED = OCTAVES_DISPLAYED * KEYS_PER_OCTAVE;
+    if (keys_.empty()) {
+        return;
+    }
+    
+    const int firstNote = keys_.front().note;
+    std::array<bool, KEYS_DISPLAYED> active{};
+    auto markNotes = [&](const std::set<int>& notes) {
+        for (auto it = notes.lower_bound(firstNote); it != notes.end() && *it < firstNote + KEYS_DISPLAYED; ++it) {
+            active[*it - firstNote] = true;
+        }
+    };
+    markNotes(activeNotes_);
+    markNotes(pressedNotes_);
+    
+    for (size_t i = 0; i < keys_.size(); i++) {
+        KeyInfo& key = keys_[i];
+        if (key.isActive != active[i]) {
+            key.isActive = active[i];
+            // The pen straddles the key outline
+            update(key.rect.adjusted(-1, -1, 1, 1));
+        }
     }
 }
 
-
 /**
- * @brief Handle widget paint events
+ * @brief Draw the keyboard with every key released into keyboardCache_
  * 
- * Renders the keyboard widget, including all keys, their colors, and
- * any visual feedback for active notes. Also draws note labels on white keys.
- * 
- * @param event The paint event
+ * Rendered at the widget's device pixel ratio so blitting it is a plain
+ * copy on high-DPI screens too.
  */
-void KeyboardWidget::paintEvent(QPaintEvent *event)
+void KeyboardWidget::renderKeyboardCache()
 {
-    Q_UNUSED(event)
+    const qreal ratio = devicePixelRatioF();
+    keyboardCache_ = QPixmap(size() * ratio);
+    keyboardCache_.setDevicePixelRatio(ratio);
+    keyboardCache_.fill(Qt::transparent);
     
-    QPainter painter(this);
+    QPainter painter(&keyboardCache_);
     painter.setRenderHint(QPainter::Antialiasing);
     
-    updateActiveStates();
-    
     for (const auto& key : keys_) {
         if (!key.isBlack) {
-            drawKey(painter, key);
+            drawKey(painter, key, false);
         }
     }
-    
     for (const auto& key : keys_) {
         if (key.isBlack) {
-            drawKey(painter, key);
+            drawKey(painter, key, false);
         }
     }
-    painter.setPen(getKeyTextColor());
-    painter.setFont(QFont("Arial", 7));
+    for (const auto& key : keys_) {
+        drawLabel(painter, key);
+    }
     
-    QString noteNames[] = {"C", "D", "E", "F", "G", "A", "B"};
-    int noteIndex = 0;
-    int currentOctaveForLabel = currentOctave_;
+    cacheValid_ = true;
+}
+
+
+/**
+ * @brief Handle widget paint events
+ * 
+ * The released keyboard is copied from the cache for the area being
+ * repainted, and the active keys in that area are drawn over it. Black keys
+ * are drawn after white ones, as in the cache, so an active white key never
+ * covers the black keys next to it.
+ * 
+ * @param event The paint event
+ */
+void KeyboardWidget::paintEvent(QPaintEvent *event)
+{
+    const qreal ratio = devicePixelRatioF();
+    if (!cacheValid_ || keyboardCache_.devicePixelRatio() != ratio) {
+        renderKeyboardCache();
+    }
+    
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+    painter.drawPixmap(QRectF(dirty), keyboardCache_,
+                       QRectF(QPointF(dirty.topLeft()) * ratio, QSizeF(dirty.size()) * ratio));
     
+    painter.setRenderHint(QPainter::Antialiasing);
+    QRegion pressedWhiteKeys;
     for (const auto& key : keys_) {
-        if (!key.isBlack) {
-            if (noteIndex % 7 == 0) {
-                QString noteText = QString("C%1").arg(currentOctaveForLabel);
-                QRect textRect = key.rect.adjusted(0, KEY_HEIGHT - 15, 0, -5);
-                painter.drawText(textRect, Qt::AlignCenter, noteText);
-            }
-            
-            noteIndex++;
-            if (noteIndex % 7 == 0) {
-                currentOctaveForLabel++;
-            }
+        if (!key.isBlack && key.isActive && key.rect.intersects(dirty)) {
+            drawKey(painter, key, true);
+            drawLabel(painter, key);
+            pressedWhiteKeys += key.rect;
+        }
+    }
+    for (const auto& key : keys_) {
+        if (key.isBlack && key.rect.intersects(dirty) && (key.isActive || pressedWhiteKeys.intersects(key.rect))) {
+            drawKey(painter, key, key.isActive);
         }
     }
 }
 
+/**
+ * @brief Draw the octave label of a key, if it has one
+ * 
+ * @param painter The QPainter object for drawing
+ * @param key The key whose label to draw
+ */
+void KeyboardWidget::drawLabel(QPainter& painter, const KeyInfo& key)
+{
+    if (key.label.isEmpty()) {
+        return;
+    }
+    painter.setPen(getKeyTextColor());
+    painter.setFont(labelFont_);
+    QRect textRect = key.rect.adjusted(0, KEY_HEIGHT - 15, 0, -5);
+    painter.drawText(textRect, Qt::AlignCenter, key.label);
+}
+
 /**
  * @brief Draw a single key on the keyboard
  * 
@@ -276,12 +360,13 @@ void KeyboardWidget::paintEvent(QPaintEvent *event)
  * 
  * @param painter The QPainter object for drawing
  * @param key The key information to draw
+ * @param active Whether to draw the key pressed
  */
-void KeyboardWidget::drawKey(QPainter& painter, const KeyInfo& key)
+void KeyboardWidget::drawKey(QPainter& painter, const KeyInfo& key, bool active)
 {
     QRect keyRect = key.rect;
     
-    if (key.isActive) {
+    if (active) {
         // Active key - use theme color with glossy effect
         QLinearGradient activeGradient(keyRect.topLeft(), keyRect.bottomLeft());
         QColor activeColor = getActiveKeyColor();
@@ -366,7 +451,6 @@ void KeyboardWidget::mousePressEvent(QMouseEvent *event)
     if (key) {
         pressedNotes_.insert(key->note);
         updateActiveStates();
-        update();
         emit keyPressed(key->note);
     }
 }
@@ -385,7 +469,6 @@ void KeyboardWidget::mouseReleaseEvent(QMouseEvent *event)
     if (key) {
         pressedNotes_.erase(key->note);
         updateActiveStates();
-        update();
         emit keyReleased(key->note);
     }
 }
@@ -410,7 +493,6 @@ void KeyboardWidget::mouseMoveEvent(QMouseEvent *event)
                 }
                 pressedNotes_.clear();
                 updateActiveStates();
-                update();
             }
         }
     }
@@ -17,8 +17,10 @@
  */
 
 #include "widget/operator.hpp"
+#include "fm/algorithms.hpp"
 #include <QPainter>
 #include <QPainterPath>
+#include <QPicture>
 #include <QFontMetrics>
 #include <QDebug>
 #include <cmath>
@@ -28,6 +30,7 @@ OperatorGraphWidget::OperatorGraphWidget(QWidget *parent)
     , currentAlgorithm_(0)
     , operatorSize_(40, 40)
     , gridSpacing_(60, 60)
+    , diagramRatio_(0.0)
     , themeManager_(ThemeManager::getInstance())
 {
     setMinimumSize(200, 150);
@@ -53,7 +56,7 @@ OperatorGraphWidget::~OperatorGraphWidget()
 
 void OperatorGraphWidget::setAlgorithm(int algorithm)
 {
-    if (algorithm >= 0 && algorithm < 32) {
+    if (algorithm >= 0 && algorithm < 32 && algorithm != currentAlgorithm_) {
         currentAlgorithm_ = algorithm;
         update();
     }
@@ -64,7 +67,6 @@ void OperatorGraphWidget::paintEvent(QPaintEvent *event)
     Q_UNUSED(event)
     
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
     
     // Set background
     painter.fillRect(rect(), themeManager_.getColor("base"));
@@ -73,7 +75,73 @@ void OperatorGraphWidget::paintEvent(QPaintEvent *event)
         return;
     }
     
-    const OperatorGraphWidget::AlgorithmLayout& layout = algorithms_[currentAlgorithm_];
+    // Diagrams depend on the widget size, so a resize or a move to a screen
+    // with another pixel ratio renders them again
+    const qreal ratio = devicePixelRatioF();
+    if (diagramSize_ != size() || diagramRatio_ != ratio) {
+        invalidateDiagrams();
+        diagramSize_ = size();
+        diagramRatio_ = ratio;
+    }
+    
+    Diagram& diagram = diagrams_[currentAlgorithm_];
+    if (diagram.pixmap.isNull()) {
+        diagram = renderDiagram(currentAlgorithm_);
+    }
+    painter.drawPixmap(diagram.origin, diagram.pixmap);
+}
+
+/**
+ * @brief Render one algorithm's diagram into a pixmap
+ * 
+ * The drawing is recorded into a QPicture first to find the area it covers,
+ * so the pixmap holds just the diagram on the background color rather than
+ * the whole widget, and caching all 32 stays small.
+ */
+OperatorGraphWidget::Diagram OperatorGraphWidget::renderDiagram(int algorithm)
+{
+    QPicture picture;
+    {
+        QPainter recorder(&picture);
+        drawAlgorithm(recorder, algorithm);
+    }
+    
+    // Pens are centred on the recorded outlines
+    const int margin = qMax(CONNECTION_LINE_WIDTH, FEEDBACK_LINE_WIDTH) + 1;
+    const QRect bounds = picture.boundingRect().adjusted(-margin, -margin, margin, margin) & rect();
+    
+    Diagram diagram;
+    diagram.origin = bounds.topLeft();
+    if (bounds.isEmpty()) {
+        // Keep a non-null pixmap so an empty diagram is not rendered again
+        diagram.pixmap = QPixmap(1, 1);
+        diagram.pixmap.fill(Qt::transparent);
+        return diagram;
+    }
+    
+    const qreal ratio = devicePixelRatioF();
+    diagram.pixmap = QPixmap(bounds.size() * ratio);
+    diagram.pixmap.setDevicePixelRatio(ratio);
+    diagram.pixmap.fill(themeManager_.getColor("base"));
+    
+    QPainter painter(&diagram.pixmap);
+    painter.translate(-bounds.topLeft());
+    drawAlgorithm(painter, algorithm);
+    return diagram;
+}
+
+void OperatorGraphWidget::invalidateDiagrams()
+{
+    for (Diagram& diagram : diagrams_) {
+        diagram = Diagram();
+    }
+}
+
+void OperatorGraphWidget::drawAlgorithm(QPainter& painter, int algorithm)
+{
+    painter.setRenderHint(QPainter::Antialiasing);
+    
+    const OperatorGraphWidget::AlgorithmLayout& layout = algorithms_[algorithm];
     
     // Calculate optimal sizing - make it more compact
     QSize availableSize = size() - QSize(GRID_PADDING * 2, GRID_PADDING * 2);
@@ -112,6 +180,18 @@ void OperatorGraphWidget::resizeEvent(QResizeEvent *event)
     update();
 }
 
+void OperatorGraphWidget::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    // The diagrams are drawn in theme colors
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange) {
+        connectionPen_.setColor(themeManager_.getColor("text"));
+        feedbackPen_.setColor(themeManager_.getColor("mauve"));
+        invalidateDiagrams();
+        update();
+    }
+}
+
 void OperatorGraphWidget::initializeAlgorithms()
 {
     for (int i = 0; i < 32; i++) {
@@ -121,200 +201,57 @@ void OperatorGraphWidget::initializeAlgorithms()
 
 OperatorGraphWidget::AlgorithmLayout OperatorGraphWidget::createAlgorithmLayout(int algorithm)
 {
+    // Layouts are derived from the same routing table the render kernels use
+    const toybasic::AlgorithmTopology& topology = toybasic::ALGORITHMS[algorithm];
+    
     AlgorithmLayout layout;
     layout.algorithmNumber = algorithm;
     
-    switch (algorithm) {
-        case 0: // Algorithm 1: 6→5→4→3→2→1 with feedback on 6
-            layout.rows = 4;
-            layout.cols = 2;
-            layout.operators = {{
-                {1, QPoint(0, 3), true, false, false, QColor(), QColor()},   // Carrier (bottom left)
-                {2, QPoint(0, 2), false, true, false, QColor(), QColor()},   // Modulator (left middle)
-                {3, QPoint(1, 3), true, false, false, QColor(), QColor()},   // Carrier (bottom right)
-                {4, QPoint(1, 2), false, true, false, QColor(), QColor()},   // Modulator (right middle)
-                {5, QPoint(0, 1), false, true, false, QColor(), QColor()},   // Modulator (left upper)
-                {6, QPoint(1, 1), false, true, true, QColor(), QColor()}     // Modulator with feedback (right upper)
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, false, true},  // 6→5 (diagonal)
-                {5, 4, QPoint(), QPoint(), false, false, true, false},  // 5→4 (vertical)
-                {2, 1, QPoint(), QPoint(), false, true, false, false},  // 2→1 (horizontal)
-                {4, 3, QPoint(), QPoint(), false, false, true, false},  // 4→3 (vertical)
-                {6, 6, QPoint(), QPoint(), true, false, false, false}   // 6 feedback
-            };
-            break;
-            
-        case 1: // Algorithm 2: Similar to 1 but different layout
-            layout.rows = 4;
-            layout.cols = 2;
-            layout.operators = {{
-                {1, QPoint(0, 3), true, false, false, QColor(), QColor()},
-                {2, QPoint(0, 2), false, true, false, QColor(), QColor()},
-                {3, QPoint(1, 3), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {6, QPoint(0, 0), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 2, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {4, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 2: // Algorithm 3: 3 rows, 2 columns
-            layout.rows = 3;
-            layout.cols = 2;
-            layout.operators = {{
-                {1, QPoint(0, 2), true, false, false, QColor(), QColor()},
-                {2, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {3, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 0), false, true, false, QColor(), QColor()},
-                {6, QPoint(1, 0), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 2, QPoint(), QPoint(), false, false, true, false},
-                {6, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 3, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 3: // Algorithm 4: 3 rows, 2 columns
-            layout.rows = 3;
-            layout.cols = 2;
-            layout.operators = {{
-                {1, QPoint(0, 2), true, false, false, QColor(), QColor()},
-                {2, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {3, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 0), false, true, false, QColor(), QColor()},
-                {6, QPoint(1, 0), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 2, QPoint(), QPoint(), false, false, true, false},
-                {6, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 3, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 4: // Algorithm 5: 2 rows, 3 columns
-            layout.rows = 2;
-            layout.cols = 3;
-            layout.operators = {{
-                {1, QPoint(0, 1), true, false, false, QColor(), QColor()},
-                {2, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {3, QPoint(2, 1), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 0), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 0), false, true, false, QColor(), QColor()},
-                {6, QPoint(2, 0), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 2, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 5: // Algorithm 6: 2 rows, 3 columns
-            layout.rows = 2;
-            layout.cols = 3;
-            layout.operators = {{
-                {1, QPoint(0, 1), true, false, false, QColor(), QColor()},
-                {2, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {3, QPoint(2, 1), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 0), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 0), false, true, false, QColor(), QColor()},
-                {6, QPoint(2, 0), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 2, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 6: // Algorithm 7: 3 rows, 3 columns
-            layout.rows = 3;
-            layout.cols = 3;
-            layout.operators = {{
-                {1, QPoint(0, 2), true, false, false, QColor(), QColor()},
-                {2, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {3, QPoint(2, 2), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {6, QPoint(2, 1), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 2, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        case 7: // Algorithm 8: 3 rows, 3 columns
-            layout.rows = 3;
-            layout.cols = 3;
-            layout.operators = {{
-                {1, QPoint(0, 2), true, false, false, QColor(), QColor()},
-                {2, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {3, QPoint(2, 2), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {6, QPoint(2, 1), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 2, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
-            
-        // For the remaining algorithms (8-31), I'll create a simplified pattern
-        // In a real implementation, each would have its exact layout from the image
-        default:
-            // Default layout for remaining algorithms
-            layout.rows = 3;
-            layout.cols = 3;
-            layout.operators = {{
-                {1, QPoint(0, 2), true, false, false, QColor(), QColor()},
-                {2, QPoint(1, 2), false, true, false, QColor(), QColor()},
-                {3, QPoint(2, 2), false, true, false, QColor(), QColor()},
-                {4, QPoint(1, 1), false, true, false, QColor(), QColor()},
-                {5, QPoint(0, 1), false, true, false, QColor(), QColor()},
-                {6, QPoint(2, 1), false, true, true, QColor(), QColor()}
-            }};
-            layout.connections = {
-                {6, 5, QPoint(), QPoint(), false, false, true, false},
-                {5, 4, QPoint(), QPoint(), false, false, true, false},
-                {4, 2, QPoint(), QPoint(), false, false, true, false},
-                {2, 1, QPoint(), QPoint(), false, false, true, false},
-                {6, 3, QPoint(), QPoint(), false, false, true, false},
-                {6, 6, QPoint(), QPoint(), true, false, false, false}
-            };
-            break;
+    // Depth is the longest modulation path down to an operator that feeds
+    // nothing, so carriers sit on the bottom row and modulators above them
+    std::array<int, 6> depth{};
+    for (int pass = 0; pass < 6; pass++) {
+        for (int from = 0; from < 6; from++) {
+            for (int to = 0; to < 6; to++) {
+                if (topology.modulates(from, to)) {
+                    depth[from] = qMax(depth[from], depth[to] + 1);
+                }
+            }
+        }
+    }
+    
+    int maxDepth = 0;
+    for (int op = 0; op < 6; op++) {
+        maxDepth = qMax(maxDepth, depth[op]);
+    }
+    
+    std::array<int, 6> rowCount{};
+    layout.rows = maxDepth + 1;
+    layout.cols = 1;
+    for (int op = 0; op < 6; op++) {
+        int row = maxDepth - depth[op];
+        int col = rowCount[row]++;
+        layout.cols = qMax(layout.cols, rowCount[row]);
+        layout.operators[op] = {op + 1, QPoint(col, row), topology.isCarrier(op), topology.isModulator(op),
+                                op == topology.feedback, QColor(), QColor()};
+    }
+    
+    for (int to = 0; to < 6; to++) {
+        for (int8_t from : topology.inputs[to]) {
+            if (from == toybasic::AlgorithmTopology::NONE) {
+                break;
+            }
+            QPoint fromGrid = layout.operators[from].position;
+            QPoint toGrid = layout.operators[to].position;
+            bool vertical = fromGrid.x() == toGrid.x();
+            bool horizontal = fromGrid.y() == toGrid.y();
+            layout.connections.push_back({from + 1, to + 1, QPoint(), QPoint(), false,
+                                          horizontal, vertical, !horizontal && !vertical});
+        }
+    }
+    if (topology.feedback != toybasic::AlgorithmTopology::NONE) {
+        layout.connections.push_back({topology.feedback + 1, topology.feedback + 1, QPoint(), QPoint(), true,
+                                      false, false, false});
     }
     
     // Calculate positions for all operators
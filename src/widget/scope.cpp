@@ -0,0 +1,283 @@
+/*
+ * SortaSound - Advanced FM Synthesizer
+ * Copyright (C) 2024  Paige Thompson <paige@paige.bio>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "widget/scope.hpp"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructor for ScopeWidget
+ * 
+ * @param tap The tap to display; only used while the widget is shown
+ * @param parent Parent widget
+ */
+ScopeWidget::ScopeWidget(toybasic::ScopeTap& tap, QWidget *parent)
+    : QWidget(parent)
+    , tap_(tap)
+    , refreshTimer_(new QTimer(this))
+    , lastSequence_(0)
+    , sampleRate_(0)
+    , waveform_(SCOPE_FRAMES, 0.0f)
+    , spectrum_(FFT_SIZE / 2 + 1, MIN_DB)
+    , operatorLevels_{}
+    , fftWindow_(FFT_SIZE)
+    , twiddles_(FFT_SIZE / 2)
+    , fftBuffer_(FFT_SIZE)
+    , themeManager_(ThemeManager::getInstance())
+{
+    setMinimumHeight(140);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    
+    const double pi = std::acos(-1.0);
+    for (size_t i = 0; i < FFT_SIZE; i++) {
+        fftWindow_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * i / (FFT_SIZE - 1)));
+    }
+    for (size_t i = 0; i < FFT_SIZE / 2; i++) {
+        twiddles_[i] = std::polar(1.0f, static_cast<float>(-2.0 * pi * i / FFT_SIZE));
+    }
+    
+    refreshTimer_->setInterval(REFRESH_INTERVAL_MS);
+    connect(refreshTimer_, &QTimer::timeout, this, &ScopeWidget::pollTap);
+}
+
+ScopeWidget::~ScopeWidget()
+{
+    // The tap's owner may already be gone when child widgets are deleted, so
+    // it is left as it is; hideEvent() has normally disabled it by now
+}
+
+/**
+ * @brief Start recording and polling when the widget becomes visible
+ */
+void ScopeWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    tap_.setEnabled(true);
+    refreshTimer_->start();
+}
+
+/**
+ * @brief Stop both while hidden, so the render thread does no extra work
+ */
+void ScopeWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    refreshTimer_->stop();
+    tap_.setEnabled(false);
+}
+
+void ScopeWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    decimate();
+}
+
+void ScopeWidget::pollTap()
+{
+    const toybasic::ScopeSnapshot* snapshot = tap_.acquire();
+    if (!snapshot || snapshot->sequence == lastSequence_) {
+        return;
+    }
+    lastSequence_ = snapshot->sequence;
+    sampleRate_ = snapshot->sampleRate;
+    operatorLevels_ = snapshot->operatorLevels;
+    
+    // Trigger on the first rising zero crossing so a steady tone stands
+    // still; without one, show the most recent frames
+    const size_t frames = toybasic::ScopeSnapshot::FRAMES;
+    auto mono = [&](size_t frame) { return 0.5f * (snapshot->left[frame] + snapshot->right[frame]); };
+    size_t start = frames - SCOPE_FRAMES;
+    for (size_t frame = 1; frame <= frames - SCOPE_FRAMES; frame++) {
+        if (mono(frame - 1) < 0.0f && mono(frame) >= 0.0f) {
+            start = frame;
+            break;
+        }
+    }
+    for (size_t i = 0; i < SCOPE_FRAMES; i++) {
+        waveform_[i] = mono(start + i);
+    }
+    
+    computeSpectrum(*snapshot);
+    decimate();
+    update();
+}
+
+/**
+ * @brief Iterative radix-2 FFT of the Hann-windowed mono mix
+ * 
+ * Each bin is shown as its peak over recent snapshots, falling by
+ * PEAK_DECAY_DB per refresh, so short transients stay readable.
+ */
+void ScopeWidget::computeSpectrum(const toybasic::ScopeSnapshot& snapshot)
+{
+    float windowSum = 0.0f;
+    for (size_t i = 0; i < FFT_SIZE; i++) {
+        fftBuffer_[i] = {0.5f * (snapshot.left[i] + snapshot.right[i]) * fftWindow_[i], 0.0f};
+        windowSum += fftWindow_[i];
+    }
+    
+    for (size_t i = 1, j = 0; i < FFT_SIZE; i++) {
+        size_t bit = FFT_SIZE >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            std::swap(fftBuffer_[i], fftBuffer_[j]);
+        }
+    }
+    for (size_t length = 2; length <= FFT_SIZE; length <<= 1) {
+        const size_t half = length / 2;
+        const size_t stride = FFT_SIZE / length;
+        for (size_t block = 0; block < FFT_SIZE; block += length) {
+            for (size_t k = 0; k < half; k++) {
+                const std::complex<float> odd = fftBuffer_[block + k + half] * twiddles_[k * stride];
+                fftBuffer_[block + k + half] = fftBuffer_[block + k] - odd;
+                fftBuffer_[block + k] += odd;
+            }
+        }
+    }
+    
+    // A full-scale sine reads 0 dB
+    const float scale = 2.0f / windowSum;
+    for (size_t bin = 0; bin < spectrum_.size(); bin++) {
+        const float magnitude = std::abs(fftBuffer_[bin]) * scale;
+        const float db = magnitude > 0.0f ? std::max(MIN_DB, 20.0f * std::log10(magnitude)) : MIN_DB;
+        spectrum_[bin] = std::max(db, spectrum_[bin] - PEAK_DECAY_DB);
+    }
+}
+
+/**
+ * @brief Reduce the waveform and the spectrum to one value per pixel column
+ * 
+ * The waveform keeps the minimum and maximum of the frames behind each
+ * column, so peaks survive whatever the width. The spectrum is laid out on
+ * a logarithmic frequency axis from MIN_FREQUENCY to Nyquist and keeps the
+ * loudest bin behind each column.
+ */
+void ScopeWidget::decimate()
+{
+    const int waveformWidth = qMax(1, waveformRect().width());
+    waveformColumns_.resize(waveformWidth);
+    for (int column = 0; column < waveformWidth; column++) {
+        const size_t first = column * SCOPE_FRAMES / waveformWidth;
+        const size_t last = qMax(first + 1, (column + 1) * SCOPE_FRAMES / waveformWidth);
+        const auto [low, high] = std::minmax_element(waveform_.begin() + first, waveform_.begin() + last);
+        waveformColumns_[column] = {*low, *high};
+    }
+    
+    const int spectrumWidth = qMax(1, spectrumRect().width());
+    spectrumColumns_.assign(spectrumWidth, MIN_DB);
+    if (sampleRate_ <= 0) {
+        return;
+    }
+    const float nyquist = sampleRate_ / 2.0f;
+    const float binWidth = static_cast<float>(sampleRate_) / FFT_SIZE;
+    const float span = std::log(nyquist / MIN_FREQUENCY);
+    for (int column = 0; column < spectrumWidth; column++) {
+        const float low = MIN_FREQUENCY * std::exp(span * column / spectrumWidth);
+        const float high = MIN_FREQUENCY * std::exp(span * (column + 1) / spectrumWidth);
+        const size_t first = qMin(spectrum_.size() - 1, static_cast<size_t>(low / binWidth));
+        const size_t last = qMin(spectrum_.size(), qMax(first + 1, static_cast<size_t>(std::ceil(high / binWidth))));
+        spectrumColumns_[column] = *std::max_element(spectrum_.begin() + first, spectrum_.begin() + last);
+    }
+}
+
+QRect ScopeWidget::waveformRect() const
+{
+    const int width = (this->width() - LEVELS_WIDTH - SPACING * 2) / 2;
+    return QRect(0, 0, width, height());
+}
+
+QRect ScopeWidget::spectrumRect() const
+{
+    const QRect waveform = waveformRect();
+    return QRect(waveform.right() + 1 + SPACING, 0, waveform.width(), height());
+}
+
+QRect ScopeWidget::levelsRect() const
+{
+    return QRect(width() - LEVELS_WIDTH, 0, LEVELS_WIDTH, height());
+}
+
+/**
+ * @brief Draw the reduced columns; nothing here depends on the snapshot size
+ */
+void ScopeWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    
+    QPainter painter(this);
+    painter.fillRect(rect(), themeManager_.getColor("base"));
+    
+    const QColor panel = themeManager_.getColor("surface0");
+    const QColor grid = themeManager_.getColor("overlay0");
+    
+    // Waveform, full scale top to bottom
+    const QRect waveform = waveformRect();
+    painter.fillRect(waveform, panel);
+    painter.setPen(grid);
+    const int middle = waveform.center().y();
+    painter.drawLine(waveform.left(), middle, waveform.right(), middle);
+    painter.setPen(themeManager_.getColor("green"));
+    const float halfHeight = waveform.height() / 2.0f;
+    for (int column = 0; column < static_cast<int>(waveformColumns_.size()); column++) {
+        const auto [low, high] = waveformColumns_[column];
+        const int top = middle - qRound(std::clamp(high, -1.0f, 1.0f) * halfHeight);
+        const int bottom = middle - qRound(std::clamp(low, -1.0f, 1.0f) * halfHeight);
+        painter.drawLine(waveform.left() + column, top, waveform.left() + column, bottom);
+    }
+    
+    // Spectrum, MIN_DB at the bottom to MAX_DB at the top
+    const QRect spectrum = spectrumRect();
+    painter.fillRect(spectrum, panel);
+    painter.setPen(grid);
+    for (float db = MAX_DB - 24.0f; db > MIN_DB; db -= 24.0f) {
+        const int y = spectrum.top() + qRound((MAX_DB - db) / (MAX_DB - MIN_DB) * spectrum.height());
+        painter.drawLine(spectrum.left(), y, spectrum.right(), y);
+    }
+    painter.setPen(themeManager_.getColor("blue"));
+    for (int column = 0; column < static_cast<int>(spectrumColumns_.size()); column++) {
+        const float level = (spectrumColumns_[column] - MIN_DB) / (MAX_DB - MIN_DB);
+        if (level <= 0.0f) {
+            continue;
+        }
+        const int top = spectrum.bottom() - qRound(qMin(level, 1.0f) * spectrum.height());
+        painter.drawLine(spectrum.left() + column, spectrum.bottom(), spectrum.left() + column, top);
+    }
+    
+    // Operator levels, one bar per operator slot
+    const QRect levels = levelsRect();
+    painter.fillRect(levels, panel);
+    const int labelHeight = painter.fontMetrics().height();
+    const int barSlot = levels.width() / static_cast<int>(operatorLevels_.size());
+    const int barHeight = levels.height() - labelHeight - 4;
+    for (int op = 0; op < static_cast<int>(operatorLevels_.size()); op++) {
+        const int x = levels.left() + op * barSlot + 2;
+        const int barLength = qRound(std::clamp(operatorLevels_[op], 0.0f, 1.0f) * barHeight);
+        painter.fillRect(x, levels.top() + 2 + barHeight - barLength, barSlot - 4, barLength, themeManager_.getColor("mauve"));
+        painter.setPen(themeManager_.getColor("text"));
+        painter.drawText(QRect(x, levels.bottom() - labelHeight, barSlot - 4, labelHeight),
+                         Qt::AlignCenter, QString::number(op + 1));
+    }
+}
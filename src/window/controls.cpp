@@ -47,7 +47,7 @@ void MainWindow::onVolumeChanged(int value)
 void MainWindow::onPresetChanged(int index)
 {
     activeNotes_.clear();
-    keyboardWidget_->setActiveNotes(activeNotes_);
+    showActiveNotes();
     
     if (auto* synth = getCurrentSynthesizer()) {
         presetManager_->applyPreset(*synth, currentChannel_, index);
@@ -17,6 +17,7 @@
  */
 
 #include "window/main.hpp"
+#include <QMessageBox>
 
 /**
  * @brief Setup connections for the internals tab controls
@@ -52,6 +53,31 @@ void MainWindow::setupInternalsTabConnections()
         }
     });
     
+    connect(bufferSizeCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        audioOutput_->setBufferFrames(bufferSizeCombo_->itemData(index).toInt());
+        outputFormatLabel_->setText(toybasic::sampleFormatName(audioOutput_->getSampleFormat()));
+    });
+    
+    connect(ditherCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        audioOutput_->setDither(ditherCombo_->itemData(index).toBool());
+    });
+    
+    connect(dacStageCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        audioOutput_->setDacEmulation(dacStageCombo_->itemData(index).toBool());
+    });
+    
+    connect(oscillatorModeCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        if (auto* synth = getCurrentSynthesizer()) {
+            synth->setOscillatorMode(static_cast<toybasic::OscillatorMode>(oscillatorModeCombo_->itemData(index).toInt()));
+        }
+    });
+    
+    connect(oversamplingCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        if (auto* synth = getCurrentSynthesizer()) {
+            synth->setOversampling(oversamplingCombo_->itemData(index).toInt());
+        }
+    });
+    
     connect(midiA4NoteSpinBox_, QOverload<int>::of(&QSpinBox::valueChanged), [this](int value) {
         if (auto* synth = getCurrentSynthesizer()) {
             synth->setMidiA4Note(value);
@@ -70,6 +96,21 @@ void MainWindow::setupInternalsTabConnections()
         }
     });
     
+    connect(midiInputCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        const int port = midiInputCombo_->itemData(index).toInt();
+        if (port < 0) {
+            midiInput_->close();
+            return;
+        }
+        try {
+            midiInput_->open(port);
+        }
+        catch (const std::exception& e) {
+            QMessageBox::warning(this, "MIDI Input", e.what());
+            midiInputCombo_->setCurrentIndex(0);
+        }
+    });
+    
     connect(maxVoicesSpinBox_, QOverload<int>::of(&QSpinBox::valueChanged), [this](int value) {
         if (auto* synth = getCurrentSynthesizer()) {
             synth->setMaxVoices(value);
@@ -94,6 +135,12 @@ void MainWindow::setupInternalsTabConnections()
         }
     });
     
+    connect(stealPolicyCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        if (auto* synth = getCurrentSynthesizer()) {
+            synth->setVoiceStealPolicy(static_cast<toybasic::VoiceStealPolicy>(stealPolicyCombo_->itemData(index).toInt()));
+        }
+    });
+    
     connect(minEnvTimeSpinBox_, QOverload<double>::of(&QDoubleSpinBox::valueChanged), [this](double value) {
         if (auto* synth = getCurrentSynthesizer()) {
             synth->setMinEnvelopeTime(value);
@@ -30,8 +30,9 @@
  * @brief Constructor for MainWindow
  * 
  * Creates the main application window with all UI components, synthesizer
- * instances, and keyboard mapping. Initializes the first synthesizer
- * and starts its audio thread.
+ * instances, and keyboard mapping. Every synthesizer is mixed by one
+ * FMSynthesizerManager into a single audio output, which is started once
+ * the first synthesizer is registered.
  * 
  * @param parent Parent widget
  */
@@ -41,9 +42,11 @@ MainWindow::MainWindow(QWidget *parent)
     , mainLayout_(nullptr)
     , controlsLayout_(nullptr)
     , currentSynthesizerIndex_(0)
+    , synthManager_(std::make_unique<toybasic::FMSynthesizerManager>())
     , presetManager_(std::make_unique<toybasic::PresetManager>())
     , keyboardWidget_(nullptr)
     , operatorGraphWidget_(nullptr)
+    , scopeWidget_(nullptr)
     , octaveGroup_(nullptr)
     , octaveSpinBox_(nullptr)
     , octaveLabel_(nullptr)
@@ -65,13 +68,21 @@ MainWindow::MainWindow(QWidget *parent)
     , audioMaxSpinBox_(nullptr)
     , audioMinSpinBox_(nullptr)
     , audioScaleSpinBox_(nullptr)
+    , bufferSizeCombo_(nullptr)
+    , outputFormatLabel_(nullptr)
+    , ditherCombo_(nullptr)
+    , dacStageCombo_(nullptr)
+    , oscillatorModeCombo_(nullptr)
+    , oversamplingCombo_(nullptr)
     , midiA4NoteSpinBox_(nullptr)
     , midiA4FreqSpinBox_(nullptr)
     , midiNotesSpinBox_(nullptr)
+    , midiInputCombo_(nullptr)
     , maxVoicesSpinBox_(nullptr)
     , maxOpsSpinBox_(nullptr)
     , maxChannelsSpinBox_(nullptr)
     , maxAlgsSpinBox_(nullptr)
+    , stealPolicyCombo_(nullptr)
     , minEnvTimeSpinBox_(nullptr)
     , maxEnvTimeSpinBox_(nullptr)
     , minVolumeSpinBox_(nullptr)
@@ -85,26 +96,63 @@ MainWindow::MainWindow(QWidget *parent)
     , channelGroup_(nullptr)
     , channelCombo_(nullptr)
     , pitchBendReturnTimer_(nullptr)
+    , blockTimeLabel_(nullptr)
+    , dspLoadLabel_(nullptr)
+    , underrunsLabel_(nullptr)
+    , overrunsLabel_(nullptr)
+    , activeVoicesLabel_(nullptr)
+    , voiceStealsLabel_(nullptr)
+    , realtimeLabel_(nullptr)
+    , telemetryTimer_(nullptr)
+    , midiNotesTimer_(nullptr)
     , currentChannel_(0)
 {
+    audioOutput_ = std::make_unique<toybasic::QtAudioOutput>(*synthManager_, toybasic::Constants::DEFAULT_SAMPLE_RATE,
+                                                             &synthManager_->getTelemetry());
+    
     setupUI();
     setupKeyboardMapping();
     
-    synthesizers_.push_back(std::make_unique<toybasic::FMSynthesizer>());
-    synthesizers_[0]->startAudioThread();
+    synthesizers_.push_back(std::make_shared<toybasic::FMSynthesizer>());
+    synthManager_->addSynthesizer(synthesizers_[0]);
+    /* the window has one synthesizer, so MIDI plays what the computer keyboard plays */
+    midiInput_ = std::make_unique<toybasic::MidiInput>(*getCurrentSynthesizer());
+    
+    midiNotesTimer_ = new QTimer(this);
+    midiNotesTimer_->setInterval(MIDI_NOTES_INTERVAL_MS);
+    connect(midiNotesTimer_, &QTimer::timeout, this, &MainWindow::updateMidiNotes);
+    midiNotesTimer_->start();
+    
+    audioOutput_->start();
 }
 
 /**
  * @brief Destructor for MainWindow
  * 
- * Cleans up the main window by stopping all synthesizer audio threads
- * before the window is destroyed.
+ * Stops the audio output before the synthesizers it renders are destroyed.
  */
 MainWindow::~MainWindow()
 {
-    for (auto& synth : synthesizers_) {
-        synth->stopAudioThread();
-    }
+    audioOutput_->stop();
+}
+
+/**
+ * @brief Ask the OS to schedule the render threads in real time
+ * 
+ * The stream is stopped while the render workers promote themselves and
+ * the engine's memory is locked, then restarted; the audio thread promotes
+ * itself on its first block. What the OS refused is shown under Internals >
+ * Engine Telemetry, and refreshed with the telemetry.
+ * 
+ * @param config Priority, cores and memory locking to ask for
+ */
+void MainWindow::enableRealtimeMode(const toybasic::RealtimeConfig &config)
+{
+    audioOutput_->stop();
+    synthManager_->setRealtimeMode(config);
+    audioOutput_->start();
+    
+    realtimeLabel_->setText(QString::fromStdString(synthManager_->getRealtimeStatus().describe()));
 }
 
 
@@ -322,7 +370,7 @@ void MainWindow::noteOn(int note)
         if (auto* synth = getCurrentSynthesizer()) {
             synth->noteOn(note);
         }
-        keyboardWidget_->setActiveNotes(activeNotes_);
+        showActiveNotes();
     }
 }
 
@@ -342,7 +390,7 @@ void MainWindow::noteOff(int note)
         if (auto* synth = getCurrentSynthesizer()) {
             synth->noteOff(note);
         }
-        keyboardWidget_->setActiveNotes(activeNotes_);
+        showActiveNotes();
     }
 }
 
@@ -358,7 +406,36 @@ void MainWindow::allNotesOff()
     if (auto* synth = getCurrentSynthesizer()) {
         synth->allNotesOff();
     }
-    keyboardWidget_->setActiveNotes(activeNotes_);
+    showActiveNotes();
+}
+
+/**
+ * @brief Draw the notes held on the computer keyboard, the mouse and MIDI
+ */
+void MainWindow::showActiveNotes()
+{
+    std::set<int> notes = activeNotes_;
+    for (int note = 0; note < toybasic::Constants::MIDI_NOTE_COUNT; note++) {
+        if (midiNotes_[note]) {
+            notes.insert(note);
+        }
+    }
+    keyboardWidget_->setActiveNotes(notes);
+}
+
+/**
+ * @brief Show the notes held on the MIDI port on the keyboard widget
+ * 
+ * Runs on midiNotesTimer_; MIDI notes play the synthesizer straight from the
+ * input thread, so the keyboard only follows them at the polling interval.
+ */
+void MainWindow::updateMidiNotes()
+{
+    const std::bitset<toybasic::Constants::MIDI_NOTE_COUNT> notes = midiInput_->getHeldNotes();
+    if (notes != midiNotes_) {
+        midiNotes_ = notes;
+        showActiveNotes();
+    }
 }
 
 
@@ -341,6 +341,45 @@ void MainWindow::setupUI()
     audioScaleSpinBox_->setDecimals(1);
     audioLayout->addRow("Audio Scale:", audioScaleSpinBox_);
     
+    bufferSizeCombo_ = new QComboBox(scrollContent);
+    int sampleRate = audioOutput_ ? audioOutput_->getSampleRate() : toybasic::Constants::DEFAULT_SAMPLE_RATE;
+    for (int frames : {64, 128, 256, 512, 1024}) {
+        bufferSizeCombo_->addItem(QString("%1 frames (%2 ms)").arg(frames).arg(1000.0 * frames / sampleRate, 0, 'f', 1), frames);
+    }
+    bufferSizeCombo_->setCurrentIndex(bufferSizeCombo_->findData(
+        audioOutput_ ? audioOutput_->getBufferFrames() : toybasic::Constants::DEFAULT_BUFFER_FRAMES));
+    audioLayout->addRow("Output Buffer:", bufferSizeCombo_);
+    
+    outputFormatLabel_ = new QLabel(audioOutput_ ? toybasic::sampleFormatName(audioOutput_->getSampleFormat()) : "None",
+                                    scrollContent);
+    audioLayout->addRow("Output Format:", outputFormatLabel_);
+    
+    ditherCombo_ = new QComboBox(scrollContent);
+    ditherCombo_->addItem("Off", false);
+    ditherCombo_->addItem("TPDF (16-bit output)", true);
+    ditherCombo_->setCurrentIndex(ditherCombo_->findData(audioOutput_ ? audioOutput_->getDither() : true));
+    audioLayout->addRow("Dither:", ditherCombo_);
+    
+    dacStageCombo_ = new QComboBox(scrollContent);
+    dacStageCombo_->addItem("Off", false);
+    dacStageCombo_->addItem("14-bit DAC Emulation", true);
+    dacStageCombo_->setCurrentIndex(dacStageCombo_->findData(audioOutput_ ? audioOutput_->getDacEmulation() : false));
+    audioLayout->addRow("DAC Stage:", dacStageCombo_);
+    
+    oscillatorModeCombo_ = new QComboBox(scrollContent);
+    oscillatorModeCombo_->addItem("Floating Point", static_cast<int>(toybasic::OscillatorMode::FLOATING_POINT));
+    oscillatorModeCombo_->addItem("Fixed Point (22-bit Table)", static_cast<int>(toybasic::OscillatorMode::FIXED_POINT));
+    oscillatorModeCombo_->setCurrentIndex(oscillatorModeCombo_->findData(static_cast<int>(
+        currentSynth ? currentSynth->getOscillatorMode() : toybasic::OscillatorMode::FLOATING_POINT)));
+    audioLayout->addRow("Oscillator:", oscillatorModeCombo_);
+    
+    oversamplingCombo_ = new QComboBox(scrollContent);
+    oversamplingCombo_->addItem("Off", 1);
+    oversamplingCombo_->addItem("2x (Operators Only)", 2);
+    oversamplingCombo_->addItem("4x (Operators Only)", 4);
+    oversamplingCombo_->setCurrentIndex(oversamplingCombo_->findData(currentSynth ? currentSynth->getOversampling() : 1));
+    audioLayout->addRow("Oversampling:", oversamplingCombo_);
+    
     scrollLayout->addWidget(audioGroup);
     
     QGroupBox *midiGroup = new QGroupBox("MIDI Parameters", scrollContent);
@@ -363,6 +402,17 @@ void MainWindow::setupUI()
     midiNotesSpinBox_->setValue(currentSynth ? currentSynth->getMidiNotesPerOctave() : toybasic::Constants::MIDI_NOTES_PER_OCTAVE);
     midiLayout->addRow("MIDI Notes Per Octave:", midiNotesSpinBox_);
     
+    midiInputCombo_ = new QComboBox(scrollContent);
+    midiInputCombo_->addItem("None", -1);
+    const std::vector<std::string> midiPorts = toybasic::MidiInput::listPorts();
+    for (size_t port = 0; port < midiPorts.size(); port++) {
+        midiInputCombo_->addItem(QString::fromStdString(midiPorts[port]), static_cast<int>(port));
+    }
+    midiLayout->addRow("MIDI Input:", midiInputCombo_);
+    QLabel *midiRoutingLabel = new QLabel("Every MIDI channel plays channel 1 of the synthesizer, like the computer keyboard; CC 7 sets its volume.", scrollContent);
+    midiRoutingLabel->setWordWrap(true);
+    midiLayout->addRow(midiRoutingLabel);
+    
     scrollLayout->addWidget(midiGroup);
     
     QGroupBox *limitsGroup = new QGroupBox("Synthesizer Limits", scrollContent);
@@ -371,8 +421,8 @@ void MainWindow::setupUI()
     limitsLayout->setFormAlignment(Qt::AlignLeft);
     limitsLayout->setLabelAlignment(Qt::AlignLeft);
     maxVoicesSpinBox_ = new QSpinBox(scrollContent);
-    maxVoicesSpinBox_->setRange(1, 64);
-    maxVoicesSpinBox_->setValue(currentSynth ? currentSynth->getMaxVoices() : toybasic::Constants::MAX_VOICES);
+    maxVoicesSpinBox_->setRange(toybasic::Constants::MIN_VOICES, toybasic::Constants::MAX_VOICES);
+    maxVoicesSpinBox_->setValue(currentSynth ? currentSynth->getMaxVoices() : toybasic::Constants::DEFAULT_VOICES);
     limitsLayout->addRow("Max Voices:", maxVoicesSpinBox_);
     
     maxOpsSpinBox_ = new QSpinBox(scrollContent);
@@ -389,6 +439,14 @@ void MainWindow::setupUI()
     maxAlgsSpinBox_->setValue(currentSynth ? currentSynth->getMaxAlgorithms() : toybasic::Constants::MAX_ALGORITHMS);
     limitsLayout->addRow("Max Algorithms:", maxAlgsSpinBox_);
     
+    stealPolicyCombo_ = new QComboBox(scrollContent);
+    stealPolicyCombo_->addItem("Released First", static_cast<int>(toybasic::VoiceStealPolicy::RELEASED_FIRST));
+    stealPolicyCombo_->addItem("Oldest", static_cast<int>(toybasic::VoiceStealPolicy::OLDEST));
+    stealPolicyCombo_->addItem("Quietest", static_cast<int>(toybasic::VoiceStealPolicy::QUIETEST));
+    stealPolicyCombo_->setCurrentIndex(stealPolicyCombo_->findData(static_cast<int>(
+        currentSynth ? currentSynth->getVoiceStealPolicy() : toybasic::VoiceStealPolicy::RELEASED_FIRST)));
+    limitsLayout->addRow("Voice Stealing:", stealPolicyCombo_);
+    
     scrollLayout->addWidget(limitsGroup);
     
     QGroupBox *envelopeGroup = new QGroupBox("Envelope Timing Limits", scrollContent);
@@ -440,6 +498,42 @@ void MainWindow::setupUI()
     
     scrollLayout->addWidget(volumeGroup);
     
+    QGroupBox *monitorGroup = new QGroupBox("Output Monitor", scrollContent);
+    QVBoxLayout *monitorLayout = new QVBoxLayout(monitorGroup);
+    scopeWidget_ = new ScopeWidget(synthManager_->getScopeTap(), scrollContent);
+    monitorLayout->addWidget(scopeWidget_);
+    
+    scrollLayout->addWidget(monitorGroup);
+    
+    QGroupBox *telemetryGroup = new QGroupBox("Engine Telemetry", scrollContent);
+    QFormLayout *telemetryLayout = new QFormLayout(telemetryGroup);
+    telemetryLayout->setFieldGrowthPolicy(QFormLayout::FieldsStayAtSizeHint);
+    telemetryLayout->setFormAlignment(Qt::AlignLeft);
+    telemetryLayout->setLabelAlignment(Qt::AlignLeft);
+    
+    blockTimeLabel_ = new QLabel("-", scrollContent);
+    telemetryLayout->addRow("Block Time (min/avg/p99/max):", blockTimeLabel_);
+    dspLoadLabel_ = new QLabel("-", scrollContent);
+    telemetryLayout->addRow("DSP Load (avg/peak):", dspLoadLabel_);
+    underrunsLabel_ = new QLabel("0", scrollContent);
+    telemetryLayout->addRow("Underruns:", underrunsLabel_);
+    overrunsLabel_ = new QLabel("0", scrollContent);
+    telemetryLayout->addRow("Overruns:", overrunsLabel_);
+    activeVoicesLabel_ = new QLabel("0", scrollContent);
+    telemetryLayout->addRow("Active Voices:", activeVoicesLabel_);
+    voiceStealsLabel_ = new QLabel("0", scrollContent);
+    telemetryLayout->addRow("Voice Steals:", voiceStealsLabel_);
+    realtimeLabel_ = new QLabel(QString::fromStdString(synthManager_->getRealtimeStatus().describe()), scrollContent);
+    realtimeLabel_->setWordWrap(true);
+    telemetryLayout->addRow("Real-Time Mode:", realtimeLabel_);
+    
+    scrollLayout->addWidget(telemetryGroup);
+    
+    telemetryTimer_ = new QTimer(this);
+    telemetryTimer_->setInterval(TELEMETRY_INTERVAL_MS);
+    connect(telemetryTimer_, &QTimer::timeout, this, &MainWindow::updateTelemetry);
+    telemetryTimer_->start();
+    
     scrollArea->setWidget(scrollContent);
     scrollArea->setWidgetResizable(true);
     internalsLayout->addWidget(scrollArea);
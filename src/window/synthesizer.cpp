@@ -35,6 +35,13 @@ void MainWindow::refreshInternalsTab()
     audioMaxSpinBox_->setValue(currentSynth->getAudioMaxValue());
     audioMinSpinBox_->setValue(currentSynth->getAudioMinValue());
     audioScaleSpinBox_->setValue(currentSynth->getAudioScale());
+    int bufferIndex = bufferSizeCombo_->findData(audioOutput_->getBufferFrames());
+    if (bufferIndex >= 0) {
+        bufferSizeCombo_->setCurrentIndex(bufferIndex);
+    }
+    outputFormatLabel_->setText(toybasic::sampleFormatName(audioOutput_->getSampleFormat()));
+    oscillatorModeCombo_->setCurrentIndex(oscillatorModeCombo_->findData(static_cast<int>(currentSynth->getOscillatorMode())));
+    oversamplingCombo_->setCurrentIndex(oversamplingCombo_->findData(currentSynth->getOversampling()));
     
     midiA4NoteSpinBox_->setValue(currentSynth->getMidiA4Note());
     midiA4FreqSpinBox_->setValue(currentSynth->getMidiA4Frequency());
@@ -44,6 +51,7 @@ void MainWindow::refreshInternalsTab()
     maxOpsSpinBox_->setValue(currentSynth->getMaxOperators());
     maxChannelsSpinBox_->setValue(currentSynth->getMaxChannels());
     maxAlgsSpinBox_->setValue(currentSynth->getMaxAlgorithms());
+    stealPolicyCombo_->setCurrentIndex(stealPolicyCombo_->findData(static_cast<int>(currentSynth->getVoiceStealPolicy())));
     
     minEnvTimeSpinBox_->setValue(currentSynth->getMinEnvelopeTime());
     maxEnvTimeSpinBox_->setValue(currentSynth->getMaxEnvelopeTime());
@@ -54,6 +62,36 @@ void MainWindow::refreshInternalsTab()
     maxAmplitudeSpinBox_->setValue(currentSynth->getMaxAmplitude());
 }
 
+/**
+ * @brief Show the engine statistics gathered since the last poll
+ * 
+ * Runs on telemetryTimer_. Block times and load describe the last polling
+ * interval; xrun and steal counts are totals since startup.
+ */
+void MainWindow::updateTelemetry()
+{
+    const toybasic::RenderStatistics stats = synthManager_->collectStatistics();
+    
+    if (stats.blocks > 0) {
+        blockTimeLabel_->setText(QString("%1 / %2 / %3 / %4 us")
+            .arg(stats.minBlockMicroseconds, 0, 'f', 0)
+            .arg(stats.averageBlockMicroseconds, 0, 'f', 0)
+            .arg(stats.p99BlockMicroseconds, 0, 'f', 0)
+            .arg(stats.maxBlockMicroseconds, 0, 'f', 0));
+        dspLoadLabel_->setText(QString("%1% / %2%")
+            .arg(stats.dspLoadPercent, 0, 'f', 1)
+            .arg(stats.peakDspLoadPercent, 0, 'f', 1));
+    } else {
+        blockTimeLabel_->setText("-");
+        dspLoadLabel_->setText("-");
+    }
+    underrunsLabel_->setText(QString::number(stats.underruns));
+    overrunsLabel_->setText(QString::number(stats.overruns));
+    activeVoicesLabel_->setText(QString::number(stats.activeVoices));
+    voiceStealsLabel_->setText(QString::number(stats.voiceSteals));
+    realtimeLabel_->setText(QString::fromStdString(synthManager_->getRealtimeStatus().describe()));
+}
+
 /**
  * @brief Get the currently active synthesizer
  * 